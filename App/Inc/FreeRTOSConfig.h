@@ -44,6 +44,7 @@
 /* Ensure stdint is only used by the compiler, and not the assembler. */
 #include <stdint.h>
 extern uint32_t SystemCoreClock;
+extern uint32_t SYS_RTOS_GetTimeUs(void);
 
 #define configUSE_PREEMPTION			1
 #define configUSE_IDLE_HOOK				0
@@ -52,9 +53,8 @@ extern uint32_t SystemCoreClock;
 #define configTICK_RATE_HZ				( ( TickType_t ) 1000U )
 #define configMAX_PRIORITIES			( 5 )
 #define configMINIMAL_STACK_SIZE		( ( unsigned short ) 128U )
-#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 7168 ) )
 #define configMAX_TASK_NAME_LEN			( 5 )
-#define configUSE_TRACE_FACILITY		0
+#define configUSE_TRACE_FACILITY		1
 #define configUSE_16_BIT_TICKS			0
 #define configIDLE_SHOULD_YIELD			1
 #define configUSE_MUTEXES				1
@@ -64,7 +64,11 @@ extern uint32_t SystemCoreClock;
 #define configUSE_MALLOC_FAILED_HOOK	0
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	1
-#define configGENERATE_RUN_TIME_STATS	0
+#define configGENERATE_RUN_TIME_STATS	1
+
+/* Memory allocation, every object is created static and no heap is linked */
+#define configSUPPORT_STATIC_ALLOCATION		1
+#define configSUPPORT_DYNAMIC_ALLOCATION	0
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 			0
@@ -80,6 +84,7 @@ extern uint32_t SystemCoreClock;
 #define configCOMMAND_INT_MAX_OUTPUT_SIZE		(128)
 #define configCOMMAND_INT_MAX_INPUT_SIZE		(128)
 #define configAPPLICATION_PROVIDES_cOutputBuffer 1
+#define configCOMMAND_INT_MAX_COMMANDS			(2)	/* Application commands go on a table */
 
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
@@ -90,10 +95,38 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend			1
 #define INCLUDE_vTaskDelayUntil			1
 #define INCLUDE_vTaskDelay				1
+#define INCLUDE_xTaskGetIdleTaskHandle	1
+
+/* Run time stats on the TIM3 microsecond time base, started before the
+scheduler by SYS_RTOS_ClockConfig. The POSIX port of host builds defines its
+own counter on process CPU time, the kernel reads the ALT form first so host
+builds count on the same microsecond time base. */
+#ifndef SYS_HOST
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()	SYS_RTOS_GetTimeUs()
+#else
+#define portALT_GET_RUN_TIME_COUNTER_VALUE( ulCountValue )	( ( ulCountValue ) = SYS_RTOS_GetTimeUs() )
+#endif
+
+/* Kernel events recorded on the RAM trace buffer, see sys_trace.h. Queue
+events include mutex and semaphore operations. */
+#include "sys_trace.h"
+#define traceTASK_SWITCHED_IN()						SYS_TRACE_Record( SYS_TRACE_TASK_IN, ( uint8_t ) pxCurrentTCB->uxTCBNumber, 0U )
+#define traceTASK_SWITCHED_OUT()					SYS_TRACE_Record( SYS_TRACE_TASK_OUT, ( uint8_t ) pxCurrentTCB->uxTCBNumber, 0U )
+#define traceQUEUE_SEND( pxQueue )					SYS_TRACE_Record( SYS_TRACE_QUEUE_SEND, 0U, ( uint16_t ) ( uintptr_t ) ( pxQueue ) )
+#define traceQUEUE_SEND_FROM_ISR( pxQueue )			SYS_TRACE_Record( SYS_TRACE_QUEUE_SEND, 0U, ( uint16_t ) ( uintptr_t ) ( pxQueue ) )
+#define traceQUEUE_RECEIVE( pxQueue )				SYS_TRACE_Record( SYS_TRACE_QUEUE_RECEIVE, 0U, ( uint16_t ) ( uintptr_t ) ( pxQueue ) )
+#define traceTASK_NOTIFY_FROM_ISR( uxIndexToNotify )	SYS_TRACE_Record( SYS_TRACE_NOTIFY_ISR, ( uint8_t ) pxTCB->uxTCBNumber, 0U )
+#define traceTASK_NOTIFY_WAIT( uxIndexToWait )		SYS_TRACE_Record( SYS_TRACE_NOTIFY_WAIT, ( uint8_t ) pxCurrentTCB->uxTCBNumber, 0U )
 
 /* Normal assert() semantics without relying on the provision of an assert.h
-header file. */
+header file. Host builds stop the process instead of hanging. */
+#ifdef SYS_HOST
+extern void abort( void );
+#define configASSERT( x ) if( ( x ) == 0 ) { abort(); }
+#else
 #define configASSERT( x ) if( ( x ) == 0 ) { taskDISABLE_INTERRUPTS(); for( ;; ); }
+#endif
 
 /* Definitions that map the FreeRTOS port interrupt handlers to their CMSIS
 standard names - or at least those used in the unmodified vector table. */
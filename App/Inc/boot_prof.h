@@ -0,0 +1,63 @@
+/**
+ * @file    boot_prof.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Boot time profiler, time of each init stage since HAL init.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __BOOT_PROF_H
+#define __BOOT_PROF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported defines ----------------------------------------------------------*/
+/* Exported types ------------------------------------------------------------*/
+
+/** Boot stages, in the order they complete */
+typedef enum
+{
+    BOOT_PROF_SYS_INIT = 0U,    /**< HAL and error interface */
+    BOOT_PROF_CLOCK,            /**< System clock configuration */
+    BOOT_PROF_TIME_BASE,        /**< Microsecond time base started */
+    BOOT_PROF_OUTPUT,           /**< First output update */
+    BOOT_PROF_CV_INIT,          /**< CV task init */
+    BOOT_PROF_CLI_INIT,         /**< CLI task init */
+    BOOT_PROF_SCHEDULER,        /**< First task running */
+    BOOT_PROF_BANNER,           /**< CLI banner printed */
+    BOOT_PROF_STAGE_NUM,
+} boot_prof_stage_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Record end of a boot stage, only the first call of each stage is
+ *         kept. Task or init context.
+ * @param  stage boot stage, boot_prof_stage_t.
+ * @retval None.
+ */
+void boot_prof_mark(uint8_t stage);
+
+/**
+ * @brief  Get time a boot stage ended.
+ * @param  stage boot stage, boot_prof_stage_t.
+ * @param  time_us where to store microseconds since HAL init.
+ * @retval true if stage has been recorded.
+ */
+bool boot_prof_get(uint8_t stage, uint32_t *time_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOT_PROF_H */
+
+/* EOF */
@@ -26,6 +26,12 @@ extern "C" {
  */
 void cli_cmd_init(void);
 
+/**
+ * @brief  Print stack high water marks of every task and the main stack.
+ * @retval None.
+ */
+void cli_cmd_telemetry(void);
+
 /* Private defines -----------------------------------------------------------*/
 
 #ifdef __cplusplus
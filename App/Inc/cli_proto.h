@@ -0,0 +1,109 @@
+/**
+ * @file    cli_proto.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Binary control and telemetry protocol sharing the CLI serial.
+ *
+ * Frames are COBS encoded and go between two 0x00 delimiters, a byte text
+ * lines never hold, so the first delimiter switches the input from the text
+ * CLI to the frame decoder until the closing one. Every frame starts and ends
+ * with its own delimiter. Decoded frame:
+ *
+ *   type (1) | seq (1) | payload (0..CLI_PROTO_PAYLOAD_MAX) | CRC-32 (4)
+ *
+ * CRC-32 (IEEE 802.3) covers type to payload. Multi byte fields are little
+ * endian. Replies carry the request type with CLI_PROTO_REPLY set, the same
+ * seq and a cli_proto_status_t byte before their payload. Frames with a bad
+ * CRC get no reply.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CLI_PROTO_H
+#define __CLI_PROTO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** Protocol version reported on ping */
+#define CLI_PROTO_VERSION       1U
+
+/** Frame delimiter */
+#define CLI_PROTO_DELIM         0x00U
+
+/** Max payload of a frame */
+#define CLI_PROTO_PAYLOAD_MAX   240U
+
+/** Reply flag on the frame type */
+#define CLI_PROTO_REPLY         0x80U
+
+/** Min telemetry period */
+#define CLI_PROTO_STREAM_MIN_MS 10U
+
+/* Exported types ------------------------------------------------------------*/
+
+/** Frame types */
+typedef enum
+{
+    CLI_PROTO_PING = 0x01U,         /**< Reply: version u8, frames ok u32, CRC errors u32, dropped u32, app version */
+    CLI_PROTO_PARAM_GET = 0x02U,    /**< id u16 list, cv_param_id_t. Reply: id u16, value i32 list */
+    CLI_PROTO_PARAM_SET = 0x03U,    /**< id u16, value i32 list, published together. Reply: params applied u8 */
+    CLI_PROTO_TABLE_WRITE = 0x04U,  /**< table u8, first entry u16, entries. Reply: none */
+    CLI_PROTO_STREAM = 0x05U,       /**< period ms u16, 0 stops. Reply: none */
+    CLI_PROTO_TELEMETRY = 0x10U,    /**< Sent every stream period: time us u32, analog codes u16 x4, gates u8 */
+} cli_proto_type_t;
+
+/** Reply status */
+typedef enum
+{
+    CLI_PROTO_OK = 0U,
+    CLI_PROTO_ERR_TYPE,             /**< Unknown frame type */
+    CLI_PROTO_ERR_LEN,              /**< Payload length not valid for the type */
+    CLI_PROTO_ERR_ID,               /**< Unknown parameter or table */
+    CLI_PROTO_ERR_VALUE,            /**< Value or range out of limits */
+} cli_proto_status_t;
+
+/** Tables */
+typedef enum
+{
+    CLI_PROTO_TABLE_GATE_MAP = 0U,  /**< Note to gate mask, u8 per note */
+    CLI_PROTO_TABLE_USER_CURVE,     /**< User curve, u16 code per entry */
+    CLI_PROTO_TABLE_NUM,
+} cli_proto_table_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Init protocol state and CRC unit.
+ * @retval None.
+ */
+void cli_proto_init(void);
+
+/**
+ * @brief  Process a byte received on the CLI serial. Frames are handled and
+ *         replied once complete.
+ * @param  data received byte.
+ * @retval true if the byte belongs to a frame, false if it is CLI text.
+ */
+bool cli_proto_input(uint8_t data);
+
+/**
+ * @brief  Send a telemetry frame.
+ * @retval None.
+ */
+void cli_proto_telemetry(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CLI_PROTO_H */
+
+/* EOF */
@@ -55,6 +55,28 @@ void vCliPrintf(const char *module_name, const char *Format, ...);
   */
 void vCliRawPrintf(const char *Format, ...);
 
+/**
+  * @brief Write raw data using the cli task serial, waits until sent
+  * @param pu8Data data to write
+  * @param u32Len data length
+  * @retval None.
+  */
+void vCliWrite(const uint8_t *pu8Data, uint32_t u32Len);
+
+/**
+  * @brief Set period of memory telemetry printed by the cli task
+  * @param u32PeriodMs print period, 0 disables telemetry
+  * @retval None.
+  */
+void vCliSetTelemetry(uint32_t u32PeriodMs);
+
+/**
+  * @brief Set period of binary telemetry frames sent by the cli task
+  * @param u32PeriodMs send period, 0 disables telemetry
+  * @retval None.
+  */
+void vCliSetStream(uint32_t u32PeriodMs);
+
 /**
   * @brief Notify event to a task.
   * @param u32Event event to notify.
@@ -0,0 +1,134 @@
+/**
+ * @file    cv_cal.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Analog output calibration. Per output offset, gain and note table
+ *          kept on a wear levelled flash store.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_CAL_H
+#define __CV_CAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "cv_engine.h"
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** Unity gain, gains are unsigned Q15 */
+#define CV_CAL_GAIN_ONE         0x8000U
+
+/* Exported types ------------------------------------------------------------*/
+
+/** Calibration data */
+typedef struct cv_cal_data
+{
+    int16_t offset[CV_ANALOG_NUM];                  /**< Offset in output codes */
+    uint16_t gain[CV_ANALOG_NUM];                   /**< Gain, Q15 */
+    uint16_t note[CV_ANALOG_NUM][MIDI_NOTE_NUM];    /**< Output code of each note */
+} cv_cal_data_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Load newest valid calibration from flash. Data is used in place,
+ *         nothing is copied or computed. Uncalibrated outputs are ideal.
+ * @retval true if a calibration record was found.
+ */
+bool cv_cal_init(void);
+
+/**
+ * @brief  Get pitch output code.
+ * @param  out analog output.
+ * @param  note MIDI note.
+ * @param  mod pitch modulation in ideal output codes.
+ * @retval calibrated output code.
+ */
+uint16_t cv_cal_pitch(uint8_t out, uint8_t note, int32_t mod);
+
+/**
+ * @brief  Apply offset and gain to an output code.
+ * @param  out analog output.
+ * @param  code ideal output code.
+ * @retval calibrated output code.
+ */
+uint16_t cv_cal_apply(uint8_t out, uint16_t code);
+
+/**
+ * @brief  Set output offset and gain. Changes are applied at once and kept
+ *         in RAM until saved.
+ * @param  out analog output.
+ * @param  offset offset in output codes.
+ * @param  gain gain, Q15.
+ * @retval true if parameters are valid.
+ */
+bool cv_cal_set_output(uint8_t out, int16_t offset, uint16_t gain);
+
+/**
+ * @brief  Set output code of a note.
+ * @param  out analog output.
+ * @param  note MIDI note.
+ * @param  code output code.
+ * @retval true if parameters are valid.
+ */
+bool cv_cal_set_note(uint8_t out, uint8_t note, uint16_t code);
+
+/**
+ * @brief  Fill note table of an output from two measured notes.
+ * @param  out analog output.
+ * @param  note_a first note.
+ * @param  code_a output code of first note.
+ * @param  note_b second note, different from first one.
+ * @param  code_b output code of second note.
+ * @retval true if parameters are valid.
+ */
+bool cv_cal_set_scale(uint8_t out, uint8_t note_a, uint16_t code_a, uint8_t note_b, uint16_t code_b);
+
+/**
+ * @brief  Get calibration in use.
+ * @retval pointer to calibration data, NULL if outputs are uncalibrated.
+ */
+const cv_cal_data_t *cv_cal_get(void);
+
+/**
+ * @brief  Append current calibration to flash store. Pages reached by the
+ *         record must have been erased by cv_cal_reclaim.
+ * @retval true if calibration was stored and verified, false if flash
+ *         is not ready yet.
+ */
+bool cv_cal_save(void);
+
+/**
+ * @brief  Check if pages for the next record have to be erased.
+ * @retval true if cv_cal_reclaim has work to do.
+ */
+bool cv_cal_need_reclaim(void);
+
+/**
+ * @brief  Erase pages reached by the next record. Flash is stalled for the
+ *         whole page erase, call it when the outputs are idle.
+ * @retval true if next record can be saved.
+ */
+bool cv_cal_reclaim(void);
+
+/**
+ * @brief  Get sequence number of loaded or last saved record.
+ * @retval sequence number, 0 if none.
+ */
+uint32_t cv_cal_get_seq(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_CAL_H */
+
+/* EOF */
@@ -0,0 +1,130 @@
+/**
+ * @file    cv_clock.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   MIDI clock tracking and clock, run and reset gate outputs.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_CLOCK_H
+#define __CV_CLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** MIDI clock resolution, pulses per quarter note */
+#define CV_CLOCK_PPQN           24U
+
+/** Max divide ratio */
+#define CV_CLOCK_DIV_MAX        96U
+
+/** Max multiply ratio */
+#define CV_CLOCK_MUL_MAX        16U
+
+/** Output value to leave a clock function unassigned */
+#define CV_CLOCK_OUT_NONE       0xFFU
+
+/* Exported types ------------------------------------------------------------*/
+
+/** Clock outputs configuration */
+typedef struct cv_clock_cfg
+{
+    uint8_t clock_out;      /**< Gate output for clock pulses */
+    uint8_t run_out;        /**< Gate output high while running */
+    uint8_t reset_out;      /**< Gate output pulsed on start */
+    uint8_t div;            /**< MIDI clocks per output pulse, before multiply */
+    uint8_t mul;            /**< Output pulses per divided clock */
+} cv_clock_cfg_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Init clock tracking with default configuration.
+ * @retval None.
+ */
+void cv_clock_init(void);
+
+/**
+ * @brief  Get clock configuration, changed through cv_preset_edit.
+ * @retval pointer to configuration.
+ */
+const cv_clock_cfg_t *cv_clock_get_cfg(void);
+
+/**
+ * @brief  Switch to another configuration, tempo and transport are kept. Call
+ *         from the task running the clock.
+ * @param  cfg configuration, must stay valid. NULL restores the default one.
+ * @retval None.
+ */
+void cv_clock_set_cfg(cv_clock_cfg_t *cfg);
+
+/**
+ * @brief  Process a MIDI realtime message.
+ * @param  status realtime status byte.
+ * @param  time_us reception time in microseconds.
+ * @retval true if an assigned output changes on this message.
+ */
+bool cv_clock_midi(uint8_t status, uint32_t time_us);
+
+/**
+ * @brief  Fire scheduled output pulse, on a clock or interpolated.
+ * @param  time_us current time in microseconds.
+ * @retval true if a pulse was started, false if none was due.
+ */
+bool cv_clock_event(uint32_t time_us);
+
+/**
+ * @brief  Get time to next output pulse.
+ * @param  time_us current time in microseconds.
+ * @param  delay_us where to store delay to next pulse.
+ * @retval true if a pulse is pending.
+ */
+bool cv_clock_get_event(uint32_t time_us, uint32_t *delay_us);
+
+/**
+ * @brief  Advance clock outputs one output tick.
+ * @retval None.
+ */
+void cv_clock_tick(void);
+
+/**
+ * @brief  Get gate outputs driven by clock functions.
+ * @param  gates current gate values.
+ * @retval gate values with clock outputs applied.
+ */
+uint8_t cv_clock_apply_gates(uint8_t gates);
+
+/**
+ * @brief  Get smoothed MIDI clock period.
+ * @retval period in microseconds with 8 fractional bits, 0 if unknown.
+ */
+uint32_t cv_clock_get_period(void);
+
+/**
+ * @brief  Get song position.
+ * @retval MIDI clocks received since start.
+ */
+uint32_t cv_clock_get_position(void);
+
+/**
+ * @brief  Check transport state.
+ * @retval true if running.
+ */
+bool cv_clock_is_running(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_CLOCK_H */
+
+/* EOF */
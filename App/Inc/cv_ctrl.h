@@ -0,0 +1,194 @@
+/**
+ * @file    cv_ctrl.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   MIDI controller to CV mapping. Handles 14 bit CC pairs, NRPN and
+ *          RPN sequences, velocity and aftertouch, applies response curves
+ *          and smooths mapped outputs on the output tick.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_CTRL_H
+#define __CV_CTRL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "cv_engine.h"
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** Max smoothing, time constant of 2^n output ticks */
+#define CV_CTRL_SMOOTH_MAX      12U
+
+/** Default pitch bend range in cents */
+#define CV_CTRL_BEND_RANGE      200U
+
+/** Polyphonic aftertouch number to follow any note */
+#define CV_CTRL_ANY_NOTE        128U
+
+/* Exported types ------------------------------------------------------------*/
+
+/** Controller sources */
+typedef enum
+{
+    CV_CTRL_SRC_NONE = 0U,  /**< Output not mapped */
+    CV_CTRL_SRC_CC,         /**< Control change, 0-31 use 32-63 as LSB */
+    CV_CTRL_SRC_NRPN,       /**< Non registered parameter number */
+    CV_CTRL_SRC_VELOCITY,   /**< Note on velocity */
+    CV_CTRL_SRC_PRESSURE,   /**< Channel pressure */
+    CV_CTRL_SRC_POLY_AT,    /**< Polyphonic aftertouch of a note or any note */
+    CV_CTRL_SRC_NUM,
+} cv_ctrl_src_t;
+
+/** Output mapping */
+typedef struct cv_ctrl_out_cfg
+{
+    uint8_t src;            /**< Controller source, cv_ctrl_src_t */
+    uint8_t smooth;         /**< Smoothing, 0 disables */
+    uint8_t curve;          /**< Response curve, cv_curve_t */
+    uint16_t number;        /**< Controller, parameter or note number */
+} cv_ctrl_out_cfg_t;
+
+/** Controller table entry */
+typedef struct cv_ctrl_entry
+{
+    uint8_t kind;           /**< Controller function, private to the module */
+    uint8_t out;            /**< Output for mapped controllers */
+} cv_ctrl_entry_t;
+
+/** Output mapping with its lookup tables. Tables are built along with the
+    mapping so a whole mapping can be switched without rebuilding them. */
+typedef struct cv_ctrl_map
+{
+    cv_ctrl_out_cfg_t out[CV_ANALOG_NUM];       /**< Output mapping */
+    cv_ctrl_entry_t cc[MIDI_DATA_MAX + 1U];     /**< Controller number to function */
+    uint8_t src_mask[CV_CTRL_SRC_NUM];          /**< Outputs mapped to each source */
+    volatile bool changed;                      /**< Tables need a rebuild */
+} cv_ctrl_map_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Init controller mapping, all outputs unmapped.
+ * @retval None.
+ */
+void cv_ctrl_init(void);
+
+/**
+ * @brief  Init a mapping with all outputs unmapped.
+ * @param  map mapping.
+ * @retval None.
+ */
+void cv_ctrl_map_init(cv_ctrl_map_t *map);
+
+/**
+ * @brief  Map a controller to an analog output of a mapping. Tables are
+ *         rebuilt on next controller call if the mapping is active.
+ * @param  map mapping.
+ * @param  out analog output.
+ * @param  cfg output mapping.
+ * @retval true if mapping is valid.
+ */
+bool cv_ctrl_map_set(cv_ctrl_map_t *map, uint8_t out, const cv_ctrl_out_cfg_t *cfg);
+
+/**
+ * @brief  Build lookup tables of a mapping if it changed.
+ * @param  map mapping.
+ * @retval None.
+ */
+void cv_ctrl_map_build(cv_ctrl_map_t *map);
+
+/**
+ * @brief  Switch to another mapping, controller values are kept. Call from
+ *         the task running the controllers.
+ * @param  map mapping, must stay valid while in use.
+ * @retval None.
+ */
+void cv_ctrl_set_map(cv_ctrl_map_t *map);
+
+/**
+ * @brief  Check a controller mapping, as accepted by cv_ctrl_map_set.
+ *         Mappings are changed through cv_preset_edit.
+ * @param  cfg mapping.
+ * @retval true if mapping is valid.
+ */
+bool cv_ctrl_check_output(const cv_ctrl_out_cfg_t *cfg);
+
+/**
+ * @brief  Get controller mapped to an analog output.
+ * @param  out analog output.
+ * @retval pointer to mapping.
+ */
+const cv_ctrl_out_cfg_t *cv_ctrl_get_output(uint8_t out);
+
+/**
+ * @brief  Process a control change.
+ * @param  cc controller number.
+ * @param  value controller value.
+ * @retval true if an output changed.
+ */
+bool cv_ctrl_cc(uint8_t cc, uint8_t value);
+
+/**
+ * @brief  Process a note on velocity.
+ * @param  note MIDI note.
+ * @param  velocity MIDI velocity.
+ * @retval None.
+ */
+void cv_ctrl_note(uint8_t note, uint8_t velocity);
+
+/**
+ * @brief  Process channel pressure.
+ * @param  value pressure value.
+ * @retval true if an output changed.
+ */
+bool cv_ctrl_pressure(uint8_t value);
+
+/**
+ * @brief  Process polyphonic aftertouch.
+ * @param  note MIDI note.
+ * @param  value pressure value.
+ * @retval true if an output changed.
+ */
+bool cv_ctrl_poly_pressure(uint8_t note, uint8_t value);
+
+/**
+ * @brief  Reset controller values and parameter selection.
+ * @retval None.
+ */
+void cv_ctrl_reset(void);
+
+/**
+ * @brief  Advance output smoothing one output tick.
+ * @retval None.
+ */
+void cv_ctrl_tick(void);
+
+/**
+ * @brief  Get output code of a mapped analog output.
+ * @param  out analog output.
+ * @param  code where to store output code.
+ * @retval true if output is mapped.
+ */
+bool cv_ctrl_get_code(uint8_t out, uint16_t *code);
+
+/**
+ * @brief  Get pitch bend range set through RPN 0.
+ * @retval range in cents.
+ */
+uint16_t cv_ctrl_get_bend_range(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_CTRL_H */
+
+/* EOF */
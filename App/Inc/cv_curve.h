@@ -0,0 +1,85 @@
+/**
+ * @file    cv_curve.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Response curves applied to controller values.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_CURVE_H
+#define __CV_CURVE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** Entries of every curve table */
+#define CV_CURVE_SIZE           256U
+
+/* Exported types ------------------------------------------------------------*/
+
+/** Response curves */
+typedef enum
+{
+    CV_CURVE_LINEAR = 0U,
+    CV_CURVE_EXP,
+    CV_CURVE_LOG,
+    CV_CURVE_USER,
+    CV_CURVE_NUM,
+} cv_curve_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Init user curve as linear.
+ * @retval None.
+ */
+void cv_curve_init(void);
+
+/**
+ * @brief  Apply response curve to a controller value.
+ * @param  curve response curve, cv_curve_t.
+ * @param  value 14 bit controller value.
+ * @retval output code.
+ */
+uint16_t cv_curve_apply(uint8_t curve, uint16_t value);
+
+/**
+ * @brief  Set a straight segment of the user curve, published at once.
+ * @param  in_start first table entry.
+ * @param  in_end last table entry.
+ * @param  out_start code on first entry.
+ * @param  out_end code on last entry.
+ * @retval true if segment is valid.
+ */
+bool cv_curve_set_user(uint8_t in_start, uint8_t in_end, uint16_t out_start, uint16_t out_end);
+
+/**
+ * @brief  Get user curve table.
+ * @retval pointer to CV_CURVE_SIZE entries.
+ */
+const uint16_t *cv_curve_get_user(void);
+
+/**
+ * @brief  Replace user curve table, published at once. User curve changes
+ *         come from a single task.
+ * @param  table CV_CURVE_SIZE entries.
+ * @retval None.
+ */
+void cv_curve_load_user(const uint16_t *table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_CURVE_H */
+
+/* EOF */
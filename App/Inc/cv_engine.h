@@ -0,0 +1,146 @@
+/**
+ * @file    cv_engine.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   MIDI to CV engine. Translates MIDI messages into output frames.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_ENGINE_H
+#define __CV_ENGINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "midi_lib.h"
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** Number of analog outputs handled by the engine */
+#define CV_ANALOG_NUM           4U
+
+/** Number of gate outputs handled by the engine */
+#define CV_GATE_NUM             4U
+
+/** Max number of voices */
+#define CV_VOICE_NUM            4U
+
+/** Output tick frequency */
+#define CV_ENGINE_TICK_HZ       2000U
+
+/** Full scale analog code */
+#define CV_CODE_MAX             0xFFFFU
+
+/** Analog codes per semitone, full scale covers 128 semitones at 1V/oct */
+#define CV_CODES_PER_SEMITONE   512U
+
+/** Default trigger length */
+#define CV_TRIGGER_MS           5U
+
+/** Max trigger and gate length, ticks fit cv_gate_cfg_t */
+#define CV_GATE_LEN_MAX_MS      (UINT16_MAX * 1000UL / CV_ENGINE_TICK_HZ)
+
+/* Exported types ------------------------------------------------------------*/
+
+/** Working modes */
+typedef enum
+{
+    CV_MODE_MONO = 0U,
+    CV_MODE_DUAL,
+    CV_MODE_QUAD,
+    CV_MODE_GATE,
+    CV_MODE_NUM,
+} cv_mode_t;
+
+/** Gate output behaviour in gate mode */
+typedef enum
+{
+    CV_GATE_TRIGGER = 0U,   /**< Fixed length pulse on note on */
+    CV_GATE_GATE,           /**< High while note is held */
+    CV_GATE_LATCH,          /**< Toggle on every note on */
+    CV_GATE_TYPE_NUM,
+} cv_gate_type_t;
+
+/** Gate output configuration */
+typedef struct cv_gate_cfg
+{
+    uint8_t type;           /**< Gate behaviour, cv_gate_type_t */
+    uint8_t accent_vel;     /**< Velocity threshold for accent, over 127 disables */
+    uint16_t len_ticks;     /**< Trigger length and min gate length in ticks */
+} cv_gate_cfg_t;
+
+/** Engine configuration */
+typedef struct cv_engine_cfg
+{
+    uint8_t gate_map[MIDI_NOTE_NUM];        /**< Note to gate output mask */
+    cv_gate_cfg_t gate[CV_GATE_NUM];        /**< Gate output configuration */
+} cv_engine_cfg_t;
+
+/** Output values for a single update */
+typedef struct cv_frame
+{
+    uint16_t analog[CV_ANALOG_NUM];         /**< Analog output codes */
+    uint8_t gates;                          /**< Gate outputs, bit n for gate n */
+} cv_frame_t;
+
+/* Exported macro ------------------------------------------------------------*/
+
+/** Convert milliseconds to output ticks */
+#define CV_MS_TO_TICKS(ms)      ((uint32_t)(ms) * CV_ENGINE_TICK_HZ / 1000U)
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Init engine with default configuration.
+ * @retval None.
+ */
+void cv_engine_init(void);
+
+/**
+ * @brief  Get engine configuration. Gate fields are changed through
+ *         cv_preset_edit, mode and channels are set through cv_param.
+ * @retval pointer to configuration.
+ */
+const cv_engine_cfg_t *cv_engine_get_cfg(void);
+
+/**
+ * @brief  Switch to another configuration and take parameters published on
+ *         cv_param. Held notes are moved to the voices of a new mode. Call
+ *         from the task running the engine.
+ * @param  cfg configuration, must stay valid while in use.
+ * @retval None.
+ */
+void cv_engine_set_cfg(cv_engine_cfg_t *cfg);
+
+/**
+ * @brief  Process a MIDI message.
+ * @param  msg packed MIDI message.
+ * @retval true if the message may change the outputs, false if it is for
+ *         another channel or has no effect.
+ */
+bool cv_engine_midi(midi_msg_t msg);
+
+/**
+ * @brief  Advance engine state one output tick.
+ * @retval None.
+ */
+void cv_engine_tick(void);
+
+/**
+ * @brief  Build output frame from current engine state.
+ * @param  frame where to store output values.
+ * @retval None.
+ */
+void cv_engine_get_frame(cv_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_ENGINE_H */
+
+/* EOF */
@@ -0,0 +1,100 @@
+/**
+ * @file    cv_env.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   ADSR envelope generators triggered by note gates.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_ENV_H
+#define __CV_ENV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** Number of envelopes */
+#define CV_ENV_NUM              4U
+
+/** Max segment time */
+#define CV_ENV_TIME_MAX_MS      10000U
+
+/** Output value to leave an envelope unassigned */
+#define CV_ENV_OUT_NONE         0xFFU
+
+/* Exported types ------------------------------------------------------------*/
+
+/** Envelope configuration */
+typedef struct cv_env_cfg
+{
+    uint8_t out;            /**< Analog output or CV_ENV_OUT_NONE */
+    uint8_t gate;           /**< Voice or gate output triggering the envelope */
+    bool velocity;          /**< Scale envelope level by note velocity */
+    uint16_t attack_ms;     /**< Attack time */
+    uint16_t decay_ms;      /**< Decay time */
+    uint16_t sustain;       /**< Sustain level, full scale 0xFFFF */
+    uint16_t release_ms;    /**< Release time */
+} cv_env_cfg_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Init envelopes, all unassigned.
+ * @retval None.
+ */
+void cv_env_init(void);
+
+/**
+ * @brief  Get envelope configuration, changed through cv_preset_edit.
+ *         Times are applied on next segment.
+ * @param  env envelope index.
+ * @retval pointer to configuration.
+ */
+const cv_env_cfg_t *cv_env_get_cfg(uint8_t env);
+
+/**
+ * @brief  Switch to another configuration set, running envelopes continue
+ *         with the new times. Call from the task running the envelopes.
+ * @param  cfg array of CV_ENV_NUM configurations, must stay valid.
+ * @retval None.
+ */
+void cv_env_set_cfg(cv_env_cfg_t *cfg);
+
+/**
+ * @brief  Start attack of envelopes following a gate.
+ * @param  gate voice or gate output.
+ * @param  velocity note velocity.
+ * @retval None.
+ */
+void cv_env_trigger(uint8_t gate, uint8_t velocity);
+
+/**
+ * @brief  Advance envelopes one output tick.
+ * @param  gates current gate outputs, envelopes release on low gates.
+ * @retval None.
+ */
+void cv_env_tick(uint8_t gates);
+
+/**
+ * @brief  Get envelope code of an analog output.
+ * @param  out analog output.
+ * @param  code where to store output code.
+ * @retval true if an envelope is assigned to the output.
+ */
+bool cv_env_get_code(uint8_t out, uint16_t *code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_ENV_H */
+
+/* EOF */
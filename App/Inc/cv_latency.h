@@ -0,0 +1,86 @@
+/**
+ * @file    cv_latency.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   MIDI input to CV output latency histograms.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_LATENCY_H
+#define __CV_LATENCY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** Histogram buckets, bucket n holds latencies below 2^(n+1) us */
+#define CV_LATENCY_BUCKETS      20U
+
+/* Exported types ------------------------------------------------------------*/
+
+/** Message classes measured */
+typedef enum
+{
+    CV_LATENCY_NOTE = 0U,   /**< Note on and note off */
+    CV_LATENCY_CTRL,        /**< Controllers, pressure, pitch bend and program change */
+    CV_LATENCY_CLOCK,       /**< Clock, start, stop and continue */
+    CV_LATENCY_WAKE,        /**< Reception idle interrupt to task running */
+    CV_LATENCY_CLASS_NUM,
+} cv_latency_class_t;
+
+/** Latency histogram */
+typedef struct cv_latency_hist
+{
+    uint32_t count;                         /**< Number of samples */
+    uint32_t min_us;                        /**< Min latency */
+    uint32_t max_us;                        /**< Max latency */
+    uint32_t bucket[CV_LATENCY_BUCKETS];    /**< Log2 buckets */
+} cv_latency_hist_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Clear all histograms. Same writer as cv_latency_add.
+ * @retval None.
+ */
+void cv_latency_reset(void);
+
+/**
+ * @brief  Add a latency sample. Single writer.
+ * @param  cls message class, cv_latency_class_t.
+ * @param  latency_us latency in microseconds.
+ * @retval None.
+ */
+void cv_latency_add(uint8_t cls, uint32_t latency_us);
+
+/**
+ * @brief  Get a consistent copy of a histogram, safe from any task.
+ * @param  cls message class, cv_latency_class_t.
+ * @param  hist where to store the copy.
+ * @retval None.
+ */
+void cv_latency_get(uint8_t cls, cv_latency_hist_t *hist);
+
+/**
+ * @brief  Get percentile upper bound from a histogram.
+ * @param  hist histogram.
+ * @param  percent percentile, 1 to 100.
+ * @retval latency in microseconds, bucket bound limited to max.
+ */
+uint32_t cv_latency_percentile(const cv_latency_hist_t *hist, uint32_t percent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_LATENCY_H */
+
+/* EOF */
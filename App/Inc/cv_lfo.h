@@ -0,0 +1,110 @@
+/**
+ * @file    cv_lfo.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   LFO bank locked to MIDI clock, computed on the output tick.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_LFO_H
+#define __CV_LFO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** Number of LFOs */
+#define CV_LFO_NUM              4U
+
+/** Max cycle length, four bars of MIDI clocks */
+#define CV_LFO_CLOCKS_MAX       384U
+
+/** Max vibrato depth in cents */
+#define CV_LFO_VIBRATO_MAX      1200U
+
+/** Output value to sum LFO onto voice pitch */
+#define CV_LFO_OUT_PITCH        0xFEU
+
+/** Output value to leave LFO unassigned */
+#define CV_LFO_OUT_NONE         0xFFU
+
+/* Exported types ------------------------------------------------------------*/
+
+/** LFO waveforms */
+typedef enum
+{
+    CV_LFO_SINE = 0U,
+    CV_LFO_TRIANGLE,
+    CV_LFO_SAW,
+    CV_LFO_SQUARE,
+    CV_LFO_SAMPLE_HOLD,
+    CV_LFO_WAVE_NUM,
+} cv_lfo_wave_t;
+
+/** LFO configuration */
+typedef struct cv_lfo_cfg
+{
+    uint8_t wave;           /**< Waveform, cv_lfo_wave_t */
+    uint8_t out;            /**< Analog output, CV_LFO_OUT_PITCH or CV_LFO_OUT_NONE */
+    uint16_t clocks;        /**< Cycle length in MIDI clocks */
+    uint16_t depth;         /**< Peak to peak code on outputs, cents on pitch */
+} cv_lfo_cfg_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Init LFO bank, all LFOs unassigned.
+ * @retval None.
+ */
+void cv_lfo_init(void);
+
+/**
+ * @brief  Get LFO configuration, changed through cv_preset_edit.
+ * @param  lfo LFO index.
+ * @retval pointer to configuration.
+ */
+const cv_lfo_cfg_t *cv_lfo_get_cfg(uint8_t lfo);
+
+/**
+ * @brief  Switch to another configuration set, LFO phases are kept. Call from
+ *         the task running the LFOs.
+ * @param  cfg array of CV_LFO_NUM configurations, must stay valid.
+ * @retval None.
+ */
+void cv_lfo_set_cfg(cv_lfo_cfg_t *cfg);
+
+/**
+ * @brief  Advance all LFOs one output tick.
+ * @retval None.
+ */
+void cv_lfo_tick(void);
+
+/**
+ * @brief  Get LFO code of an analog output.
+ * @param  out analog output.
+ * @param  code where to store output code.
+ * @retval true if an LFO is assigned to the output.
+ */
+bool cv_lfo_get_code(uint8_t out, uint16_t *code);
+
+/**
+ * @brief  Get vibrato of LFOs assigned to pitch.
+ * @retval pitch offset in output codes.
+ */
+int32_t cv_lfo_get_pitch(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_LFO_H */
+
+/* EOF */
@@ -0,0 +1,93 @@
+/**
+ * @file    cv_loop.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Body of the CV task, MIDI input to output frames, free of RTOS
+ *          calls so the simulator runs the same code on a virtual clock.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_LOOP_H
+#define __CV_LOOP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "cv_engine.h"
+#include "sys_mcu.h"
+#include "sys_serial.h"
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** MIDI serial interface */
+#define CV_LOOP_SERIAL          SYS_SERIAL_1
+
+/** Events handled by cv_loop_run, other bits are ignored */
+#define CV_LOOP_EVENT_RX        (1UL << 0)  /**< Reception idle, read MIDI input */
+#define CV_LOOP_EVENT_ERROR     (1UL << 1)  /**< Line error or lost bytes */
+#define CV_LOOP_EVENT_CLOCK     (1UL << 2)  /**< Scheduled clock pulse is due */
+
+/* Exported types ------------------------------------------------------------*/
+
+/** Time source, microseconds on the SYS_SERIAL_GetRxTime time base */
+typedef uint32_t (* cv_loop_time_cb)(void);
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Init engine, calibration, presets and latency state.
+ * @param  time_cb time source.
+ * @retval None.
+ */
+void cv_loop_init(cv_loop_time_cb time_cb);
+
+/**
+ * @brief  Publish the initial frame and write it to the outputs right away,
+ *         call once the output hardware is ready.
+ * @retval None.
+ */
+void cv_loop_start(void);
+
+/**
+ * @brief  Run the engine for the events raised: read MIDI, apply presets,
+ *         catch up output ticks, publish a frame and schedule the next
+ *         clock pulse. Call from the task running the engine.
+ * @param  events CV_LOOP_EVENT_ bits.
+ * @retval None.
+ */
+void cv_loop_run(uint32_t events);
+
+/**
+ * @brief  Latch last published frame on the outputs and count an output
+ *         tick. Call from the output tick interrupt.
+ * @retval None.
+ */
+SYS_RAM_FUNC void cv_loop_latch(void);
+
+/**
+ * @brief  Raise the clock output edge now, held until a frame holds the
+ *         pulse. Call from the compare interrupt.
+ * @retval None.
+ */
+SYS_RAM_FUNC void cv_loop_clock_edge(void);
+
+/**
+ * @brief  Get last frame published to the outputs, lock free.
+ * @param  frame where to copy the frame.
+ * @retval None.
+ */
+void cv_loop_get_frame(cv_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_LOOP_H */
+
+/* EOF */
@@ -0,0 +1,175 @@
+/**
+ * @file    cv_param.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Registry of engine parameters. Typed, range checked values
+ *          addressed by id, published to the engine with a sequence counter.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_PARAM_H
+#define __CV_PARAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** Sequence never published, makes the next cv_param_read copy the values */
+#define CV_PARAM_SEQ_NONE       1U
+
+/** Max glide time */
+#define CV_PARAM_GLIDE_MAX_MS   5000U
+
+/* Exported types ------------------------------------------------------------*/
+
+/** Parameter ids, also used by the binary protocol */
+typedef enum
+{
+    CV_PARAM_MODE = 0U,     /**< Working mode, cv_mode_t */
+    CV_PARAM_CHANNEL,       /**< MIDI channel for voice modes, 0-15 */
+    CV_PARAM_GATE_CHANNEL,  /**< MIDI channel for gate mode, 0-15 */
+    CV_PARAM_GLIDE,         /**< Pitch glide time in ms, 0 disables */
+    CV_PARAM_GLIDE_CURVE,   /**< Glide response curve, cv_curve_t */
+    CV_PARAM_NUM,
+} cv_param_id_t;
+
+/** Value types */
+typedef enum
+{
+    CV_PARAM_U8 = 0U,
+    CV_PARAM_U16,
+} cv_param_type_t;
+
+/** Parameter values, as seen by the engine */
+typedef struct cv_param_values
+{
+    uint8_t mode;           /**< Working mode, cv_mode_t */
+    uint8_t channel;        /**< MIDI channel for voice modes */
+    uint8_t gate_channel;   /**< MIDI channel for gate mode */
+    uint8_t glide_curve;    /**< Glide response curve, cv_curve_t */
+    uint16_t glide_ms;      /**< Pitch glide time, 0 disables */
+} cv_param_values_t;
+
+/** Parameter description */
+typedef struct cv_param_desc
+{
+    const char *name;               /**< Name used by the CLI */
+    const char * const *names;      /**< Value names, NULL for numbers */
+    uint8_t type;                   /**< Value type, cv_param_type_t */
+    uint8_t offset;                 /**< Offset on cv_param_values_t */
+    uint16_t min;                   /**< Min value */
+    uint16_t max;                   /**< Max value */
+    uint16_t def;                   /**< Default value */
+} cv_param_desc_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Set every parameter to its default value.
+ * @retval None.
+ */
+void cv_param_init(void);
+
+/**
+ * @brief  Get a parameter description.
+ * @param  id parameter, cv_param_id_t.
+ * @retval description, NULL if id is not valid.
+ */
+const cv_param_desc_t *cv_param_get_desc(uint8_t id);
+
+/**
+ * @brief  Find a parameter by name.
+ * @param  name parameter name, not null terminated.
+ * @param  len name length.
+ * @param  id where to store parameter id.
+ * @retval true if found.
+ */
+bool cv_param_find(const char *name, size_t len, uint8_t *id);
+
+/**
+ * @brief  Parse a parameter value, a value name or a decimal number.
+ * @param  id parameter, cv_param_id_t.
+ * @param  text value text, not null terminated.
+ * @param  len text length.
+ * @param  value where to store value, range is checked on set.
+ * @retval true if text is a value of the parameter.
+ */
+bool cv_param_parse(uint8_t id, const char *text, size_t len, int32_t *value);
+
+/**
+ * @brief  Get a parameter value.
+ * @param  id parameter, cv_param_id_t.
+ * @retval value, 0 if id is not valid.
+ */
+int32_t cv_param_get(uint8_t id);
+
+/**
+ * @brief  Set a parameter value and publish it, unless a write started with
+ *         cv_param_begin is open.
+ * @param  id parameter, cv_param_id_t.
+ * @param  value new value.
+ * @retval true if id is valid and value is in range.
+ */
+bool cv_param_set(uint8_t id, int32_t value);
+
+/**
+ * @brief  Copy every parameter value, as cv_param_get does.
+ * @param  values where to copy values.
+ * @retval None.
+ */
+void cv_param_get_values(cv_param_values_t *values);
+
+/**
+ * @brief  Replace values out of range by their defaults.
+ * @param  values values to check.
+ * @retval None.
+ */
+void cv_param_check_values(cv_param_values_t *values);
+
+/**
+ * @brief  Set every parameter and publish them together, values out of
+ *         range take their defaults.
+ * @param  values new values.
+ * @retval None.
+ */
+void cv_param_set_values(const cv_param_values_t *values);
+
+/**
+ * @brief  Start a write of several parameters, published together on
+ *         cv_param_end. Writers are serialized by a mutex, keep it short as
+ *         the cv task may wait for it to apply a preset.
+ * @retval None.
+ */
+void cv_param_begin(void);
+
+/**
+ * @brief  End a write started with cv_param_begin.
+ * @retval None.
+ */
+void cv_param_end(void);
+
+/**
+ * @brief  Copy values published after a given sequence. Lock free, values
+ *         are left as they are while a write is in progress.
+ * @param  values where to copy values.
+ * @param  seq sequence of the values held by the caller, updated on copy.
+ * @retval true if values have been copied.
+ */
+bool cv_param_read(cv_param_values_t *values, uint32_t *seq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_PARAM_H */
+
+/* EOF */
@@ -0,0 +1,114 @@
+/**
+ * @file    cv_preset.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Presets of mode, routing, curves and MIDI channels kept on the
+ *          flash key value store. Presets are compiled to RAM at boot and
+ *          switched by pointer on the output frame boundary.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_PRESET_H
+#define __CV_PRESET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "cv_engine.h"
+#include "cv_clock.h"
+#include "cv_ctrl.h"
+#include "cv_lfo.h"
+#include "cv_env.h"
+#include "cv_param.h"
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** Number of presets */
+#define CV_PRESET_NUM           8U
+
+/* Exported types ------------------------------------------------------------*/
+
+/** Preset contents */
+typedef struct cv_preset
+{
+    cv_param_values_t param;                /**< Mode, MIDI channels and glide */
+    cv_engine_cfg_t engine;                 /**< Gate routing */
+    cv_clock_cfg_t clock;                   /**< Clock outputs */
+    cv_ctrl_out_cfg_t ctrl[CV_ANALOG_NUM];  /**< Controller routing and curves */
+    cv_lfo_cfg_t lfo[CV_LFO_NUM];           /**< LFOs */
+    cv_env_cfg_t env[CV_ENV_NUM];           /**< Envelopes */
+} cv_preset_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Compile stored presets, restore user curve and apply preset 0.
+ *         Presets not stored start from the default configuration.
+ * @retval None.
+ */
+void cv_preset_init(void);
+
+/**
+ * @brief  Store active configuration and user curve. The user curve is
+ *         written only when changed. A preset other than the active one is
+ *         compiled to the spare image and swapped on next output frame.
+ * @param  preset preset number.
+ * @retval true if stored, false if invalid, busy or not stored.
+ */
+bool cv_preset_save(uint8_t preset);
+
+/**
+ * @brief  Request a preset, applied on next output frame. Safe to use from
+ *         other tasks.
+ * @param  preset preset number.
+ * @retval true if preset is valid.
+ */
+bool cv_preset_load(uint8_t preset);
+
+/**
+ * @brief  Swap a recompiled preset image and apply requested preset, only
+ *         pointers are switched. Call from the task running the engine.
+ * @retval None.
+ */
+void cv_preset_apply(void);
+
+/**
+ * @brief  Start a change of the active configuration. Nothing is changed in
+ *         place, the copy is applied by cv_preset_publish. Mode, channels
+ *         and glide are set through cv_param, not here.
+ * @retval copy of the active configuration, NULL if busy.
+ */
+cv_preset_t *cv_preset_edit(void);
+
+/**
+ * @brief  Compile the copy returned by cv_preset_edit to the spare image,
+ *         it replaces the edited preset on next output frame.
+ * @retval None.
+ */
+void cv_preset_publish(void);
+
+/**
+ * @brief  Check if the spare image waits for the engine task to swap it.
+ * @retval true if a save must wait.
+ */
+bool cv_preset_is_busy(void);
+
+/**
+ * @brief  Get active preset.
+ * @retval preset number.
+ */
+uint8_t cv_preset_get_active(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_PRESET_H */
+
+/* EOF */
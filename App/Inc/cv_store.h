@@ -0,0 +1,83 @@
+/**
+ * @file    cv_store.h
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Log structured key value store on flash. Values are read in place
+ *          through a RAM index, writes append records and never erase.
+ *
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_STORE_H
+#define __CV_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/** Number of keys, keys go from 0 to CV_STORE_KEY_NUM - 1 */
+#define CV_STORE_KEY_NUM        16U
+
+/** Max value length */
+#define CV_STORE_VALUE_MAX      512U
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  Scan store pages and build key index. Only done on init.
+ * @retval true if store holds any value.
+ */
+bool cv_store_init(void);
+
+/**
+ * @brief  Get value of a key, a single index access.
+ * @param  key value key.
+ * @param  len where to store value length, may be NULL.
+ * @retval pointer to value in flash, NULL if not stored.
+ */
+const void *cv_store_get(uint16_t key, uint16_t *len);
+
+/**
+ * @brief  Store value of a key. When the write page is full writing moves to
+ *         the spare page, taking live values of the oldest page with it.
+ * @param  key value key.
+ * @param  value value data.
+ * @param  len value length, up to CV_STORE_VALUE_MAX.
+ * @retval true if value was stored, false if full and spare is not erased.
+ */
+bool cv_store_set(uint16_t key, const void *value, uint16_t len);
+
+/**
+ * @brief  Check if the spare page has to be erased.
+ * @retval true if cv_store_reclaim has work to do.
+ */
+bool cv_store_need_reclaim(void);
+
+/**
+ * @brief  Erase the spare page. Flash is stalled for the whole page erase,
+ *         call it when the outputs are idle.
+ * @retval true if spare page is ready.
+ */
+bool cv_store_reclaim(void);
+
+/**
+ * @brief  Get free space left on write page.
+ * @retval free bytes.
+ */
+uint32_t cv_store_get_free(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_STORE_H */
+
+/* EOF */
@@ -0,0 +1,73 @@
+/**
+  ******************************************************************************
+  * @file           : cv_task.h
+  * @brief          : Task to handle MIDI input and CV outputs
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CV_TASK_H
+#define __CV_TASK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+/* Private includes ----------------------------------------------------------*/
+#include <stdbool.h>
+#include "sys_rtos.h"
+#include "cv_engine.h"
+
+/* Private defines -----------------------------------------------------------*/
+
+/* Task parameters */
+#define CV_TASK_NAME    "CV"
+#define CV_TASK_STACK   192U
+#define CV_TASK_PRIO    3U
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief Init resources for CV task
+  * @retval operation result, true for correct creation, false for error
+  */
+bool bCvTaskInit(void);
+
+/**
+  * @brief Get last output frame published to the outputs, lock free
+  * @param pxFrame where to copy the frame
+  * @retval None
+  */
+void vCvTaskGetFrame(cv_frame_t *pxFrame);
+
+/**
+  * @brief Check if outputs are idle, no gate on, clock stopped and no recent
+  *        MIDI input, so a stall goes unnoticed
+  * @retval true if idle
+  */
+bool bCvTaskIsIdle(void);
+
+/**
+  * @brief Clear latency histograms, done by the CV task on its next wake up
+  * @retval None
+  */
+void vCvTaskLatencyReset(void);
+
+/**
+  * @brief Wait for the CV task to take the spare preset image, call it
+  *        before a preset save from another task
+  * @retval None
+  */
+void vCvTaskWaitPreset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CV_TASK_H */
+
+/*****END OF FILE****/
@@ -0,0 +1,85 @@
+/**
+ * @file    boot_prof.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Boot time profiler, time of each init stage since HAL init.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "boot_prof.h"
+#include "sys_mcu.h"
+#include "sys_rtos.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+
+/** End time of each stage */
+static uint32_t u32StageUs[BOOT_PROF_STAGE_NUM];
+static uint32_t u32StageDone = 0U;
+
+/** Microsecond time base offset from HAL init, set once it is running */
+static uint32_t u32TimeOffset = 0U;
+static bool bTimeBase = false;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private application code --------------------------------------------------*/
+/* Public application code ---------------------------------------------------*/
+
+void boot_prof_mark(uint8_t stage)
+{
+    USER_ASSERT(stage < BOOT_PROF_STAGE_NUM);
+
+    uint32_t u32Time;
+
+    /* HAL tick only counts until interrupts are masked by the first kernel
+       object, later stages need the time base */
+    if (bTimeBase)
+    {
+        u32Time = SYS_RTOS_GetTimeUs() + u32TimeOffset;
+    }
+    else
+    {
+        u32Time = SYS_MCU_GetTickUs();
+    }
+
+    if (stage == BOOT_PROF_TIME_BASE)
+    {
+        u32TimeOffset = u32Time - SYS_RTOS_GetTimeUs();
+        bTimeBase = true;
+    }
+
+    if ((stage < BOOT_PROF_STAGE_NUM) && ((u32StageDone & (1UL << stage)) == 0U))
+    {
+        u32StageUs[stage] = u32Time;
+        u32StageDone |= (1UL << stage);
+    }
+}
+
+bool boot_prof_get(uint8_t stage, uint32_t *time_us)
+{
+    USER_ASSERT(time_us != NULL);
+
+    bool bRetval = false;
+
+    if ((stage < BOOT_PROF_STAGE_NUM) && ((u32StageDone & (1UL << stage)) != 0U))
+    {
+        *time_us = u32StageUs[stage];
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+/* EOF */
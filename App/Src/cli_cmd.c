@@ -7,17 +7,48 @@
 
 /* Includes ------------------------------------------------------------------*/
 
+#include <stdlib.h>
+#include <string.h>
 #include "cli_cmd.h"
 #include "cli_task.h"
+#include "cv_engine.h"
+#include "cv_clock.h"
+#include "cv_ctrl.h"
+#include "cv_curve.h"
+#include "cv_lfo.h"
+#include "cv_env.h"
+#include "cv_cal.h"
+#include "cv_preset.h"
+#include "cv_latency.h"
+#include "cv_param.h"
+#include "cv_task.h"
+#include "boot_prof.h"
 #include "FreeRTOS.h"
 #include "FreeRTOS_CLI.h"
 #include "sys_mcu.h"
+#include "sys_rtos.h"
+#include "sys_trace.h"
 #ifdef USE_USER_ASSERT
 #include "user_error.h"
 #endif
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+
+/* Tasks tracked by top command */
+#define CLI_TOP_TASKS       8U
+
+/* Max memory telemetry period */
+#define CLI_TELEMETRY_MAX_S 3600U
+
+/* Trace dump format, read by Tools/trace_conv.py */
+#define CLI_TRACE_MAGIC     "MTRC"
+#define CLI_TRACE_VERSION   1U
+#define CLI_TRACE_HEADER    20U
+#define CLI_TRACE_TASK      8U
+
+/* Trace events sent on each serial write */
+#define CLI_TRACE_CHUNK     16U
 /* Private macro -------------------------------------------------------------*/
 #ifdef USE_USER_ASSERT
 #define USER_ASSERT(A)      ERR_ASSERT(A)
@@ -63,34 +94,411 @@ static BaseType_t userHardFault(char *pcWriteBuffer, size_t xWriteBufferLen, con
  */
 static BaseType_t userGetTime(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
 
+/**
+ * @brief  Get or reset MIDI to CV latency histograms.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userLatency(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Get time of each boot stage.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userBoot(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Get CPU usage of each task since last reset.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userTop(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Get stack high water marks or set memory telemetry period.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userMem(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Start, stop or dump the RAM event trace.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userTrace(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Get cycles spent on each interrupt since last reset.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userIsr(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Get one or every parameter on the registry.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userParamGet(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Set a parameter on the registry.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userParamSet(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Print a parameter, value names instead of numbers when it has them.
+ * @param  u8Id parameter, cv_param_id_t.
+ * @retval None.
+ */
+static void _print_param(uint8_t u8Id);
+
+/**
+ * @brief  Set gate mode note to output map.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userGateMap(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Set gate output behaviour.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userGateOut(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Set clock outputs and ratio.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userClock(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Get tempo of MIDI clock.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userGetBpm(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Map controller to analog output.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userCtrlMap(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Set segment of user response curve.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userCurve(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Set LFO.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userLfo(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Set envelope.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userEnv(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Calibrate analog outputs.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userCal(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Save or load a preset.
+ * @param  pcWriteBuffer
+ * @param  xWriteBufferLen
+ * @param  pcCommandString
+ * @retval pdFALSE, pdTRUE
+ */
+static BaseType_t userPreset(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+ * @brief  Start a change of the active configuration, waits for a previous
+ *         one to be taken by the CV task.
+ * @retval copy to change, applied by cv_preset_publish.
+ */
+static cv_preset_t *_edit_preset(void);
+
+/**
+ * @brief  Get a signed 16 bit parameter.
+ * @param  pcCommandString command string.
+ * @param  uxParam parameter index.
+ * @param  pi16Value where to store value.
+ * @retval true if parameter is a valid number.
+ */
+static bool _get_param_i16(const char *pcCommandString, UBaseType_t uxParam, int16_t *pi16Value);
+
+/**
+ * @brief  Get numeric parameter from command string.
+ * @param  pcCommandString command string
+ * @param  uxParam parameter index
+ * @param  pu32Value where to store value
+ * @retval true if parameter found
+ */
+static bool _get_param_u32(const char *pcCommandString, UBaseType_t uxParam, uint32_t *pu32Value);
+
+/**
+ * @brief  Stop trace and send it in binary. Header is magic, version, task
+ *         number, event size, event number, dropped events and current time.
+ *         Task numbers with names and events follow, all little endian.
+ * @retval None
+ */
+static void _trace_dump(void);
+
+/**
+ * @brief  Find parameter on a list of names.
+ * @param  pcCommandString command string
+ * @param  uxParam parameter index
+ * @param  pcNames list of names
+ * @param  u32Num number of names
+ * @param  pu32Index where to store index of matched name
+ * @retval true if name found
+ */
+static bool _get_param_name(const char *pcCommandString, UBaseType_t uxParam, const char * const *pcNames, uint32_t u32Num, uint32_t *pu32Index);
+
 /* Private variables ---------------------------------------------------------*/
 
-static const CLI_Command_Definition_t xUserReset = {
-    "reset",
-    "reset:\tForce device reset",
-    userReset,
-    0
+/** Commands found by the hashed table lookup of the CLI, help lists them in this order */
+static const CLI_Command_Definition_t xUserCommands[] = {
+    {
+        "assert",
+        "assert:\tForce assert error",
+        userAssert,
+        0
+    },
+    {
+        "boot",
+        "boot:\tGet end time of each boot stage in us since HAL init",
+        userBoot,
+        0
+    },
+    {
+        "bpm",
+        "bpm:\tGet MIDI clock tempo",
+        userGetBpm,
+        0
+    },
+    {
+        "cal",
+        "cal:\tCalibrate [out <o> <offset> <gain_q15>|note <o> <n> <code>|scale <o> <n1> <code1> <n2> <code2>|save]",
+        userCal,
+        -1
+    },
+    {
+        "cc",
+        "cc:\tMap controller <out> <off|cc|nrpn|vel|pres|pat> <num> <smooth 0-12> <lin|exp|log|user>",
+        userCtrlMap,
+        5
+    },
+    {
+        "clk",
+        "clk:\tSet clock <clk_out> <run_out> <rst_out> <div> <mul>, out >= 4 disables",
+        userClock,
+        5
+    },
+    {
+        "env",
+        "env:\tSet envelope <env> <out, >3 off> <gate> <attack_ms> <decay_ms> <sustain 0-65535> <release_ms> <vel 0|1>",
+        userEnv,
+        8
+    },
+    {
+        "fault",
+        "fault:\tForce hardfaul",
+        userHardFault,
+        0
+    },
+    {
+        "get",
+        "get:\tGet parameters, mode channel gchannel glide gcurve [name]",
+        userParamGet,
+        -1
+    },
+    {
+        "gmap",
+        "gmap:\tMap note to gates <note> <mask>",
+        userGateMap,
+        2
+    },
+    {
+        "gout",
+        "gout:\tSet gate <out> <trig|gate|latch> <len_ms> <accent_vel>",
+        userGateOut,
+        4
+    },
+    {
+        "isr",
+        "isr:\tGet core cycles of each interrupt, n min max avg since last reset [reset]",
+        userIsr,
+        -1
+    },
+    {
+        "lat",
+        "lat:\tGet MIDI to CV latency in us, min, max, p99 and log2 histogram [reset]",
+        userLatency,
+        -1
+    },
+    {
+        "lfo",
+        "lfo:\tSet LFO <lfo> <sine|tri|saw|sqr|sh> <out 0-3, 4 pitch, >4 off> <clocks> <depth code|cents>",
+        userLfo,
+        5
+    },
+    {
+        "mem",
+        "mem:\tGet min free stack of each task and main stack [telemetry period s, 0 off]",
+        userMem,
+        -1
+    },
+    {
+        "preset",
+        "preset:\tStore or apply preset <save|load> <preset 0-7>",
+        userPreset,
+        2
+    },
+    {
+        "reset",
+        "reset:\tForce device reset",
+        userReset,
+        0
+    },
+    {
+        "set",
+        "set:\tSet parameter <name> <value>, names as shown by get",
+        userParamSet,
+        2
+    },
+    {
+        "time",
+        "time:\tGet system time",
+        userGetTime,
+        0
+    },
+    {
+        "top",
+        "top:\tGet CPU usage of each task and load since last reset [reset]",
+        userTop,
+        -1
+    },
+    {
+        "trace",
+        "trace:\tRAM event trace <start|stop|dump>, dump stops it and sends it in binary",
+        userTrace,
+        1
+    },
+    {
+        "ucurve",
+        "ucurve:\tSet user curve segment <in_start> <in_end> <out_start> <out_end>, 256 steps",
+        userCurve,
+        4
+    }
+};
+
+/** Latency class names, cv_latency_class_t order */
+static const char * const pcLatencyNames[CV_LATENCY_CLASS_NUM] = {
+    "note", "ctrl", "clock", "wake"
+};
+
+/** Boot stages */
+static const char * const pcBootNames[BOOT_PROF_STAGE_NUM] = {
+    "sys", "clock", "timebase", "output", "cv", "cli", "sched", "banner"
+};
+
+/** Task states used by top and mem, too large for the CLI stack */
+static TaskStatus_t xTaskStatus[CLI_TOP_TASKS];
+
+/** Run time counters at last top reset */
+static TaskHandle_t xTopHandle[CLI_TOP_TASKS];
+static uint32_t u32TopBase[CLI_TOP_TASKS];
+static uint32_t u32TopStart = 0U;
+
+/** Trace operations */
+static const char * const pcTraceNames[] = {
+    "start", "stop", "dump"
+};
+
+/** Trace events being sent, too large for the CLI stack */
+static sys_trace_event_t xTraceChunk[CLI_TRACE_CHUNK];
+
+/** Calibration operations */
+static const char * const pcCalNames[] = {
+    "out", "note", "scale", "save"
+};
+
+/** Preset operations */
+static const char * const pcPresetNames[] = {
+    "save", "load"
 };
 
-static const CLI_Command_Definition_t xUserAssert = {
-    "assert",
-    "assert:\tForce assert error",
-    userAssert,
-    0
+/** Gate type names, cv_gate_type_t order */
+static const char * const pcGateNames[CV_GATE_TYPE_NUM] = {
+    "trig", "gate", "latch"
 };
 
-static const CLI_Command_Definition_t xUserFault = {
-    "fault",
-    "fault:\tForce hardfaul",
-    userHardFault,
-    0
+/** Controller source names, cv_ctrl_src_t order */
+static const char * const pcCtrlSrcNames[CV_CTRL_SRC_NUM] = {
+    "off", "cc", "nrpn", "vel", "pres", "pat"
 };
 
-static const CLI_Command_Definition_t xUserTime = {
-    "time",
-    "time:\tGet system time",
-    userGetTime,
-    0
+/** Response curve names, cv_curve_t order */
+static const char * const pcCurveNames[CV_CURVE_NUM] = {
+    "lin", "exp", "log", "user"
+};
+
+/** LFO wave names, cv_lfo_wave_t order */
+static const char * const pcLfoNames[CV_LFO_WAVE_NUM] = {
+    "sine", "tri", "saw", "sqr", "sh"
 };
 
 /* Callbacks -----------------------------------------------------------------*/
@@ -130,14 +538,789 @@ static BaseType_t userGetTime(char *pcWriteBuffer,
     return pdFALSE;
 }
 
+static BaseType_t userLatency(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    BaseType_t xParamLen = 0;
+    const char *pcParam = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen);
+
+    if (pcParam == NULL)
+    {
+        cv_latency_hist_t xHist;
+
+        for (uint8_t i = 0; i < CV_LATENCY_CLASS_NUM; i++)
+        {
+            cv_latency_get(i, &xHist);
+            vCliPrintf(CLI_TASK_NAME, "%s: n %u min %u max %u p99 %u",
+                       pcLatencyNames[i], xHist.count,
+                       (xHist.count != 0U) ? xHist.min_us : 0U, xHist.max_us,
+                       cv_latency_percentile(&xHist, 99U));
+
+            for (uint32_t j = 0; j < CV_LATENCY_BUCKETS; j++)
+            {
+                if (xHist.bucket[j] != 0U)
+                {
+                    vCliPrintf(CLI_TASK_NAME, "  <%u: %u", (2UL << j), xHist.bucket[j]);
+                }
+            }
+        }
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else if ((xParamLen == 5) && (strncmp(pcParam, "reset", 5) == 0))
+    {
+        vCvTaskLatencyReset();
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userBoot(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32Last = 0U;
+
+    for (uint8_t i = 0; i < BOOT_PROF_STAGE_NUM; i++)
+    {
+        uint32_t u32Time;
+
+        if (boot_prof_get(i, &u32Time))
+        {
+            vCliPrintf(CLI_TASK_NAME, "%s: %u (+%u)", pcBootNames[i], u32Time, u32Time - u32Last);
+            u32Last = u32Time;
+        }
+        else
+        {
+            vCliPrintf(CLI_TASK_NAME, "%s: -", pcBootNames[i]);
+        }
+    }
+    vCliPrintf(CLI_TASK_NAME, "OK");
+
+    return pdFALSE;
+}
+
+static BaseType_t userTop(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    BaseType_t xParamLen = 0;
+    const char *pcParam = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen);
+    UBaseType_t uxNum = uxTaskGetSystemState(xTaskStatus, CLI_TOP_TASKS, NULL);
+    uint32_t u32Now = SYS_RTOS_GetTimeUs();
+
+    if (pcParam == NULL)
+    {
+        uint32_t u32Interval = u32Now - u32TopStart;
+        uint32_t u32Idle = 0U;
+
+        vCliPrintf(CLI_TASK_NAME, "interval: %u ms", u32Interval / 1000U);
+
+        for (UBaseType_t i = 0; (i < uxNum) && (u32Interval != 0U); i++)
+        {
+            uint32_t u32Base = 0U;
+            uint32_t u32Permille;
+
+            /* Tasks created after the reset count from zero */
+            for (uint32_t j = 0; j < CLI_TOP_TASKS; j++)
+            {
+                if (xTopHandle[j] == xTaskStatus[i].xHandle)
+                {
+                    u32Base = u32TopBase[j];
+                }
+            }
+
+            u32Permille = (uint32_t)(((uint64_t)(xTaskStatus[i].ulRunTimeCounter - u32Base) * 1000U) / u32Interval);
+
+            if (xTaskStatus[i].xHandle == xTaskGetIdleTaskHandle())
+            {
+                u32Idle = u32Permille;
+            }
+
+            vCliPrintf(CLI_TASK_NAME, "%s: %u.%u%%", xTaskStatus[i].pcTaskName, u32Permille / 10U, u32Permille % 10U);
+        }
+
+        u32Idle = (u32Idle < 1000U) ? (1000U - u32Idle) : 0U;
+        vCliPrintf(CLI_TASK_NAME, "load: %u.%u%%", u32Idle / 10U, u32Idle % 10U);
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else if ((xParamLen == 5) && (strncmp(pcParam, "reset", 5) == 0))
+    {
+        for (uint32_t i = 0; i < CLI_TOP_TASKS; i++)
+        {
+            xTopHandle[i] = (i < uxNum) ? xTaskStatus[i].xHandle : NULL;
+            u32TopBase[i] = (i < uxNum) ? xTaskStatus[i].ulRunTimeCounter : 0U;
+        }
+        u32TopStart = u32Now;
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userMem(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    BaseType_t xParamLen = 0;
+    uint32_t u32Period;
+
+    if (FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen) == NULL)
+    {
+        cli_cmd_telemetry();
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else if (_get_param_u32(pcCommandString, 1, &u32Period) && (u32Period <= CLI_TELEMETRY_MAX_S))
+    {
+        vCliSetTelemetry(u32Period * 1000U);
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userTrace(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32Op = 0;
+
+    if (!_get_param_name(pcCommandString, 1, pcTraceNames, sizeof(pcTraceNames) / sizeof(pcTraceNames[0]), &u32Op))
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+    else if (u32Op == 0U)
+    {
+        SYS_TRACE_Start();
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else if (u32Op == 1U)
+    {
+        SYS_TRACE_Stop();
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        _trace_dump();
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userIsr(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    BaseType_t xParamLen = 0;
+    const char *pcParam = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen);
+
+    if (pcParam == NULL)
+    {
+        sys_trace_isr_t xStats;
+
+        for (uint8_t i = 0; i < SYS_TRACE_IRQ_NUM; i++)
+        {
+            if (SYS_TRACE_GetIsr(i, &xStats))
+            {
+                vCliPrintf(CLI_TASK_NAME, "irq %u: n %u min %u max %u avg %u", i, xStats.count,
+                           xStats.min_cycles, xStats.max_cycles, (uint32_t)(xStats.sum_cycles / xStats.count));
+            }
+        }
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else if ((xParamLen == 5) && (strncmp(pcParam, "reset", 5) == 0))
+    {
+        SYS_TRACE_ResetIsr();
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static void _trace_dump(void)
+{
+    uint8_t u8Header[CLI_TRACE_HEADER] = {0};
+    uint16_t u16EventSize = (uint16_t)sizeof(sys_trace_event_t);
+    uint32_t u32Count;
+    uint32_t u32Dropped;
+    uint32_t u32Now;
+    UBaseType_t uxNum;
+
+    /* Stop first so the dump itself is not recorded */
+    SYS_TRACE_Stop();
+    u32Count = SYS_TRACE_GetCount();
+    u32Dropped = SYS_TRACE_GetDropped();
+    u32Now = SYS_RTOS_GetTimeUs();
+    uxNum = uxTaskGetSystemState(xTaskStatus, CLI_TOP_TASKS, NULL);
+
+    /* Target is little endian, fields are copied as they are */
+    memcpy(&u8Header[0], CLI_TRACE_MAGIC, 4U);
+    u8Header[4] = CLI_TRACE_VERSION;
+    u8Header[5] = (uint8_t)uxNum;
+    memcpy(&u8Header[6], &u16EventSize, sizeof(u16EventSize));
+    memcpy(&u8Header[8], &u32Count, sizeof(u32Count));
+    memcpy(&u8Header[12], &u32Dropped, sizeof(u32Dropped));
+    memcpy(&u8Header[16], &u32Now, sizeof(u32Now));
+    vCliWrite(u8Header, sizeof(u8Header));
+
+    for (UBaseType_t i = 0; i < uxNum; i++)
+    {
+        uint8_t u8Task[CLI_TRACE_TASK] = {0};
+
+        u8Task[0] = (uint8_t)xTaskStatus[i].xTaskNumber;
+        /* Name is zero padded, not terminated when it takes the whole field */
+        memcpy(&u8Task[1], xTaskStatus[i].pcTaskName, strnlen(xTaskStatus[i].pcTaskName, CLI_TRACE_TASK - 1U));
+        vCliWrite(u8Task, sizeof(u8Task));
+    }
+
+    for (uint32_t i = 0; i < u32Count; i += CLI_TRACE_CHUNK)
+    {
+        uint32_t u32Read = SYS_TRACE_Read(i, xTraceChunk, CLI_TRACE_CHUNK);
+
+        vCliWrite((const uint8_t *)xTraceChunk, u32Read * sizeof(sys_trace_event_t));
+    }
+}
+
+static bool _get_param_u32(const char *pcCommandString, UBaseType_t uxParam, uint32_t *pu32Value)
+{
+    bool bRetval = false;
+    BaseType_t xParamLen = 0;
+    const char *pcParam = FreeRTOS_CLIGetParameter(pcCommandString, uxParam, &xParamLen);
+
+    if (pcParam != NULL)
+    {
+        char *pcEnd = NULL;
+        uint32_t u32Value = (uint32_t)strtoul(pcParam, &pcEnd, 0);
+
+        if (pcEnd == &pcParam[xParamLen])
+        {
+            *pu32Value = u32Value;
+            bRetval = true;
+        }
+    }
+
+    return bRetval;
+}
+
+static bool _get_param_name(const char *pcCommandString, UBaseType_t uxParam, const char * const *pcNames, uint32_t u32Num, uint32_t *pu32Index)
+{
+    bool bRetval = false;
+    BaseType_t xParamLen = 0;
+    const char *pcParam = FreeRTOS_CLIGetParameter(pcCommandString, uxParam, &xParamLen);
+
+    for (uint32_t i = 0; (pcParam != NULL) && (i < u32Num); i++)
+    {
+        if ((strlen(pcNames[i]) == (size_t)xParamLen) && (strncmp(pcParam, pcNames[i], xParamLen) == 0))
+        {
+            *pu32Index = i;
+            bRetval = true;
+            break;
+        }
+    }
+
+    return bRetval;
+}
+
+static void _print_param(uint8_t u8Id)
+{
+    const cv_param_desc_t *pxDesc = cv_param_get_desc(u8Id);
+    int32_t i32Value = cv_param_get(u8Id);
+
+    if (pxDesc->names != NULL)
+    {
+        vCliPrintf(CLI_TASK_NAME, "%s %s", pxDesc->name, pxDesc->names[i32Value]);
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "%s %d (%u-%u)", pxDesc->name, i32Value, pxDesc->min, pxDesc->max);
+    }
+}
+
+static BaseType_t userParamGet(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    BaseType_t xParamLen = 0;
+    const char *pcParam = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen);
+    uint8_t u8Id = 0U;
+
+    if (pcParam == NULL)
+    {
+        for (uint8_t i = 0; i < CV_PARAM_NUM; i++)
+        {
+            _print_param(i);
+        }
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else if (cv_param_find(pcParam, (size_t)xParamLen, &u8Id))
+    {
+        _print_param(u8Id);
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userParamSet(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    BaseType_t xNameLen = 0;
+    BaseType_t xValueLen = 0;
+    const char *pcName = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xNameLen);
+    const char *pcValue = FreeRTOS_CLIGetParameter(pcCommandString, 2, &xValueLen);
+    uint8_t u8Id = 0U;
+    int32_t i32Value = 0;
+
+    if ((pcName != NULL) && (pcValue != NULL) &&
+        cv_param_find(pcName, (size_t)xNameLen, &u8Id) &&
+        cv_param_parse(u8Id, pcValue, (size_t)xValueLen, &i32Value) &&
+        cv_param_set(u8Id, i32Value))
+    {
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userGateMap(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32Note = 0;
+    uint32_t u32Mask = 0;
+
+    if (_get_param_u32(pcCommandString, 1, &u32Note) &&
+        _get_param_u32(pcCommandString, 2, &u32Mask) &&
+        (u32Note < MIDI_NOTE_NUM) &&
+        (u32Mask < (1UL << CV_GATE_NUM)))
+    {
+        cv_preset_t *pxPreset = _edit_preset();
+        pxPreset->engine.gate_map[u32Note] = (uint8_t)u32Mask;
+        cv_preset_publish();
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userGateOut(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32Out = 0;
+    uint32_t u32Type = 0;
+    uint32_t u32Len = 0;
+    uint32_t u32Accent = 0;
+
+    if (_get_param_u32(pcCommandString, 1, &u32Out) &&
+        _get_param_name(pcCommandString, 2, pcGateNames, CV_GATE_TYPE_NUM, &u32Type) &&
+        _get_param_u32(pcCommandString, 3, &u32Len) &&
+        _get_param_u32(pcCommandString, 4, &u32Accent) &&
+        (u32Out < CV_GATE_NUM) &&
+        (u32Len <= CV_GATE_LEN_MAX_MS) &&
+        (u32Accent <= UINT8_MAX))
+    {
+        cv_preset_t *pxPreset = _edit_preset();
+        cv_gate_cfg_t *pxGate = &pxPreset->engine.gate[u32Out];
+        pxGate->type = (uint8_t)u32Type;
+        pxGate->len_ticks = (uint16_t)CV_MS_TO_TICKS(u32Len);
+        pxGate->accent_vel = (uint8_t)u32Accent;
+        cv_preset_publish();
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userClock(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32Out[3] = {0};
+    uint32_t u32Div = 0;
+    uint32_t u32Mul = 0;
+
+    if (_get_param_u32(pcCommandString, 1, &u32Out[0]) &&
+        _get_param_u32(pcCommandString, 2, &u32Out[1]) &&
+        _get_param_u32(pcCommandString, 3, &u32Out[2]) &&
+        _get_param_u32(pcCommandString, 4, &u32Div) &&
+        _get_param_u32(pcCommandString, 5, &u32Mul) &&
+        (u32Div != 0U) && (u32Div <= CV_CLOCK_DIV_MAX) &&
+        (u32Mul != 0U) && (u32Mul <= CV_CLOCK_MUL_MAX))
+    {
+        cv_preset_t *pxPreset = _edit_preset();
+        cv_clock_cfg_t *pxClock = &pxPreset->clock;
+        pxClock->clock_out = (u32Out[0] < CV_GATE_NUM) ? (uint8_t)u32Out[0] : CV_CLOCK_OUT_NONE;
+        pxClock->run_out = (u32Out[1] < CV_GATE_NUM) ? (uint8_t)u32Out[1] : CV_CLOCK_OUT_NONE;
+        pxClock->reset_out = (u32Out[2] < CV_GATE_NUM) ? (uint8_t)u32Out[2] : CV_CLOCK_OUT_NONE;
+        pxClock->div = (uint8_t)u32Div;
+        pxClock->mul = (uint8_t)u32Mul;
+        cv_preset_publish();
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userGetBpm(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32PeriodUs = (cv_clock_get_period() + 128U) >> 8;
+
+    if (u32PeriodUs != 0U)
+    {
+        /* Tenths of BPM, 60 s / (24 clocks * period) */
+        uint32_t u32Bpm = 25000000UL / u32PeriodUs;
+        vCliPrintf(CLI_TASK_NAME, "BPM: %u.%u %s", u32Bpm / 10U, u32Bpm % 10U,
+                cv_clock_is_running() ? "run" : "stop");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "BPM: no clock");
+    }
+    vCliPrintf(CLI_TASK_NAME, "OK");
+
+    return pdFALSE;
+}
+
+static BaseType_t userCtrlMap(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32Out = 0;
+    uint32_t u32Src = 0;
+    uint32_t u32Num = 0;
+    uint32_t u32Smooth = 0;
+    uint32_t u32Curve = 0;
+    cv_ctrl_out_cfg_t xCfg;
+
+    if (_get_param_u32(pcCommandString, 1, &u32Out) &&
+        _get_param_name(pcCommandString, 2, pcCtrlSrcNames, CV_CTRL_SRC_NUM, &u32Src) &&
+        _get_param_u32(pcCommandString, 3, &u32Num) &&
+        _get_param_u32(pcCommandString, 4, &u32Smooth) &&
+        _get_param_name(pcCommandString, 5, pcCurveNames, CV_CURVE_NUM, &u32Curve) &&
+        (u32Out < CV_ANALOG_NUM) &&
+        (u32Num <= UINT16_MAX) &&
+        (u32Smooth <= UINT8_MAX))
+    {
+        xCfg.src = (uint8_t)u32Src;
+        xCfg.number = (uint16_t)u32Num;
+        xCfg.smooth = (uint8_t)u32Smooth;
+        xCfg.curve = (uint8_t)u32Curve;
+
+        if (cv_ctrl_check_output(&xCfg))
+        {
+            _edit_preset()->ctrl[u32Out] = xCfg;
+            cv_preset_publish();
+            vCliPrintf(CLI_TASK_NAME, "OK");
+        }
+        else
+        {
+            vCliPrintf(CLI_TASK_NAME, "Invalid controller");
+        }
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userCurve(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32InStart = 0;
+    uint32_t u32InEnd = 0;
+    uint32_t u32OutStart = 0;
+    uint32_t u32OutEnd = 0;
+
+    if (_get_param_u32(pcCommandString, 1, &u32InStart) &&
+        _get_param_u32(pcCommandString, 2, &u32InEnd) &&
+        _get_param_u32(pcCommandString, 3, &u32OutStart) &&
+        _get_param_u32(pcCommandString, 4, &u32OutEnd) &&
+        (u32InEnd < CV_CURVE_SIZE) &&
+        (u32OutStart <= CV_CODE_MAX) &&
+        (u32OutEnd <= CV_CODE_MAX) &&
+        cv_curve_set_user((uint8_t)u32InStart, (uint8_t)u32InEnd, (uint16_t)u32OutStart, (uint16_t)u32OutEnd))
+    {
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userLfo(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32Lfo = 0;
+    uint32_t u32Wave = 0;
+    uint32_t u32Out = 0;
+    uint32_t u32Clocks = 0;
+    uint32_t u32Depth = 0;
+
+    if (_get_param_u32(pcCommandString, 1, &u32Lfo) &&
+        _get_param_name(pcCommandString, 2, pcLfoNames, CV_LFO_WAVE_NUM, &u32Wave) &&
+        _get_param_u32(pcCommandString, 3, &u32Out) &&
+        _get_param_u32(pcCommandString, 4, &u32Clocks) &&
+        _get_param_u32(pcCommandString, 5, &u32Depth) &&
+        (u32Lfo < CV_LFO_NUM) &&
+        (u32Clocks != 0U) && (u32Clocks <= CV_LFO_CLOCKS_MAX) &&
+        (u32Depth <= ((u32Out == CV_ANALOG_NUM) ? CV_LFO_VIBRATO_MAX : CV_CODE_MAX)))
+    {
+        cv_preset_t *pxPreset = _edit_preset();
+        cv_lfo_cfg_t *pxLfo = &pxPreset->lfo[u32Lfo];
+        pxLfo->wave = (uint8_t)u32Wave;
+        pxLfo->clocks = (uint16_t)u32Clocks;
+        pxLfo->depth = (uint16_t)u32Depth;
+        if (u32Out < CV_ANALOG_NUM)
+        {
+            pxLfo->out = (uint8_t)u32Out;
+        }
+        else
+        {
+            pxLfo->out = (u32Out == CV_ANALOG_NUM) ? CV_LFO_OUT_PITCH : CV_LFO_OUT_NONE;
+        }
+        cv_preset_publish();
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static BaseType_t userEnv(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32Param[8] = {0};
+    bool bValid = true;
+
+    for (UBaseType_t i = 0; (i < 8U) && bValid; i++)
+    {
+        bValid = _get_param_u32(pcCommandString, i + 1U, &u32Param[i]);
+    }
+
+    if (bValid &&
+        (u32Param[0] < CV_ENV_NUM) &&
+        (u32Param[2] < CV_GATE_NUM) &&
+        (u32Param[3] <= CV_ENV_TIME_MAX_MS) &&
+        (u32Param[4] <= CV_ENV_TIME_MAX_MS) &&
+        (u32Param[5] <= CV_CODE_MAX) &&
+        (u32Param[6] <= CV_ENV_TIME_MAX_MS) &&
+        (u32Param[7] <= 1U))
+    {
+        cv_preset_t *pxPreset = _edit_preset();
+        cv_env_cfg_t *pxEnv = &pxPreset->env[u32Param[0]];
+        pxEnv->out = (u32Param[1] < CV_ANALOG_NUM) ? (uint8_t)u32Param[1] : CV_ENV_OUT_NONE;
+        pxEnv->gate = (uint8_t)u32Param[2];
+        pxEnv->attack_ms = (uint16_t)u32Param[3];
+        pxEnv->decay_ms = (uint16_t)u32Param[4];
+        pxEnv->sustain = (uint16_t)u32Param[5];
+        pxEnv->release_ms = (uint16_t)u32Param[6];
+        pxEnv->velocity = (u32Param[7] != 0U);
+        cv_preset_publish();
+        vCliPrintf(CLI_TASK_NAME, "OK");
+    }
+    else
+    {
+        vCliPrintf(CLI_TASK_NAME, "Invalid param");
+    }
+
+    return pdFALSE;
+}
+
+static cv_preset_t *_edit_preset(void)
+{
+    cv_preset_t *pxPreset;
+
+    vCvTaskWaitPreset();
+    pxPreset = cv_preset_edit();
+    USER_ASSERT(pxPreset != NULL);
+
+    return pxPreset;
+}
+
+static bool _get_param_i16(const char *pcCommandString, UBaseType_t uxParam, int16_t *pi16Value)
+{
+    bool bRetval = false;
+    uint32_t u32Value = 0;
+
+    /* Negative numbers wrap on unsigned conversion */
+    if (_get_param_u32(pcCommandString, uxParam, &u32Value) &&
+        ((int32_t)u32Value >= INT16_MIN) && ((int32_t)u32Value <= INT16_MAX))
+    {
+        *pi16Value = (int16_t)(int32_t)u32Value;
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+static BaseType_t userCal(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32Op = 0;
+    uint32_t u32Param[5] = {0};
+    int16_t i16Offset = 0;
+    BaseType_t xParamLen = 0;
+    bool bValid = false;
+    bool bBusy = false;
+
+    if (FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen) == NULL)
+    {
+        const cv_cal_data_t *pxCal = cv_cal_get();
+
+        vCliPrintf(CLI_TASK_NAME, "Record: %u", cv_cal_get_seq());
+        for (uint8_t i = 0; (pxCal != NULL) && (i < CV_ANALOG_NUM); i++)
+        {
+            vCliPrintf(CLI_TASK_NAME, "Out %u: offset %d gain %u C4 %u",
+                       i, pxCal->offset[i], pxCal->gain[i], pxCal->note[i][60]);
+        }
+        bValid = true;
+    }
+    else if (_get_param_name(pcCommandString, 1, pcCalNames, sizeof(pcCalNames) / sizeof(pcCalNames[0]), &u32Op))
+    {
+        for (UBaseType_t i = 0; i < 5U; i++)
+        {
+            (void)_get_param_u32(pcCommandString, i + 2U, &u32Param[i]);
+        }
+
+        if (u32Op == 0U)
+        {
+            bValid = _get_param_i16(pcCommandString, 3, &i16Offset) &&
+                     (u32Param[0] <= UINT8_MAX) && (u32Param[2] <= UINT16_MAX) &&
+                     cv_cal_set_output((uint8_t)u32Param[0], i16Offset, (uint16_t)u32Param[2]);
+        }
+        else if (u32Op == 1U)
+        {
+            bValid = (u32Param[0] <= UINT8_MAX) && (u32Param[1] <= UINT8_MAX) && (u32Param[2] <= CV_CODE_MAX) &&
+                     cv_cal_set_note((uint8_t)u32Param[0], (uint8_t)u32Param[1], (uint16_t)u32Param[2]);
+        }
+        else if (u32Op == 2U)
+        {
+            bValid = (u32Param[0] <= UINT8_MAX) &&
+                     (u32Param[1] <= UINT8_MAX) && (u32Param[2] <= CV_CODE_MAX) &&
+                     (u32Param[3] <= UINT8_MAX) && (u32Param[4] <= CV_CODE_MAX) &&
+                     cv_cal_set_scale((uint8_t)u32Param[0], (uint8_t)u32Param[1], (uint16_t)u32Param[2],
+                                      (uint8_t)u32Param[3], (uint16_t)u32Param[4]);
+        }
+        else if (cv_cal_need_reclaim() && !bCvTaskIsIdle())
+        {
+            /* Erase would stall the outputs, idle reclaim clears the page */
+            bBusy = true;
+        }
+        else
+        {
+            bValid = cv_cal_reclaim() && cv_cal_save();
+        }
+    }
+    else
+    {
+        /* Unknown operation */
+    }
+
+    vCliPrintf(CLI_TASK_NAME, bBusy ? "Busy, outputs active" : (bValid ? "OK" : "Invalid param"));
+
+    return pdFALSE;
+}
+
+static BaseType_t userPreset(char *pcWriteBuffer,
+        size_t xWriteBufferLen,
+        const char *pcCommandString)
+{
+    uint32_t u32Op = 0;
+    uint32_t u32Preset = 0;
+    bool bValid = false;
+
+    if (_get_param_name(pcCommandString, 1, pcPresetNames, sizeof(pcPresetNames) / sizeof(pcPresetNames[0]), &u32Op) &&
+        _get_param_u32(pcCommandString, 2, &u32Preset) &&
+        (u32Preset < CV_PRESET_NUM))
+    {
+        if (u32Op == 0U)
+        {
+            vCvTaskWaitPreset();
+            bValid = cv_preset_save((uint8_t)u32Preset);
+        }
+        else
+        {
+            bValid = cv_preset_load((uint8_t)u32Preset);
+        }
+    }
+
+    vCliPrintf(CLI_TASK_NAME, bValid ? "OK" : "Invalid param");
+
+    return pdFALSE;
+}
+
 /* Public application code ---------------------------------------------------*/
 
 void cli_cmd_init(void)
 {
-    (void)FreeRTOS_CLIRegisterCommand(&xUserReset);
-    (void)FreeRTOS_CLIRegisterCommand(&xUserAssert);
-    (void)FreeRTOS_CLIRegisterCommand(&xUserFault);
-    (void)FreeRTOS_CLIRegisterCommand(&xUserTime);
+    (void)FreeRTOS_CLIRegisterCommandTable(xUserCommands, sizeof(xUserCommands) / sizeof(xUserCommands[0]));
+}
+
+void cli_cmd_telemetry(void)
+{
+    UBaseType_t uxNum = uxTaskGetSystemState(xTaskStatus, CLI_TOP_TASKS, NULL);
+
+    for (UBaseType_t i = 0; i < uxNum; i++)
+    {
+        vCliPrintf(CLI_TASK_NAME, "%s: stack min free %u words", xTaskStatus[i].pcTaskName, xTaskStatus[i].usStackHighWaterMark);
+    }
+
+    /* Interrupts run on the main stack once the scheduler starts */
+    vCliPrintf(CLI_TASK_NAME, "main: stack min free %u of %u bytes", SYS_MCU_GetStackFree(), SYS_MCU_GetStackSize());
 }
 
 /* EOF */
@@ -0,0 +1,500 @@
+/**
+ * @file    cli_proto.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Binary control and telemetry protocol sharing the CLI serial.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "cli_proto.h"
+#include "cli_task.h"
+#include "cv_engine.h"
+#include "cv_curve.h"
+#include "cv_param.h"
+#include "cv_preset.h"
+#include "cv_task.h"
+#include "midi_lib.h"
+#include "sys_crc.h"
+#include "sys_rtos.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+
+/* Frame fields around the payload */
+#define PROTO_HEADER_SIZE   2U
+#define PROTO_CRC_SIZE      4U
+
+/* Decoded frame size */
+#define PROTO_FRAME_MAX     (PROTO_HEADER_SIZE + CLI_PROTO_PAYLOAD_MAX + PROTO_CRC_SIZE)
+
+/* Encoded frame size, a code byte every 254 bytes and both delimiters */
+#define PROTO_ENCODED_MAX   (PROTO_FRAME_MAX + (PROTO_FRAME_MAX / 254U) + 3U)
+
+/* Longest COBS block */
+#define PROTO_COBS_BLOCK    0xFFU
+
+/* Size of a parameter on get replies and set requests */
+#define PROTO_PARAM_SIZE    6U
+
+/* Table write header, table and first entry */
+#define PROTO_TABLE_HEADER  3U
+
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+
+/** Frame being received, decoded in place */
+static uint8_t u8RxFrame[PROTO_FRAME_MAX];
+static uint32_t u32RxLen = 0U;
+
+/** Input is between delimiters */
+static bool bRxOn = false;
+
+/** Frame is too long, dropped up to its closing delimiter */
+static bool bRxDiscard = false;
+
+/** Code of the COBS block being decoded, 0 before the first one */
+static uint8_t u8RxCode = 0U;
+
+/** Bytes left on the COBS block being decoded */
+static uint8_t u8RxLeft = 0U;
+
+/** Reply being built and its encoding */
+static uint8_t u8TxFrame[PROTO_FRAME_MAX];
+static uint8_t u8TxEncoded[PROTO_ENCODED_MAX];
+
+/** Telemetry frame sequence */
+static uint8_t u8TelemetrySeq = 0U;
+
+/** User curve copy patched by table writes, too large for the CLI stack */
+static uint16_t u16CurveTable[CV_CURVE_SIZE];
+
+/** Frame counters */
+static uint32_t u32FramesOk = 0U;
+static uint32_t u32FramesCrc = 0U;
+static uint32_t u32FramesDropped = 0U;
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Add a byte to the frame being received, COBS decoded.
+ * @param  u8Data received byte, not a delimiter.
+ * @retval None.
+ */
+static void _proto_decode(uint8_t u8Data);
+
+/**
+ * @brief  Check a complete frame and run it.
+ * @retval None.
+ */
+static void _proto_frame(void);
+
+/**
+ * @brief  Add CRC to a frame on u8TxFrame, encode and send it.
+ * @param  u32Len frame length without CRC.
+ * @retval None.
+ */
+static void _proto_send(uint32_t u32Len);
+
+/**
+ * @brief  Run a request.
+ * @param  u8Type frame type.
+ * @param  pu8Data payload.
+ * @param  u32Len payload length.
+ * @param  pu8Reply where to write the reply payload.
+ * @param  pu32ReplyLen reply payload length.
+ * @retval reply status.
+ */
+static cli_proto_status_t _proto_request(uint8_t u8Type, const uint8_t *pu8Data, uint32_t u32Len, uint8_t *pu8Reply, uint32_t *pu32ReplyLen);
+
+/**
+ * @brief  Write consecutive entries of a table.
+ * @param  pu8Data table, first entry and entries.
+ * @param  u32Len data length.
+ * @retval reply status.
+ */
+static cli_proto_status_t _proto_table_write(const uint8_t *pu8Data, uint32_t u32Len);
+
+/**
+ * @brief  Little endian field access.
+ */
+static uint16_t _get_u16(const uint8_t *pu8Data);
+static uint32_t _get_u32(const uint8_t *pu8Data);
+static void _put_u16(uint8_t *pu8Data, uint16_t u16Value);
+static void _put_u32(uint8_t *pu8Data, uint32_t u32Value);
+
+/* Private application code --------------------------------------------------*/
+
+static void _proto_decode(uint8_t u8Data)
+{
+    bool bZero = false;
+    bool bData = false;
+
+    if (u8RxLeft == 0U)
+    {
+        /* Code byte, blocks shorter than the longest one ended on a zero */
+        bZero = (u8RxCode != 0U) && (u8RxCode != PROTO_COBS_BLOCK);
+        u8RxCode = u8Data;
+        u8RxLeft = u8Data - 1U;
+    }
+    else
+    {
+        bData = true;
+        u8RxLeft--;
+    }
+
+    if ((u32RxLen + (bZero ? 1U : 0U) + (bData ? 1U : 0U)) > PROTO_FRAME_MAX)
+    {
+        /* Too long, the rest of it is not text either */
+        u32FramesDropped++;
+        bRxDiscard = true;
+    }
+    else
+    {
+        if (bZero)
+        {
+            u8RxFrame[u32RxLen++] = 0U;
+        }
+        if (bData)
+        {
+            u8RxFrame[u32RxLen++] = u8Data;
+        }
+    }
+}
+
+static void _proto_frame(void)
+{
+    uint32_t u32Len = u32RxLen - PROTO_CRC_SIZE;
+
+    if ((u8RxLeft != 0U) || (u32RxLen < (PROTO_HEADER_SIZE + PROTO_CRC_SIZE)))
+    {
+        /* Block cut short or no room for the header */
+        u32FramesDropped++;
+    }
+    else if (SYS_CRC_Calc(u8RxFrame, u32Len) != _get_u32(&u8RxFrame[u32Len]))
+    {
+        u32FramesCrc++;
+    }
+    else
+    {
+        uint32_t u32ReplyLen = 0U;
+
+        u32FramesOk++;
+
+        u8TxFrame[0] = u8RxFrame[0] | CLI_PROTO_REPLY;
+        u8TxFrame[1] = u8RxFrame[1];
+        u8TxFrame[2] = (uint8_t)_proto_request(u8RxFrame[0], &u8RxFrame[PROTO_HEADER_SIZE], u32Len - PROTO_HEADER_SIZE,
+                                               &u8TxFrame[PROTO_HEADER_SIZE + 1U], &u32ReplyLen);
+        _proto_send(PROTO_HEADER_SIZE + 1U + u32ReplyLen);
+    }
+}
+
+static void _proto_send(uint32_t u32Len)
+{
+    uint32_t u32Out = 0U;
+    uint32_t u32CodePos;
+    uint8_t u8Code = 1U;
+
+    _put_u32(&u8TxFrame[u32Len], SYS_CRC_Calc(u8TxFrame, u32Len));
+    u32Len += PROTO_CRC_SIZE;
+
+    /* COBS, each code byte tells where the next zero was */
+    u8TxEncoded[u32Out++] = CLI_PROTO_DELIM;
+    u32CodePos = u32Out++;
+
+    for (uint32_t i = 0; i < u32Len; i++)
+    {
+        if (u8TxFrame[i] == 0U)
+        {
+            u8TxEncoded[u32CodePos] = u8Code;
+            u32CodePos = u32Out++;
+            u8Code = 1U;
+        }
+        else
+        {
+            u8TxEncoded[u32Out++] = u8TxFrame[i];
+            u8Code++;
+
+            if (u8Code == PROTO_COBS_BLOCK)
+            {
+                u8TxEncoded[u32CodePos] = u8Code;
+                u32CodePos = u32Out++;
+                u8Code = 1U;
+            }
+        }
+    }
+
+    u8TxEncoded[u32CodePos] = u8Code;
+    u8TxEncoded[u32Out++] = CLI_PROTO_DELIM;
+
+    vCliWrite(u8TxEncoded, u32Out);
+}
+
+static cli_proto_status_t _proto_request(uint8_t u8Type, const uint8_t *pu8Data, uint32_t u32Len, uint8_t *pu8Reply, uint32_t *pu32ReplyLen)
+{
+    cli_proto_status_t eStatus = CLI_PROTO_OK;
+    uint32_t u32Out = 0U;
+
+    if (u8Type == CLI_PROTO_PING)
+    {
+        pu8Reply[u32Out++] = CLI_PROTO_VERSION;
+        _put_u32(&pu8Reply[u32Out], u32FramesOk);
+        _put_u32(&pu8Reply[u32Out + 4U], u32FramesCrc);
+        _put_u32(&pu8Reply[u32Out + 8U], u32FramesDropped);
+        u32Out += 12U;
+        memcpy(&pu8Reply[u32Out], MAIN_APP_VERSION, sizeof(MAIN_APP_VERSION) - 1U);
+        u32Out += sizeof(MAIN_APP_VERSION) - 1U;
+    }
+    else if (u8Type == CLI_PROTO_PARAM_GET)
+    {
+        /* Reply holds value and id of each one */
+        if (((u32Len % 2U) != 0U) || ((u32Len / 2U) > ((CLI_PROTO_PAYLOAD_MAX - 1U) / PROTO_PARAM_SIZE)))
+        {
+            eStatus = CLI_PROTO_ERR_LEN;
+        }
+
+        for (uint32_t i = 0; (i < u32Len) && (eStatus == CLI_PROTO_OK); i += 2U)
+        {
+            uint16_t u16Id = _get_u16(&pu8Data[i]);
+
+            eStatus = (u16Id < CV_PARAM_NUM) ? CLI_PROTO_OK : CLI_PROTO_ERR_ID;
+            if (eStatus == CLI_PROTO_OK)
+            {
+                _put_u16(&pu8Reply[u32Out], u16Id);
+                _put_u32(&pu8Reply[u32Out + 2U], (uint32_t)cv_param_get((uint8_t)u16Id));
+                u32Out += PROTO_PARAM_SIZE;
+            }
+        }
+    }
+    else if (u8Type == CLI_PROTO_PARAM_SET)
+    {
+        uint8_t u8Applied = 0U;
+
+        if ((u32Len % PROTO_PARAM_SIZE) != 0U)
+        {
+            eStatus = CLI_PROTO_ERR_LEN;
+        }
+
+        /* Applied in order up to the first one rejected, the engine sees
+           them all at once */
+        cv_param_begin();
+        for (uint32_t i = 0; (i < u32Len) && (eStatus == CLI_PROTO_OK); i += PROTO_PARAM_SIZE)
+        {
+            uint16_t u16Id = _get_u16(&pu8Data[i]);
+
+            if (u16Id >= CV_PARAM_NUM)
+            {
+                eStatus = CLI_PROTO_ERR_ID;
+            }
+            else if (!cv_param_set((uint8_t)u16Id, (int32_t)_get_u32(&pu8Data[i + 2U])))
+            {
+                eStatus = CLI_PROTO_ERR_VALUE;
+            }
+            else
+            {
+                u8Applied++;
+            }
+        }
+        cv_param_end();
+
+        pu8Reply[u32Out++] = u8Applied;
+    }
+    else if (u8Type == CLI_PROTO_TABLE_WRITE)
+    {
+        eStatus = _proto_table_write(pu8Data, u32Len);
+    }
+    else if (u8Type == CLI_PROTO_STREAM)
+    {
+        uint16_t u16Period = (u32Len == 2U) ? _get_u16(pu8Data) : 0U;
+
+        if (u32Len != 2U)
+        {
+            eStatus = CLI_PROTO_ERR_LEN;
+        }
+        else if ((u16Period != 0U) && (u16Period < CLI_PROTO_STREAM_MIN_MS))
+        {
+            eStatus = CLI_PROTO_ERR_VALUE;
+        }
+        else
+        {
+            vCliSetStream(u16Period);
+        }
+    }
+    else
+    {
+        eStatus = CLI_PROTO_ERR_TYPE;
+    }
+
+    *pu32ReplyLen = u32Out;
+
+    return eStatus;
+}
+
+static cli_proto_status_t _proto_table_write(const uint8_t *pu8Data, uint32_t u32Len)
+{
+    cli_proto_status_t eStatus = CLI_PROTO_OK;
+    uint32_t u32First = (u32Len >= PROTO_TABLE_HEADER) ? _get_u16(&pu8Data[1]) : 0U;
+    const uint8_t *pu8Entries = &pu8Data[PROTO_TABLE_HEADER];
+    uint32_t u32Bytes = (u32Len >= PROTO_TABLE_HEADER) ? (u32Len - PROTO_TABLE_HEADER) : 0U;
+
+    if (u32Len < PROTO_TABLE_HEADER)
+    {
+        eStatus = CLI_PROTO_ERR_LEN;
+    }
+    else if (pu8Data[0] == CLI_PROTO_TABLE_GATE_MAP)
+    {
+        cv_preset_t *pxPreset = NULL;
+
+        if ((u32First + u32Bytes) > MIDI_NOTE_NUM)
+        {
+            eStatus = CLI_PROTO_ERR_VALUE;
+        }
+
+        for (uint32_t i = 0; (i < u32Bytes) && (eStatus == CLI_PROTO_OK); i++)
+        {
+            eStatus = (pu8Entries[i] < (1U << CV_GATE_NUM)) ? CLI_PROTO_OK : CLI_PROTO_ERR_VALUE;
+        }
+
+        if (eStatus == CLI_PROTO_OK)
+        {
+            vCvTaskWaitPreset();
+            pxPreset = cv_preset_edit();
+            USER_ASSERT(pxPreset != NULL);
+            memcpy(&pxPreset->engine.gate_map[u32First], pu8Entries, u32Bytes);
+            cv_preset_publish();
+        }
+    }
+    else if (pu8Data[0] == CLI_PROTO_TABLE_USER_CURVE)
+    {
+        if (((u32Bytes % 2U) != 0U) || ((u32First + (u32Bytes / 2U)) > CV_CURVE_SIZE))
+        {
+            eStatus = CLI_PROTO_ERR_VALUE;
+        }
+        else
+        {
+            /* Patched copy is published as a whole */
+            memcpy(u16CurveTable, cv_curve_get_user(), sizeof(u16CurveTable));
+            for (uint32_t i = 0; i < (u32Bytes / 2U); i++)
+            {
+                u16CurveTable[u32First + i] = _get_u16(&pu8Entries[i * 2U]);
+            }
+            cv_curve_load_user(u16CurveTable);
+        }
+    }
+    else
+    {
+        eStatus = CLI_PROTO_ERR_ID;
+    }
+
+    return eStatus;
+}
+
+static uint16_t _get_u16(const uint8_t *pu8Data)
+{
+    return (uint16_t)(pu8Data[0] | ((uint16_t)pu8Data[1] << 8));
+}
+
+static uint32_t _get_u32(const uint8_t *pu8Data)
+{
+    return (uint32_t)pu8Data[0] | ((uint32_t)pu8Data[1] << 8) | ((uint32_t)pu8Data[2] << 16) | ((uint32_t)pu8Data[3] << 24);
+}
+
+static void _put_u16(uint8_t *pu8Data, uint16_t u16Value)
+{
+    pu8Data[0] = (uint8_t)u16Value;
+    pu8Data[1] = (uint8_t)(u16Value >> 8);
+}
+
+static void _put_u32(uint8_t *pu8Data, uint32_t u32Value)
+{
+    pu8Data[0] = (uint8_t)u32Value;
+    pu8Data[1] = (uint8_t)(u32Value >> 8);
+    pu8Data[2] = (uint8_t)(u32Value >> 16);
+    pu8Data[3] = (uint8_t)(u32Value >> 24);
+}
+
+/* Public application code ---------------------------------------------------*/
+
+void cli_proto_init(void)
+{
+    sys_crc_status_t eCrc;
+
+    bRxOn = false;
+    bRxDiscard = false;
+    u32RxLen = 0U;
+
+    eCrc = SYS_CRC_Init();
+    USER_ASSERT(eCrc == SYS_CRC_STATUS_OK);
+}
+
+bool cli_proto_input(uint8_t data)
+{
+    bool bRetval = bRxOn || (data == CLI_PROTO_DELIM);
+
+    if ((data == CLI_PROTO_DELIM) && bRxOn && ((u32RxLen != 0U) || bRxDiscard))
+    {
+        /* Closing delimiter, a frame too long is only counted */
+        if (!bRxDiscard)
+        {
+            _proto_frame();
+        }
+        bRxOn = false;
+        bRxDiscard = false;
+    }
+    else if (data == CLI_PROTO_DELIM)
+    {
+        /* Opening delimiter, or an empty frame that keeps waiting */
+        bRxOn = true;
+        u32RxLen = 0U;
+        u8RxCode = 0U;
+        u8RxLeft = 0U;
+    }
+    else if (bRxOn)
+    {
+        /* Bytes of a frame too long are dropped */
+        if (!bRxDiscard)
+        {
+            _proto_decode(data);
+        }
+    }
+    else
+    {
+        /* CLI text */
+    }
+
+    return bRetval;
+}
+
+void cli_proto_telemetry(void)
+{
+    cv_frame_t xFrame;
+    uint32_t u32Out = PROTO_HEADER_SIZE;
+
+    vCvTaskGetFrame(&xFrame);
+
+    u8TxFrame[0] = CLI_PROTO_TELEMETRY;
+    u8TxFrame[1] = u8TelemetrySeq++;
+    _put_u32(&u8TxFrame[u32Out], SYS_RTOS_GetTimeUs());
+    u32Out += 4U;
+
+    for (uint32_t i = 0; i < CV_ANALOG_NUM; i++)
+    {
+        _put_u16(&u8TxFrame[u32Out], xFrame.analog[i]);
+        u32Out += 2U;
+    }
+
+    u8TxFrame[u32Out++] = xFrame.gates;
+
+    _proto_send(u32Out);
+}
+
+/* EOF */
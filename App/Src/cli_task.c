@@ -6,17 +6,37 @@
   */
 
 /* Includes ------------------------------------------------------------------*/
+#include <string.h>
 #include "cli_task.h"
 #include "sys_serial.h"
 #include "printf.h"
 #include "FreeRTOS_CLI.h"
 #include "cli_cmd.h"
+#include "boot_prof.h"
+#include "cli_proto.h"
+#include "cv_store.h"
+#include "cv_cal.h"
+#include "cv_task.h"
 #ifdef USE_USER_ASSERT
 #include "user_error.h"
 #endif
 
 /* Private includes ----------------------------------------------------------*/
 /* Private typedef -----------------------------------------------------------*/
+
+/** Input line being assembled */
+typedef struct cli_line
+{
+    uint32_t len;           /**< Characters on the input buffer */
+    uint32_t over;          /**< Characters past the input buffer size */
+    uint32_t gap;           /**< Characters left before input lost on an overrun */
+    bool gap_on;            /**< Input has been lost after gap characters */
+    bool overrun;           /**< Line spans lost input */
+    bool cr;                /**< Last character was a carriage return */
+    uint8_t esc;            /**< Escape sequence state */
+    uint8_t hist;           /**< History entries back being edited, 0 for a new line */
+} cli_line_t;
+
 /* Private define ------------------------------------------------------------*/
 
 /* Init message */
@@ -33,6 +53,29 @@
 #define CLI_SIGNAL_RX_DONE  (1UL << 1)
 #define CLI_SIGNAL_RX_IDLE  (1UL << 2)
 #define CLI_SIGNAL_ERROR    (1UL << 3)
+#define CLI_SIGNAL_RX_FULL  (1UL << 4)
+
+/* Input line size, last byte keeps the terminator */
+#define CLI_LINE_MAX        (configCOMMAND_INT_MAX_INPUT_SIZE - 1U)
+
+/* Bytes taken from the serial ring on each read */
+#define CLI_READ_SIZE       (32U)
+
+/* Period to check for idle outputs while a flash page erase is pending */
+#define CLI_RECLAIM_POLL_MS (100U)
+
+/* Lines kept on the history, recalled with up and down arrows */
+#define CLI_HISTORY_NUM     (4U)
+
+/* Line editing characters */
+#define CLI_CHAR_BS         (0x08U)
+#define CLI_CHAR_ESC        (0x1BU)
+#define CLI_CHAR_DEL        (0x7FU)
+
+/* Escape sequence states */
+#define CLI_ESC_NONE        (0U)
+#define CLI_ESC_START       (1U)
+#define CLI_ESC_CSI         (2U)
 
 /* Private macro -------------------------------------------------------------*/
 #ifdef USE_USER_ASSERT
@@ -46,12 +89,34 @@
 TaskHandle_t cli_task_handle = NULL;
 volatile SemaphoreHandle_t cli_serial_mutex = NULL;
 
-static volatile bool ser_tx_done = false;
+static SemaphoreHandle_t cli_tx_done = NULL;
+
+/* Memory telemetry period in ticks, 0 when disabled */
+static TickType_t xTelemetryPeriod = 0U;
+static TickType_t xTelemetryLast = 0U;
+
+/* Binary telemetry period in ticks, 0 when disabled */
+static TickType_t xStreamPeriod = 0U;
+static TickType_t xStreamLast = 0U;
+
+/* Task and mutex memory, no heap is used */
+static StaticTask_t xCliTcb;
+static StackType_t xCliStack[CLI_TASK_STACK];
+static StaticSemaphore_t xCliMutexBuf;
+static StaticSemaphore_t xCliTxDoneBuf;
 
 static char print_output_buffer[CLI_OUTPUT_BUFFER_SIZE];
 static char cCliOutputBuffer[configCOMMAND_INT_MAX_OUTPUT_SIZE];
 static char cInputBuffer[configCOMMAND_INT_MAX_INPUT_SIZE];
 
+/* Line editor state */
+static cli_line_t xLine = {0};
+
+/* Last lines run, written on a circle */
+static char cHistory[CLI_HISTORY_NUM][configCOMMAND_INT_MAX_INPUT_SIZE];
+static uint32_t u32HistoryHead = 0U;
+static uint32_t u32HistoryNum = 0U;
+
 /* Private function prototypes -----------------------------------------------*/
 
 /**
@@ -69,12 +134,63 @@ void _cli_main(void *pvParameters);
 void _event_cb(sys_serial_event_t event);
 
 /**
- * @brief Clear buffer and fill it with 0
+ * @brief Send data and block until transmission ends, serial mutex must be
+ *        taken
  * 
- * @param pu8Buff pointer to buffer to clear
- * @param u32BuffLen size of buffer
+ * @param pu8Data data to send
+ * @param u16Len data length
+ */
+void _send(const uint8_t *pu8Data, uint16_t u16Len);
+
+/**
+ * @brief Pass a character read from the serial ring to the binary protocol
+ *        or to the input line
+ *
+ * @param u8Data received character
+ */
+void _input(uint8_t u8Data);
+
+/**
+ * @brief Add a received character to the input line
+ *
+ * @param u8Data received character
+ */
+void _line_input(uint8_t u8Data);
+
+/**
+ * @brief Get ticks left to the next periodic output
+ *
+ * @param xPeriod output period, 0 when disabled
+ * @param xLast tick of the last output
+ * @return ticks left, portMAX_DELAY when disabled
+ */
+TickType_t _period_wait(TickType_t xPeriod, TickType_t xLast);
+
+/**
+ * @brief Complete input line, run it or report why it is dropped
+ *
  */
-void _clear_buff(char *pcBuff, uint32_t u32BuffLen);
+void _line_end(void);
+
+/**
+ * @brief Replace input line with a line from the history and show it
+ *
+ * @param bOlder true to go back on the history, false to go forward
+ */
+void _line_history(bool bOlder);
+
+/**
+ * @brief Check if input has been lost on the serial ring and note where
+ *
+ * @param u32Pending characters read from the ring but not processed yet
+ */
+void _line_check_overrun(uint32_t u32Pending);
+
+/**
+ * @brief Run command on the input line and print its output
+ *
+ */
+void _run_command(void);
 
 /**
  * @brief Print initial msg
@@ -86,34 +202,238 @@ void _init_msg(void);
 
 void _event_cb(sys_serial_event_t event)
 {
-    BaseType_t wakeTask;
+    BaseType_t wakeTask = pdFALSE;
 
-    if (event == SYS_SERIAL_EVENT_RX_IDLE)
+    if ((event == SYS_SERIAL_EVENT_RX_IDLE) && (cli_task_handle != NULL))
     {
         xTaskNotifyFromISR(cli_task_handle, CLI_SIGNAL_RX_IDLE, eSetBits, &wakeTask);
     }
-    else if (event == SYS_SERIAL_EVENT_ERROR)
+    else if ((event == SYS_SERIAL_EVENT_RX_BUF_FULL) && (cli_task_handle != NULL))
     {
-        ser_tx_done = true;
+        xTaskNotifyFromISR(cli_task_handle, CLI_SIGNAL_RX_FULL, eSetBits, &wakeTask);
     }
-    else if (event == SYS_SERIAL_EVENT_TX_DONE)
+    else if ((event == SYS_SERIAL_EVENT_ERROR) || (event == SYS_SERIAL_EVENT_TX_DONE))
     {
-        ser_tx_done = true;
+        /* Writer blocks on it, run it now instead of on next tick */
+        if (cli_tx_done != NULL)
+        {
+            xSemaphoreGiveFromISR(cli_tx_done, &wakeTask);
+        }
     }
     else
     {
         /* code */
     }
+
+    portYIELD_FROM_ISR(wakeTask);
+}
+
+void _send(const uint8_t *pu8Data, uint16_t u16Len)
+{
+    /* Drop a completion left by an error on a previous transfer */
+    (void)xSemaphoreTake(cli_tx_done, 0U);
+
+    if (SYS_SERIAL_Send(SYS_SERIAL_0, (uint8_t *)pu8Data, u16Len) == SYS_SERIAL_STATUS_OK)
+    {
+        (void)xSemaphoreTake(cli_tx_done, portMAX_DELAY);
+    }
+}
+
+void _input(uint8_t u8Data)
+{
+    /* First character after input lost on the ring, frames count too */
+    if (xLine.gap_on)
+    {
+        if (xLine.gap == 0U)
+        {
+            xLine.overrun = true;
+            xLine.gap_on = false;
+        }
+        else
+        {
+            xLine.gap--;
+        }
+    }
+
+    if (!cli_proto_input(u8Data))
+    {
+        _line_input(u8Data);
+    }
+}
+
+void _line_input(uint8_t u8Data)
+{
+    if (xLine.esc == CLI_ESC_START)
+    {
+        xLine.esc = (u8Data == '[') ? CLI_ESC_CSI : CLI_ESC_NONE;
+    }
+    else if (xLine.esc == CLI_ESC_CSI)
+    {
+        /* Parameters go on until the final byte */
+        if ((u8Data >= 0x40U) && (u8Data <= 0x7EU))
+        {
+            xLine.esc = CLI_ESC_NONE;
+
+            if ((u8Data == 'A') || (u8Data == 'B'))
+            {
+                _line_history(u8Data == 'A');
+            }
+        }
+    }
+    else if ((u8Data == '\n') && xLine.cr)
+    {
+        /* Second half of a CR LF end of line */
+    }
+    else if ((u8Data == '\r') || (u8Data == '\n'))
+    {
+        _line_end();
+    }
+    else if ((u8Data == CLI_CHAR_BS) || (u8Data == CLI_CHAR_DEL))
+    {
+        if (xLine.over != 0U)
+        {
+            xLine.over--;
+        }
+        else if (xLine.len != 0U)
+        {
+            xLine.len--;
+        }
+        else
+        {
+            /* Nothing to delete */
+        }
+    }
+    else if (u8Data == CLI_CHAR_ESC)
+    {
+        xLine.esc = CLI_ESC_START;
+    }
+    else if (u8Data < 0x20U)
+    {
+        /* Other control characters are ignored */
+    }
+    else if (xLine.len < CLI_LINE_MAX)
+    {
+        cInputBuffer[xLine.len++] = (char)u8Data;
+    }
+    else
+    {
+        /* Keep counting so the whole line is reported and dropped */
+        xLine.over++;
+    }
+
+    xLine.cr = (u8Data == '\r');
+}
+
+void _line_end(void)
+{
+    cInputBuffer[xLine.len] = '\0';
+
+    if (xLine.overrun)
+    {
+        vCliPrintf(CLI_TASK_NAME, "Input overrun, line dropped");
+    }
+    else if (xLine.over != 0U)
+    {
+        vCliPrintf(CLI_TASK_NAME, "Line too long, %u chars, max %u, dropped", xLine.len + xLine.over, CLI_LINE_MAX);
+    }
+    else if (xLine.len == 0U)
+    {
+        vCliPrintf(CLI_TASK_NAME, "$");
+    }
+    else
+    {
+        /* Repeated lines take a single entry */
+        char *pcLast = cHistory[(u32HistoryHead + CLI_HISTORY_NUM - 1U) % CLI_HISTORY_NUM];
+
+        if ((u32HistoryNum == 0U) || (strcmp(pcLast, cInputBuffer) != 0))
+        {
+            memcpy(cHistory[u32HistoryHead], cInputBuffer, xLine.len + 1U);
+            u32HistoryHead = (u32HistoryHead + 1U) % CLI_HISTORY_NUM;
+            u32HistoryNum = (u32HistoryNum < CLI_HISTORY_NUM) ? (u32HistoryNum + 1U) : CLI_HISTORY_NUM;
+        }
+
+        _run_command();
+    }
+
+    xLine.len = 0U;
+    xLine.over = 0U;
+    xLine.overrun = false;
+    xLine.hist = 0U;
+}
+
+void _line_history(bool bOlder)
+{
+    if (bOlder && (xLine.hist < u32HistoryNum))
+    {
+        xLine.hist++;
+    }
+    else if (!bOlder && (xLine.hist != 0U))
+    {
+        xLine.hist--;
+    }
+    else
+    {
+        /* Already at the end of the history */
+    }
+
+    if (xLine.hist != 0U)
+    {
+        const char *pcEntry = cHistory[(u32HistoryHead + CLI_HISTORY_NUM - xLine.hist) % CLI_HISTORY_NUM];
+
+        xLine.len = strlen(pcEntry);
+        memcpy(cInputBuffer, pcEntry, xLine.len);
+    }
+    else
+    {
+        xLine.len = 0U;
+    }
+
+    xLine.over = 0U;
+    cInputBuffer[xLine.len] = '\0';
+    vCliPrintf(CLI_TASK_NAME, "$ %s", cInputBuffer);
 }
 
-void _clear_buff(char *pcBuff, uint32_t u32BuffLen)
+void _line_check_overrun(uint32_t u32Pending)
 {
-    while (u32BuffLen-- != 0)
+    uint32_t u32Event = 0U;
+
+    /* Ring is not read while checking, everything on it came before the loss */
+    if ((xTaskNotifyWait(0, CLI_SIGNAL_RX_FULL, &u32Event, 0U) == pdPASS) && ((u32Event & CLI_SIGNAL_RX_FULL) != 0U) && !xLine.gap_on)
     {
-        *pcBuff++ = 0;
+        xLine.gap = u32Pending + SYS_SERIAL_GetReadCount(SYS_SERIAL_0);
+        xLine.gap_on = true;
     }
 }
 
+TickType_t _period_wait(TickType_t xPeriod, TickType_t xLast)
+{
+    TickType_t xWait = portMAX_DELAY;
+
+    if (xPeriod != 0U)
+    {
+        TickType_t xElapsed = xTaskGetTickCount() - xLast;
+
+        xWait = (xElapsed < xPeriod) ? (xPeriod - xElapsed) : 0U;
+    }
+
+    return xWait;
+}
+
+void _run_command(void)
+{
+    BaseType_t xReturned;
+
+    vCliPrintf(CLI_TASK_NAME, "cmd: \"%s\"", cInputBuffer);
+
+    do {
+        /* Most commands print on their own and leave it empty */
+        cCliOutputBuffer[0] = '\0';
+        xReturned = FreeRTOS_CLIProcessCommand(cInputBuffer, cCliOutputBuffer, configCOMMAND_INT_MAX_OUTPUT_SIZE);
+        cCliOutputBuffer[configCOMMAND_INT_MAX_OUTPUT_SIZE - 1U] = '\0';
+        vCliPrintf(CLI_TASK_NAME, "%s", cCliOutputBuffer);
+    } while(xReturned != pdFALSE);
+}
+
 void _init_msg(void)
 {
     vCliRawPrintf(CLI_EOL);
@@ -135,18 +455,16 @@ void _init_msg(void)
 
 void _cli_main( void *pvParameters )
 {
-    uint8_t u8RxData = 0;
-    uint32_t i_rx_buff = 0;
+    uint8_t u8RxData[CLI_READ_SIZE];
+    uint16_t u16Read;
     uint32_t tmp_event;
 
     /* Register used functions */
     cli_cmd_init();
 
-    /* Init delay to for pow stabilization */
-    vTaskDelay(pdMS_TO_TICKS(500U));
-
-    /* Start message */
+    /* Start message, outputs are already running */
     _init_msg();
+    boot_prof_mark(BOOT_PROF_BANNER);
 
     /* Show init msg */
     vCliPrintf(CLI_TASK_NAME, "Init");
@@ -154,50 +472,71 @@ void _cli_main( void *pvParameters )
     /* Infinite loop */
     for(;;)
     {
-        BaseType_t event_wait = xTaskNotifyWait(0, CLI_SIGNAL_RX_IDLE, &tmp_event, portMAX_DELAY);
-        if (event_wait == pdPASS)
+        /* Wake up for the first telemetry output due */
+        TickType_t xWait = _period_wait(xTelemetryPeriod, xTelemetryLast);
+        TickType_t xStreamWait = _period_wait(xStreamPeriod, xStreamLast);
+
+        xWait = (xStreamWait < xWait) ? xStreamWait : xWait;
+
+        /* Flash erase stalls the outputs, spare pages wait for them to be idle */
+        if ((cv_store_need_reclaim() || cv_cal_need_reclaim()) && (xWait > pdMS_TO_TICKS(CLI_RECLAIM_POLL_MS)))
+        {
+            xWait = pdMS_TO_TICKS(CLI_RECLAIM_POLL_MS);
+        }
+
+        BaseType_t event_wait = xTaskNotifyWait(0, CLI_SIGNAL_RX_IDLE | CLI_SIGNAL_RX_FULL, &tmp_event, xWait);
+
+        if ((xTelemetryPeriod != 0U) && ((xTaskGetTickCount() - xTelemetryLast) >= xTelemetryPeriod))
+        {
+            xTelemetryLast = xTaskGetTickCount();
+            cli_cmd_telemetry();
+        }
+
+        if ((xStreamPeriod != 0U) && ((xTaskGetTickCount() - xStreamLast) >= xStreamPeriod))
         {
-            /* Fill input buffer */
-            while (SYS_SERIAL_Read(SYS_SERIAL_0, &u8RxData, 1U) != 0)
+            /* Keep the period, unless more than one output was missed */
+            xStreamLast += xStreamPeriod;
+            if ((xTaskGetTickCount() - xStreamLast) >= xStreamPeriod)
             {
-                /* End of command detected */
-                if ((u8RxData == '\r') || (u8RxData == '\n'))
-                {
-                    if (i_rx_buff != 0)
-                    {
-                        vCliPrintf(CLI_TASK_NAME, "cmd: \"%s\"", cInputBuffer);
+                xStreamLast = xTaskGetTickCount();
+            }
+            cli_proto_telemetry();
+        }
 
-                        BaseType_t xReturned;
+        /* Store is only written by this task, nothing else runs on flash meanwhile */
+        if (cv_store_need_reclaim() && bCvTaskIsIdle())
+        {
+            (void)cv_store_reclaim();
+        }
 
-                        do {
-                            xReturned = FreeRTOS_CLIProcessCommand(cInputBuffer, cCliOutputBuffer, configCOMMAND_INT_MAX_OUTPUT_SIZE);
-                            vCliPrintf(CLI_TASK_NAME, "%s", cCliOutputBuffer);
-                            _clear_buff(cCliOutputBuffer, configCOMMAND_INT_MAX_OUTPUT_SIZE);
-                        } while(xReturned != pdFALSE);
+        if (cv_cal_need_reclaim() && bCvTaskIsIdle())
+        {
+            (void)cv_cal_reclaim();
+        }
 
-                        i_rx_buff = 0;
-                    }
-                    else
-                    {
-                        vCliPrintf(CLI_TASK_NAME, "$", cInputBuffer);
-                    }
+        if (event_wait == pdPASS)
+        {
+            /* Input lost while waiting is right after what the ring holds */
+            if (((tmp_event & CLI_SIGNAL_RX_FULL) != 0U) && !xLine.gap_on)
+            {
+                xLine.gap = SYS_SERIAL_GetReadCount(SYS_SERIAL_0);
+                xLine.gap_on = true;
+            }
 
-                    _clear_buff(cInputBuffer, configCOMMAND_INT_MAX_INPUT_SIZE);
-                }
-                /* Still saving cli command */
-                else
+            /* Assemble lines from the ring, a block at a time */
+            while ((u16Read = SYS_SERIAL_Read(SYS_SERIAL_0, u8RxData, CLI_READ_SIZE)) != 0U)
+            {
+                for (uint16_t i = 0; i < u16Read; i++)
                 {
-                    if (i_rx_buff < configCOMMAND_INT_MAX_INPUT_SIZE)
-                    {
-                        cInputBuffer[i_rx_buff++] = u8RxData;
-                    }
-                    else
+                    bool bEol = ((u8RxData[i] == '\r') || (u8RxData[i] == '\n') || (u8RxData[i] == CLI_PROTO_DELIM));
+
+                    _input(u8RxData[i]);
+
+                    /* A command or frame may have run meanwhile, with no reads */
+                    if (bEol)
                     {
-                        vCliPrintf(CLI_TASK_NAME, "Flush input buffer");
-                        _clear_buff(cInputBuffer, configCOMMAND_INT_MAX_INPUT_SIZE);
-                        i_rx_buff = 0;
+                        _line_check_overrun(u16Read - i - 1U);
                     }
-
                 }
             }
         }
@@ -212,15 +551,17 @@ bool bCliTaskInit(void)
 
     /* Init HW resources */
     (void)SYS_SERIAL_Init(SYS_SERIAL_0, _event_cb);
+    cli_proto_init();
 
-    /* Create mutex */
-    cli_serial_mutex = xSemaphoreCreateMutex();
+    /* Create mutex and transmission end semaphore */
+    cli_serial_mutex = xSemaphoreCreateMutexStatic(&xCliMutexBuf);
+    cli_tx_done = xSemaphoreCreateBinaryStatic(&xCliTxDoneBuf);
 
     /* Create task */
-    xTaskCreate(_cli_main, CLI_TASK_NAME, CLI_TASK_STACK, NULL, CLI_TASK_PRIO, &cli_task_handle);
+    cli_task_handle = xTaskCreateStatic(_cli_main, CLI_TASK_NAME, CLI_TASK_STACK, NULL, CLI_TASK_PRIO, xCliStack, &xCliTcb);
 
     /* Check resources */
-    if ((cli_serial_mutex != NULL) && (cli_task_handle != NULL))
+    if ((cli_serial_mutex != NULL) && (cli_tx_done != NULL) && (cli_task_handle != NULL))
     {
         bRetval = true;
     }
@@ -247,7 +588,6 @@ void vCliPrintf(const char *module_name, const char *Format, ...)
         va_list Args;
 
         /* Print task header */
-        _clear_buff(print_output_buffer, CLI_OUTPUT_BUFFER_SIZE);
         len_data = snprintf(
             (char *)print_output_buffer, 
             CLI_OUTPUT_BUFFER_SIZE, 
@@ -258,29 +598,20 @@ void vCliPrintf(const char *module_name, const char *Format, ...)
 
         if (len_data > 0)
         {
-            ser_tx_done = false;
-            SYS_SERIAL_Send(SYS_SERIAL_0, (uint8_t *)print_output_buffer, len_data);
-            while (ser_tx_done != true)
-            {
-                vTaskDelay(pdMS_TO_TICKS(1U));
-            }
+            _send((uint8_t *)print_output_buffer, len_data);
         }
 
         /* Print cli message */
-        _clear_buff(print_output_buffer, CLI_OUTPUT_BUFFER_SIZE);
         va_start(Args, Format);
         len_data = vsnprintf((char *)print_output_buffer, CLI_OUTPUT_BUFFER_SIZE, Format, Args);
         va_end(Args);
 
+        /* Length is the one needed, a truncated message only has what fits */
+        len_data = (len_data < CLI_OUTPUT_BUFFER_SIZE) ? len_data : (CLI_OUTPUT_BUFFER_SIZE - 1);
+
         if (len_data > 0)
         {
-            SYS_SERIAL_Send(SYS_SERIAL_0, (uint8_t *)print_output_buffer, len_data);
-            ser_tx_done = false;
-            SYS_SERIAL_Send(SYS_SERIAL_0, (uint8_t *)print_output_buffer, len_data);
-            while (ser_tx_done != true)
-            {
-                vTaskDelay(pdMS_TO_TICKS(1U));
-            }
+            _send((uint8_t *)print_output_buffer, len_data);
         }
 
         if (xSemaphoreGive(cli_serial_mutex) != pdTRUE)
@@ -304,16 +635,16 @@ void vCliRawPrintf(const char *Format, ...)
         va_list Args;
 
         /* Print cli message */
-        _clear_buff(print_output_buffer, CLI_OUTPUT_BUFFER_SIZE);
         va_start(Args, Format);
         len_data = vsnprintf((char *)print_output_buffer, CLI_OUTPUT_BUFFER_SIZE, Format, Args);
         va_end(Args);
 
+        /* Length is the one needed, a truncated message only has what fits */
+        len_data = (len_data < CLI_OUTPUT_BUFFER_SIZE) ? len_data : (CLI_OUTPUT_BUFFER_SIZE - 1);
+
         if (len_data > 0)
         {
-            ser_tx_done = false;
-            SYS_SERIAL_Send(SYS_SERIAL_0, (uint8_t *)print_output_buffer, len_data);
-            while (ser_tx_done != true);
+            _send((uint8_t *)print_output_buffer, len_data);
         }
 
         if (xSemaphoreGive(cli_serial_mutex) != pdTRUE)
@@ -323,6 +654,44 @@ void vCliRawPrintf(const char *Format, ...)
     }
 }
 
+void vCliWrite(const uint8_t *pu8Data, uint32_t u32Len)
+{
+    if (cli_serial_mutex != NULL)
+    {
+        if (xSemaphoreTake(cli_serial_mutex, portMAX_DELAY) != pdTRUE)
+        {
+            ERR_ASSERT(0U);
+        }
+
+        /* Serial driver takes up to 16 bit lengths */
+        while (u32Len != 0U)
+        {
+            uint16_t u16Chunk = (u32Len > 0xFFFFU) ? 0xFFFFU : (uint16_t)u32Len;
+
+            _send(pu8Data, u16Chunk);
+            pu8Data += u16Chunk;
+            u32Len -= u16Chunk;
+        }
+
+        if (xSemaphoreGive(cli_serial_mutex) != pdTRUE)
+        {
+            ERR_ASSERT(0U);
+        }
+    }
+}
+
+void vCliSetTelemetry(uint32_t u32PeriodMs)
+{
+    xTelemetryLast = xTaskGetTickCount();
+    xTelemetryPeriod = pdMS_TO_TICKS(u32PeriodMs);
+}
+
+void vCliSetStream(uint32_t u32PeriodMs)
+{
+    xStreamLast = xTaskGetTickCount();
+    xStreamPeriod = pdMS_TO_TICKS(u32PeriodMs);
+}
+
 bool bCliTaskNotify(uint32_t u32Event)
 {
     bool bRetval = false;
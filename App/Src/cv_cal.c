@@ -0,0 +1,389 @@
+/**
+ * @file    cv_cal.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Analog output calibration. Per output offset, gain and note table
+ *          kept on a wear levelled flash store.
+ *
+ *          Records are appended on fixed slots across the calibration pages
+ *          and wrap around. Pages starting inside the next record are erased
+ *          ahead of the save by cv_cal_reclaim, they only hold older records
+ *          so the newest valid record is never lost.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "cv_cal.h"
+#include "crc32.h"
+#include "sys_flash.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+
+/** Flash record, size multiple of flash write size */
+typedef struct cal_record
+{
+    uint32_t magic;         /**< Record marker */
+    uint32_t seq;           /**< Sequence number, newest is highest */
+    cv_cal_data_t data;     /**< Calibration */
+    uint32_t crc;           /**< CRC of all previous fields */
+    uint32_t reserved;      /**< Padding to flash write size */
+} cal_record_t;
+
+/* Private define ------------------------------------------------------------*/
+
+/* Record marker */
+#define CAL_MAGIC               0x4C414356UL
+
+/* Flash area used */
+#define CAL_AREA                SYS_FLASH_AREA_CAL
+
+/* Size of a record */
+#define CAL_RECORD_SIZE         ((uint32_t)sizeof(cal_record_t))
+
+/* Bytes covered by record CRC */
+#define CAL_CRC_SIZE            ((uint32_t)offsetof(cal_record_t, crc))
+
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+
+/** Calibration in use, flash record or RAM copy, NULL when uncalibrated */
+static const cv_cal_data_t * volatile pxCalActive = NULL;
+
+/** RAM copy used while calibrating */
+static cv_cal_data_t xCalEdit;
+
+/** Store position */
+static uint32_t u32CalSeq = 0U;
+static uint32_t u32CalNext = 0U;
+
+/** Pages reached by the next record are blank */
+static bool bCalBlank = false;
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Get record stored on a slot.
+ * @param  slot slot number.
+ * @retval pointer to record in flash.
+ */
+static const cal_record_t *_get_record(uint32_t slot);
+
+/**
+ * @brief  Check record marker and CRC.
+ * @param  record record to check.
+ * @retval true if record is valid.
+ */
+static bool _check_record(const cal_record_t *record);
+
+/**
+ * @brief  Get first page starting inside the next record.
+ * @retval area offset of the page.
+ */
+static uint32_t _get_next_page(void);
+
+/**
+ * @brief  Check if a page is erased.
+ * @param  page area offset of the page.
+ * @retval true if every byte is erased.
+ */
+static bool _check_blank(uint32_t page);
+
+/**
+ * @brief  Get RAM copy to modify, starts from calibration in use.
+ * @retval pointer to RAM copy.
+ */
+static cv_cal_data_t *_get_edit(void);
+
+/**
+ * @brief  Limit a code to output range.
+ * @param  code output code.
+ * @retval limited output code.
+ */
+static uint16_t _clamp(int32_t code);
+
+/* Private application code --------------------------------------------------*/
+
+static const cal_record_t *_get_record(uint32_t slot)
+{
+    const uint8_t *pu8Area = (const uint8_t *)SYS_FLASH_GetAddr(CAL_AREA);
+
+    return (const cal_record_t *)&pu8Area[slot * CAL_RECORD_SIZE];
+}
+
+static bool _check_record(const cal_record_t *record)
+{
+    return (record->magic == CAL_MAGIC) && (record->crc == crc32_calc(record, CAL_CRC_SIZE));
+}
+
+static uint32_t _get_next_page(void)
+{
+    uint32_t u32Offset = u32CalNext * CAL_RECORD_SIZE;
+
+    /* The page holding the record start was cleared for a previous record */
+    return ((u32Offset + SYS_FLASH_PAGE_SIZE - 1U) / SYS_FLASH_PAGE_SIZE) * SYS_FLASH_PAGE_SIZE;
+}
+
+static bool _check_blank(uint32_t page)
+{
+    const uint32_t *pu32Page = (const uint32_t *)((const uint8_t *)SYS_FLASH_GetAddr(CAL_AREA) + page);
+    bool bRetval = true;
+
+    for (uint32_t i = 0; bRetval && (i < (SYS_FLASH_PAGE_SIZE / sizeof(uint32_t))); i++)
+    {
+        bRetval = (pu32Page[i] == UINT32_MAX);
+    }
+
+    return bRetval;
+}
+
+static cv_cal_data_t *_get_edit(void)
+{
+    const cv_cal_data_t *pxActive = pxCalActive;
+
+    if (pxActive == NULL)
+    {
+        /* Ideal outputs */
+        for (uint32_t i = 0; i < CV_ANALOG_NUM; i++)
+        {
+            xCalEdit.offset[i] = 0;
+            xCalEdit.gain[i] = CV_CAL_GAIN_ONE;
+
+            for (uint32_t n = 0; n < MIDI_NOTE_NUM; n++)
+            {
+                xCalEdit.note[i][n] = (uint16_t)(n * CV_CODES_PER_SEMITONE);
+            }
+        }
+        pxCalActive = &xCalEdit;
+    }
+    else if (pxActive != &xCalEdit)
+    {
+        xCalEdit = *pxActive;
+        pxCalActive = &xCalEdit;
+    }
+    else
+    {
+        /* Already editing */
+    }
+
+    return &xCalEdit;
+}
+
+static uint16_t _clamp(int32_t code)
+{
+    if (code < 0)
+    {
+        code = 0;
+    }
+    else if (code > (int32_t)CV_CODE_MAX)
+    {
+        code = (int32_t)CV_CODE_MAX;
+    }
+    else
+    {
+        /* In range */
+    }
+
+    return (uint16_t)code;
+}
+
+/* Public application code ---------------------------------------------------*/
+
+bool cv_cal_init(void)
+{
+    uint32_t u32Slots = SYS_FLASH_GetSize(CAL_AREA) / CAL_RECORD_SIZE;
+    const cal_record_t *pxBest = NULL;
+
+    pxCalActive = NULL;
+    u32CalSeq = 0U;
+    u32CalNext = 0U;
+    bCalBlank = false;
+
+    /* Only headers are read while scanning, CRC is checked on newer records */
+    for (uint32_t i = u32Slots; i != 0U; i--)
+    {
+        const cal_record_t *pxRecord = _get_record(i - 1U);
+
+        if ((pxRecord->magic == CAL_MAGIC) &&
+            (pxRecord->seq != UINT32_MAX) &&
+            (pxRecord->seq > u32CalSeq) &&
+            _check_record(pxRecord))
+        {
+            pxBest = pxRecord;
+            u32CalSeq = pxRecord->seq;
+            u32CalNext = i % u32Slots;
+        }
+    }
+
+    if (pxBest != NULL)
+    {
+        pxCalActive = &pxBest->data;
+    }
+
+    return (pxBest != NULL);
+}
+
+uint16_t cv_cal_pitch(uint8_t out, uint8_t note, int32_t mod)
+{
+    USER_ASSERT(out < CV_ANALOG_NUM);
+    USER_ASSERT(note < MIDI_NOTE_NUM);
+
+    const cv_cal_data_t *pxCal = pxCalActive;
+    int32_t i32Code;
+
+    if (pxCal != NULL)
+    {
+        i32Code = (int32_t)pxCal->note[out][note] + ((mod * (int32_t)pxCal->gain[out]) >> 15);
+    }
+    else
+    {
+        i32Code = ((int32_t)note * (int32_t)CV_CODES_PER_SEMITONE) + mod;
+    }
+
+    return _clamp(i32Code);
+}
+
+uint16_t cv_cal_apply(uint8_t out, uint16_t code)
+{
+    USER_ASSERT(out < CV_ANALOG_NUM);
+
+    const cv_cal_data_t *pxCal = pxCalActive;
+
+    if (pxCal != NULL)
+    {
+        code = _clamp((int32_t)pxCal->offset[out] + (int32_t)(((uint32_t)code * pxCal->gain[out]) >> 15));
+    }
+
+    return code;
+}
+
+bool cv_cal_set_output(uint8_t out, int16_t offset, uint16_t gain)
+{
+    bool bRetval = false;
+
+    if ((out < CV_ANALOG_NUM) && (gain != 0U))
+    {
+        cv_cal_data_t *pxEdit = _get_edit();
+
+        pxEdit->offset[out] = offset;
+        pxEdit->gain[out] = gain;
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+bool cv_cal_set_note(uint8_t out, uint8_t note, uint16_t code)
+{
+    bool bRetval = false;
+
+    if ((out < CV_ANALOG_NUM) && (note < MIDI_NOTE_NUM))
+    {
+        _get_edit()->note[out][note] = code;
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+bool cv_cal_set_scale(uint8_t out, uint8_t note_a, uint16_t code_a, uint8_t note_b, uint16_t code_b)
+{
+    bool bRetval = false;
+
+    if ((out < CV_ANALOG_NUM) && (note_a < MIDI_NOTE_NUM) && (note_b < MIDI_NOTE_NUM) && (note_a != note_b))
+    {
+        cv_cal_data_t *pxEdit = _get_edit();
+        int32_t i32Span = (int32_t)note_b - (int32_t)note_a;
+        int32_t i32Delta = (int32_t)code_b - (int32_t)code_a;
+
+        /* Table is built once here, boot and note on only read it */
+        for (int32_t n = 0; n < (int32_t)MIDI_NOTE_NUM; n++)
+        {
+            int32_t i32Num = (n - (int32_t)note_a) * i32Delta;
+            int32_t i32Step = (i32Num + ((((i32Num < 0) != (i32Span < 0)) ? -i32Span : i32Span) / 2)) / i32Span;
+
+            pxEdit->note[out][n] = _clamp((int32_t)code_a + i32Step);
+        }
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+const cv_cal_data_t *cv_cal_get(void)
+{
+    return pxCalActive;
+}
+
+bool cv_cal_save(void)
+{
+    bool bRetval = bCalBlank;
+    uint32_t u32Slots = SYS_FLASH_GetSize(CAL_AREA) / CAL_RECORD_SIZE;
+    uint32_t u32Offset = u32CalNext * CAL_RECORD_SIZE;
+    const cv_cal_data_t *pxData = _get_edit();
+    uint32_t u32Head[2] = {CAL_MAGIC, u32CalSeq + 1U};
+    uint32_t u32Tail[2];
+
+    /* Nothing is erased here, a save before cv_cal_reclaim is refused */
+    if (bRetval)
+    {
+        u32Tail[0] = crc32_final(crc32_update(crc32_update(CRC32_INIT, u32Head, sizeof(u32Head)), pxData, sizeof(*pxData)));
+        u32Tail[1] = UINT32_MAX;
+
+        bRetval = (SYS_FLASH_Write(CAL_AREA, u32Offset, u32Head, sizeof(u32Head)) == SYS_FLASH_STATUS_OK) &&
+                  (SYS_FLASH_Write(CAL_AREA, u32Offset + offsetof(cal_record_t, data), pxData, sizeof(*pxData)) == SYS_FLASH_STATUS_OK) &&
+                  (SYS_FLASH_Write(CAL_AREA, u32Offset + offsetof(cal_record_t, crc), u32Tail, sizeof(u32Tail)) == SYS_FLASH_STATUS_OK) &&
+                  _check_record(_get_record(u32CalNext));
+
+        /* Skip a failed slot, next save uses a fresh one */
+        u32CalNext = (u32CalNext + 1U) % u32Slots;
+        bCalBlank = false;
+
+        if (bRetval)
+        {
+            u32CalSeq++;
+            pxCalActive = &_get_record((u32CalNext + u32Slots - 1U) % u32Slots)->data;
+        }
+    }
+
+    return bRetval;
+}
+
+bool cv_cal_need_reclaim(void)
+{
+    return !bCalBlank;
+}
+
+bool cv_cal_reclaim(void)
+{
+    if (!bCalBlank)
+    {
+        uint32_t u32End = (u32CalNext * CAL_RECORD_SIZE) + CAL_RECORD_SIZE;
+
+        bCalBlank = true;
+
+        /* Blank pages are left alone, a reboot does not wear them */
+        for (uint32_t u32Page = _get_next_page(); bCalBlank && (u32Page < u32End); u32Page += SYS_FLASH_PAGE_SIZE)
+        {
+            bCalBlank = _check_blank(u32Page) ||
+                        (SYS_FLASH_Erase(CAL_AREA, u32Page) == SYS_FLASH_STATUS_OK);
+        }
+    }
+
+    return bCalBlank;
+}
+
+uint32_t cv_cal_get_seq(void)
+{
+    return u32CalSeq;
+}
+
+/* EOF */
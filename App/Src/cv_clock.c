@@ -0,0 +1,411 @@
+/**
+ * @file    cv_clock.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   MIDI clock tracking and clock, run and reset gate outputs.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "cv_clock.h"
+#include "cv_engine.h"
+#include "midi_lib.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+
+/* Fractional bits of period estimation */
+#define CLOCK_PERIOD_FRAC       8U
+
+/* Smoothing factor of period estimation, 1 / 2^n */
+#define CLOCK_SMOOTH_SHIFT      3U
+
+/* Valid clock period range, 625 BPM to 20 BPM */
+#define CLOCK_PERIOD_MIN_US     4000U
+#define CLOCK_PERIOD_MAX_US     125000U
+
+/* Consecutive outliers needed to accept a tempo jump */
+#define CLOCK_OUTLIER_NUM       2U
+
+/* No interpolated pulse pending */
+#define CLOCK_SUB_NONE          0xFFU
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+
+/** Default clock configuration, used until a preset is applied */
+static cv_clock_cfg_t xClockDefault;
+
+/** Active clock configuration */
+static cv_clock_cfg_t *pxClockCfg = &xClockDefault;
+
+/** Tempo estimation */
+static uint32_t u32PeriodQ8 = 0U;
+static uint32_t u32LastClockUs = 0U;
+static bool bHaveLast = false;
+static uint8_t u8Outliers = 0U;
+
+/** Clock time predicted from the tempo, free of reception jitter */
+static uint32_t u32BeatUs = 0U;
+static bool bHaveBeat = false;
+
+/** Transport */
+static bool bRunning = false;
+static uint32_t u32Position = 0U;
+
+/** Output pulse scheduling */
+static uint32_t u32SubPos = 0U;
+static uint32_t u32IntervalUs = 0U;
+static uint8_t u8IntervalMul = 1U;
+static uint8_t u8NextSub = CLOCK_SUB_NONE;
+
+/** Output state in ticks */
+static uint16_t u16ClockCount = 0U;
+static uint16_t u16ResetCount = 0U;
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Update period estimation with a new clock.
+ * @param  time_us clock reception time.
+ * @retval None.
+ */
+static void _update_period(uint32_t time_us);
+
+/**
+ * @brief  Update predicted clock time with a new clock, call after the
+ *         period is updated.
+ * @param  time_us clock reception time.
+ * @retval None.
+ */
+static void _update_beat(uint32_t time_us);
+
+/**
+ * @brief  Get divide and multiply ratios of the configuration, guarded
+ *         against invalid values.
+ * @param  div where to store divide ratio.
+ * @param  mul where to store multiply ratio.
+ * @retval None.
+ */
+static void _get_ratio(uint8_t *div, uint8_t *mul);
+
+/**
+ * @brief  Start a clock output pulse.
+ * @retval None.
+ */
+static void _fire_pulse(void);
+
+/**
+ * @brief  Set or clear gate bit of an assigned output.
+ * @param  gates gate values.
+ * @param  out assigned output.
+ * @param  on output state.
+ * @retval updated gate values.
+ */
+static uint8_t _set_gate(uint8_t gates, uint8_t out, bool on);
+
+/* Private application code --------------------------------------------------*/
+
+static void _update_period(uint32_t time_us)
+{
+    if (bHaveLast)
+    {
+        uint32_t u32Dt = time_us - u32LastClockUs;
+
+        if ((u32Dt >= CLOCK_PERIOD_MIN_US) && (u32Dt <= CLOCK_PERIOD_MAX_US))
+        {
+            uint32_t u32DtQ8 = u32Dt << CLOCK_PERIOD_FRAC;
+            uint32_t u32Err = (u32DtQ8 > u32PeriodQ8) ? (u32DtQ8 - u32PeriodQ8) : (u32PeriodQ8 - u32DtQ8);
+
+            if (u32PeriodQ8 == 0U)
+            {
+                u32PeriodQ8 = u32DtQ8;
+            }
+            else if (u32Err > (u32PeriodQ8 >> 2))
+            {
+                /* Ignore single late or early clocks, follow real tempo changes */
+                if (++u8Outliers >= CLOCK_OUTLIER_NUM)
+                {
+                    u32PeriodQ8 = u32DtQ8;
+                    u8Outliers = 0U;
+                }
+            }
+            else
+            {
+                /* One pole low pass on period, filters reception jitter */
+                u32PeriodQ8 = u32PeriodQ8 - (u32PeriodQ8 >> CLOCK_SMOOTH_SHIFT) + (u32DtQ8 >> CLOCK_SMOOTH_SHIFT);
+                u8Outliers = 0U;
+            }
+        }
+        else
+        {
+            /* Clock lost */
+            u32PeriodQ8 = 0U;
+            u8Outliers = 0U;
+        }
+    }
+
+    u32LastClockUs = time_us;
+    bHaveLast = true;
+}
+
+static void _update_beat(uint32_t time_us)
+{
+    uint32_t u32Period = u32PeriodQ8 >> CLOCK_PERIOD_FRAC;
+    uint32_t u32Pred = u32BeatUs + u32Period;
+    int32_t i32Err = (int32_t)(time_us - u32Pred);
+    uint32_t u32Err = (i32Err < 0) ? (uint32_t)-i32Err : (uint32_t)i32Err;
+
+    if (!bHaveBeat || (u32Period == 0U) || (u32Err > (u32Period >> 2)))
+    {
+        /* No tempo yet or clock far from prediction, start from this one */
+        u32BeatUs = time_us;
+    }
+    else
+    {
+        /* Follow a fraction of the error, as the period filter does */
+        u32BeatUs = u32Pred + (uint32_t)(i32Err / (int32_t)(1U << CLOCK_SMOOTH_SHIFT));
+    }
+
+    bHaveBeat = true;
+}
+
+static void _get_ratio(uint8_t *div, uint8_t *mul)
+{
+    *div = pxClockCfg->div;
+    *mul = pxClockCfg->mul;
+
+    /* Guard against invalid ratios set on configuration */
+    if ((*div == 0U) || (*div > CV_CLOCK_DIV_MAX))
+    {
+        *div = 1U;
+    }
+    if ((*mul == 0U) || (*mul > CV_CLOCK_MUL_MAX))
+    {
+        *mul = 1U;
+    }
+}
+
+static void _fire_pulse(void)
+{
+    uint32_t u32Len = CV_MS_TO_TICKS(CV_TRIGGER_MS);
+
+    /* Keep pulses shorter than half the output period */
+    if (u32PeriodQ8 != 0U)
+    {
+        uint8_t u8Div;
+        uint8_t u8Mul;
+
+        _get_ratio(&u8Div, &u8Mul);
+
+        uint32_t u32OutUs = ((u32PeriodQ8 >> CLOCK_PERIOD_FRAC) * u8Div) / u8Mul;
+        uint32_t u32Half = (u32OutUs * CV_ENGINE_TICK_HZ) / 2000000U;
+
+        if (u32Half < u32Len)
+        {
+            u32Len = (u32Half != 0U) ? u32Half : 1U;
+        }
+    }
+
+    u16ClockCount = (uint16_t)u32Len;
+}
+
+static uint8_t _set_gate(uint8_t gates, uint8_t out, bool on)
+{
+    if (out < CV_GATE_NUM)
+    {
+        if (on)
+        {
+            gates |= (uint8_t)(1U << out);
+        }
+        else
+        {
+            gates &= (uint8_t)~(1U << out);
+        }
+    }
+
+    return gates;
+}
+
+/* Public application code ---------------------------------------------------*/
+
+void cv_clock_init(void)
+{
+    pxClockCfg = &xClockDefault;
+    pxClockCfg->clock_out = CV_CLOCK_OUT_NONE;
+    pxClockCfg->run_out = CV_CLOCK_OUT_NONE;
+    pxClockCfg->reset_out = CV_CLOCK_OUT_NONE;
+    pxClockCfg->div = 6U;
+    pxClockCfg->mul = 1U;
+
+    u32PeriodQ8 = 0U;
+    bHaveLast = false;
+    u8Outliers = 0U;
+    bHaveBeat = false;
+    bRunning = false;
+    u32Position = 0U;
+    u32SubPos = 0U;
+    u8NextSub = CLOCK_SUB_NONE;
+    u16ClockCount = 0U;
+    u16ResetCount = 0U;
+}
+
+const cv_clock_cfg_t *cv_clock_get_cfg(void)
+{
+    return pxClockCfg;
+}
+
+void cv_clock_set_cfg(cv_clock_cfg_t *cfg)
+{
+    pxClockCfg = (cfg != NULL) ? cfg : &xClockDefault;
+}
+
+bool cv_clock_midi(uint8_t status, uint32_t time_us)
+{
+    uint8_t u8Div;
+    uint8_t u8Mul;
+    bool bRun = bRunning;
+    bool bRetval = false;
+
+    _get_ratio(&u8Div, &u8Mul);
+
+    if (status == MIDI_TIMING_CLOCK)
+    {
+        _update_period(time_us);
+        _update_beat(time_us);
+
+        if (bRunning)
+        {
+            u32Position++;
+
+            /* Sub pulse where the next output pulse lands on this interval */
+            uint32_t u32First = (u8Div - (u32SubPos % u8Div)) % u8Div;
+
+            /* Every pulse goes out on the compare from the predicted clock
+             * time, pulses left from previous interval are dropped. A pulse
+             * on the clock itself needs no tempo */
+            if ((u32First == 0U) || ((u32First < u8Mul) && (u32PeriodQ8 != 0U)))
+            {
+                u8NextSub = (uint8_t)u32First;
+            }
+            else
+            {
+                u8NextSub = CLOCK_SUB_NONE;
+            }
+            u8IntervalMul = u8Mul;
+            u32IntervalUs = u32BeatUs;
+            u32SubPos = (u32SubPos + u8Mul) % u8Div;
+
+            /* Pulses between clocks belong to no message */
+            bRetval = (u8NextSub == 0U) && (pxClockCfg->clock_out < CV_GATE_NUM);
+        }
+    }
+    else if (status == MIDI_START)
+    {
+        bRunning = true;
+        u32Position = 0U;
+        u32SubPos = 0U;
+        u8NextSub = CLOCK_SUB_NONE;
+        u16ResetCount = (uint16_t)CV_MS_TO_TICKS(CV_TRIGGER_MS);
+        bRetval = (pxClockCfg->reset_out < CV_GATE_NUM);
+    }
+    else if (status == MIDI_CONTINUE)
+    {
+        bRunning = true;
+    }
+    else if (status == MIDI_STOP)
+    {
+        bRunning = false;
+        u8NextSub = CLOCK_SUB_NONE;
+    }
+    else
+    {
+        /* Not handled */
+    }
+
+    /* Run output follows transport */
+    if ((bRun != bRunning) && (pxClockCfg->run_out < CV_GATE_NUM))
+    {
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+bool cv_clock_event(uint32_t time_us)
+{
+    uint32_t u32Delay;
+    bool bRetval = false;
+
+    /* Fire only when due, event may come from an old schedule */
+    if (cv_clock_get_event(time_us, &u32Delay) && (u32Delay == 0U))
+    {
+        uint8_t u8Div;
+        uint8_t u8Mul;
+
+        _get_ratio(&u8Div, &u8Mul);
+
+        uint32_t u32Next = (uint32_t)u8NextSub + u8Div;
+
+        _fire_pulse();
+        u8NextSub = ((u32Next < u8IntervalMul) && (u32PeriodQ8 != 0U)) ? (uint8_t)u32Next : CLOCK_SUB_NONE;
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+bool cv_clock_get_event(uint32_t time_us, uint32_t *delay_us)
+{
+    bool bRetval = false;
+
+    if (u8NextSub != CLOCK_SUB_NONE)
+    {
+        uint32_t u32Offset = ((u8NextSub * u32PeriodQ8) / u8IntervalMul) >> CLOCK_PERIOD_FRAC;
+        int32_t i32Delay = (int32_t)((u32IntervalUs + u32Offset) - time_us);
+
+        *delay_us = (i32Delay > 0) ? (uint32_t)i32Delay : 0U;
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+void cv_clock_tick(void)
+{
+    if (u16ClockCount != 0U)
+    {
+        u16ClockCount--;
+    }
+
+    if (u16ResetCount != 0U)
+    {
+        u16ResetCount--;
+    }
+}
+
+uint8_t cv_clock_apply_gates(uint8_t gates)
+{
+    gates = _set_gate(gates, pxClockCfg->clock_out, u16ClockCount != 0U);
+    gates = _set_gate(gates, pxClockCfg->run_out, bRunning);
+    gates = _set_gate(gates, pxClockCfg->reset_out, u16ResetCount != 0U);
+
+    return gates;
+}
+
+uint32_t cv_clock_get_period(void)
+{
+    return u32PeriodQ8;
+}
+
+uint32_t cv_clock_get_position(void)
+{
+    return u32Position;
+}
+
+bool cv_clock_is_running(void)
+{
+    return bRunning;
+}
+
+/* EOF */
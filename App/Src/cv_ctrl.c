@@ -0,0 +1,591 @@
+/**
+ * @file    cv_ctrl.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   MIDI controller to CV mapping. Handles 14 bit CC pairs, NRPN and
+ *          RPN sequences, velocity and aftertouch, applies response curves
+ *          and smooths mapped outputs on the output tick.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "cv_ctrl.h"
+#include "cv_curve.h"
+#include "cv_engine.h"
+#include "midi_lib.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+
+/** Controller functions */
+typedef enum
+{
+    CTRL_NONE = 0U,
+    CTRL_OUT_MSB,           /**< MSB or 7 bit value of a mapped output */
+    CTRL_OUT_LSB,           /**< LSB of a mapped output */
+    CTRL_DATA_MSB,
+    CTRL_DATA_LSB,
+    CTRL_DATA_INC,
+    CTRL_DATA_DEC,
+    CTRL_NRPN_LSB,
+    CTRL_NRPN_MSB,
+    CTRL_RPN_LSB,
+    CTRL_RPN_MSB,
+} ctrl_kind_t;
+
+/** Parameter selected for data entry */
+typedef enum
+{
+    CTRL_PARAM_NONE = 0U,
+    CTRL_PARAM_NRPN,
+    CTRL_PARAM_RPN,
+} ctrl_param_t;
+
+/** Output state */
+typedef struct ctrl_out
+{
+    uint16_t value;         /**< 14 bit controller value */
+    uint16_t code;          /**< Output code with curve applied */
+    uint32_t level;         /**< Smoothed output code, 8 fractional bits */
+} ctrl_out_t;
+
+/* Private define ------------------------------------------------------------*/
+
+/* Controller numbers */
+#define CTRL_CC_DATA_MSB        6U
+#define CTRL_CC_LSB_OFFSET      32U
+#define CTRL_CC_DATA_LSB        (CTRL_CC_DATA_MSB + CTRL_CC_LSB_OFFSET)
+#define CTRL_CC_DATA_INC        96U
+#define CTRL_CC_DATA_DEC        97U
+#define CTRL_CC_NRPN_LSB        98U
+#define CTRL_CC_NRPN_MSB        99U
+#define CTRL_CC_RPN_LSB         100U
+#define CTRL_CC_RPN_MSB         101U
+#define CTRL_CC_MODE_FIRST      120U
+
+/* Registered parameters */
+#define CTRL_RPN_BEND_RANGE     0x0000U
+#define CTRL_RPN_NULL           0x3FFFU
+
+/* Output not mapped */
+#define CTRL_OUT_NONE           0xFFU
+
+/* Fractional bits of smoothed output */
+#define CTRL_LEVEL_FRAC         8U
+
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/** 7 bit value to 14 bit on a curve table entry, 6 fraction bits clear.
+    Top bit is replicated on the entry bits so 127 reaches the last one */
+#define CTRL_VALUE14(v)         ((uint16_t)(((uint32_t)(v) << 7) | (((uint32_t)(v) >> 6) << 6)))
+
+/* Private variables ---------------------------------------------------------*/
+
+/** Default mapping, used until a preset is applied */
+static cv_ctrl_map_t xMapDefault;
+
+/** Active mapping */
+static cv_ctrl_map_t *pxMap = &xMapDefault;
+
+/** Output state */
+static ctrl_out_t xOut[CV_ANALOG_NUM];
+
+/** Parameter selected by NRPN or RPN */
+static uint8_t u8ParamType = CTRL_PARAM_NONE;
+static uint16_t u16ParamNum = 0U;
+static uint8_t u8ParamOut = CTRL_OUT_NONE;
+
+/** Pitch bend range in cents */
+static uint16_t u16BendRange = CV_CTRL_BEND_RANGE;
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Check if a controller number can be mapped to an output.
+ * @param  cc controller number.
+ * @retval true if valid.
+ */
+static bool _cc_is_valid(uint16_t cc);
+
+/**
+ * @brief  Build controller table and source masks of a mapping.
+ * @param  map mapping.
+ * @retval None.
+ */
+static void _build_map(cv_ctrl_map_t *map);
+
+/**
+ * @brief  Apply curves and parameter selection of the active mapping.
+ * @retval None.
+ */
+static void _apply_map(void);
+
+/**
+ * @brief  Rebuild controller table if mapping changed.
+ * @retval None.
+ */
+static void _check_cfg(void);
+
+/**
+ * @brief  Find output mapped to selected NRPN.
+ * @retval None.
+ */
+static void _select_param(void);
+
+/**
+ * @brief  Apply data entry to selected parameter.
+ * @param  kind data entry function.
+ * @param  value controller value.
+ * @retval None.
+ */
+static bool _param_data(uint8_t kind, uint8_t value);
+
+/**
+ * @brief  Set controller value of an output, curve is applied here.
+ * @param  out analog output.
+ * @param  value 14 bit controller value.
+ * @retval None.
+ */
+static void _set_value(uint8_t out, uint16_t value);
+
+/**
+ * @brief  Set value of all outputs mapped to a source.
+ * @param  src controller source.
+ * @param  note note of the event, CV_CTRL_ANY_NOTE if none.
+ * @param  value 7 bit value.
+ * @retval None.
+ */
+static bool _set_source(uint8_t src, uint8_t note, uint8_t value);
+
+/* Private application code --------------------------------------------------*/
+
+static bool _cc_is_valid(uint16_t cc)
+{
+    bool bRetval = false;
+
+    /* 32-63 are LSB of 0-31, data entry and parameter numbers are reserved */
+    if ((cc < CTRL_CC_LSB_OFFSET) && (cc != CTRL_CC_DATA_MSB))
+    {
+        bRetval = true;
+    }
+    else if ((cc >= (2U * CTRL_CC_LSB_OFFSET)) && (cc < CTRL_CC_MODE_FIRST) &&
+        ((cc < CTRL_CC_DATA_INC) || (cc > CTRL_CC_RPN_MSB)))
+    {
+        bRetval = true;
+    }
+    else
+    {
+        /* Not valid */
+    }
+
+    return bRetval;
+}
+
+static void _build_map(cv_ctrl_map_t *map)
+{
+    map->changed = false;
+
+    for (uint32_t i = 0; i <= MIDI_DATA_MAX; i++)
+    {
+        map->cc[i].kind = CTRL_NONE;
+        map->cc[i].out = CTRL_OUT_NONE;
+    }
+
+    map->cc[CTRL_CC_DATA_MSB].kind = CTRL_DATA_MSB;
+    map->cc[CTRL_CC_DATA_LSB].kind = CTRL_DATA_LSB;
+    map->cc[CTRL_CC_DATA_INC].kind = CTRL_DATA_INC;
+    map->cc[CTRL_CC_DATA_DEC].kind = CTRL_DATA_DEC;
+    map->cc[CTRL_CC_NRPN_LSB].kind = CTRL_NRPN_LSB;
+    map->cc[CTRL_CC_NRPN_MSB].kind = CTRL_NRPN_MSB;
+    map->cc[CTRL_CC_RPN_LSB].kind = CTRL_RPN_LSB;
+    map->cc[CTRL_CC_RPN_MSB].kind = CTRL_RPN_MSB;
+
+    for (uint32_t i = 0; i < CV_CTRL_SRC_NUM; i++)
+    {
+        map->src_mask[i] = 0U;
+    }
+
+    /* Last output wins when several share a controller */
+    for (uint32_t i = 0; i < CV_ANALOG_NUM; i++)
+    {
+        uint16_t u16Num = map->out[i].number;
+
+        map->src_mask[map->out[i].src] |= (uint8_t)(1U << i);
+
+        if (map->out[i].src == CV_CTRL_SRC_CC)
+        {
+            map->cc[u16Num].kind = CTRL_OUT_MSB;
+            map->cc[u16Num].out = (uint8_t)i;
+
+            if (u16Num < CTRL_CC_LSB_OFFSET)
+            {
+                map->cc[u16Num + CTRL_CC_LSB_OFFSET].kind = CTRL_OUT_LSB;
+                map->cc[u16Num + CTRL_CC_LSB_OFFSET].out = (uint8_t)i;
+            }
+        }
+    }
+}
+
+static void _apply_map(void)
+{
+    /* Curves may have changed */
+    for (uint32_t i = 0; i < CV_ANALOG_NUM; i++)
+    {
+        _set_value((uint8_t)i, xOut[i].value);
+    }
+
+    _select_param();
+}
+
+static void _check_cfg(void)
+{
+    if (pxMap->changed)
+    {
+        _build_map(pxMap);
+        _apply_map();
+    }
+}
+
+static void _select_param(void)
+{
+    u8ParamOut = CTRL_OUT_NONE;
+
+    if (u8ParamType == CTRL_PARAM_NRPN)
+    {
+        for (uint32_t i = 0; i < CV_ANALOG_NUM; i++)
+        {
+            if ((pxMap->out[i].src == CV_CTRL_SRC_NRPN) && (pxMap->out[i].number == u16ParamNum))
+            {
+                u8ParamOut = (uint8_t)i;
+            }
+        }
+    }
+}
+
+static bool _param_data(uint8_t kind, uint8_t value)
+{
+    bool bRetval = false;
+
+    if ((u8ParamType == CTRL_PARAM_RPN) && (u16ParamNum == CTRL_RPN_BEND_RANGE))
+    {
+        /* MSB in semitones, LSB in cents */
+        uint16_t u16Semi = u16BendRange / 100U;
+        uint16_t u16Cents = u16BendRange % 100U;
+
+        if (kind == CTRL_DATA_MSB)
+        {
+            u16Semi = value;
+        }
+        else if (kind == CTRL_DATA_LSB)
+        {
+            u16Cents = (value < 100U) ? value : 99U;
+        }
+        else if ((kind == CTRL_DATA_INC) && (u16Semi < MIDI_DATA_MAX))
+        {
+            u16Semi++;
+        }
+        else if ((kind == CTRL_DATA_DEC) && (u16Semi != 0U))
+        {
+            u16Semi--;
+        }
+        else
+        {
+            /* Out of range */
+        }
+
+        u16BendRange = (uint16_t)((u16Semi * 100U) + u16Cents);
+    }
+    else if (u8ParamOut != CTRL_OUT_NONE)
+    {
+        uint16_t u16Value = xOut[u8ParamOut].value;
+
+        if (kind == CTRL_DATA_MSB)
+        {
+            u16Value = CTRL_VALUE14(value);
+        }
+        else if (kind == CTRL_DATA_LSB)
+        {
+            u16Value = (u16Value & 0x3F80U) | value;
+        }
+        else if ((kind == CTRL_DATA_INC) && (u16Value < MIDI_DATA14_MAX))
+        {
+            u16Value++;
+        }
+        else if ((kind == CTRL_DATA_DEC) && (u16Value != 0U))
+        {
+            u16Value--;
+        }
+        else
+        {
+            /* Out of range */
+        }
+
+        _set_value(u8ParamOut, u16Value);
+        bRetval = true;
+    }
+    else
+    {
+        /* Parameter not handled */
+    }
+
+    return bRetval;
+}
+
+static void _set_value(uint8_t out, uint16_t value)
+{
+    xOut[out].value = value;
+    xOut[out].code = cv_curve_apply(pxMap->out[out].curve, value);
+}
+
+static bool _set_source(uint8_t src, uint8_t note, uint8_t value)
+{
+    uint8_t u8Mask;
+    bool bRetval = false;
+
+    _check_cfg();
+
+    u8Mask = pxMap->src_mask[src];
+
+    for (uint32_t i = 0; (i < CV_ANALOG_NUM) && (u8Mask != 0U); i++, u8Mask >>= 1)
+    {
+        if (((u8Mask & 0x01U) != 0U) &&
+            ((pxMap->out[i].number == CV_CTRL_ANY_NOTE) || (pxMap->out[i].number == note) || (src != CV_CTRL_SRC_POLY_AT)))
+        {
+            _set_value((uint8_t)i, CTRL_VALUE14(value));
+            bRetval = true;
+        }
+    }
+
+    return bRetval;
+}
+
+/* Public application code ---------------------------------------------------*/
+
+void cv_ctrl_init(void)
+{
+    cv_ctrl_map_init(&xMapDefault);
+    pxMap = &xMapDefault;
+
+    cv_curve_init();
+    cv_ctrl_reset();
+}
+
+void cv_ctrl_map_init(cv_ctrl_map_t *map)
+{
+    USER_ASSERT(map != NULL);
+
+    for (uint32_t i = 0; i < CV_ANALOG_NUM; i++)
+    {
+        map->out[i].src = CV_CTRL_SRC_NONE;
+        map->out[i].smooth = 0U;
+        map->out[i].curve = CV_CURVE_LINEAR;
+        map->out[i].number = 0U;
+    }
+
+    _build_map(map);
+}
+
+bool cv_ctrl_map_set(cv_ctrl_map_t *map, uint8_t out, const cv_ctrl_out_cfg_t *cfg)
+{
+    USER_ASSERT((map != NULL) && (cfg != NULL));
+
+    bool bRetval = false;
+
+    if ((out < CV_ANALOG_NUM) && cv_ctrl_check_output(cfg))
+    {
+        map->out[out] = *cfg;
+        map->changed = true;
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+void cv_ctrl_map_build(cv_ctrl_map_t *map)
+{
+    USER_ASSERT(map != NULL);
+
+    if (map->changed)
+    {
+        _build_map(map);
+    }
+}
+
+void cv_ctrl_set_map(cv_ctrl_map_t *map)
+{
+    USER_ASSERT(map != NULL);
+
+    pxMap = map;
+    cv_ctrl_map_build(map);
+    _apply_map();
+}
+
+bool cv_ctrl_check_output(const cv_ctrl_out_cfg_t *cfg)
+{
+    USER_ASSERT(cfg != NULL);
+
+    return (cfg->src < CV_CTRL_SRC_NUM) &&
+           (cfg->smooth <= CV_CTRL_SMOOTH_MAX) && (cfg->curve < CV_CURVE_NUM) &&
+           ((cfg->src != CV_CTRL_SRC_CC) || _cc_is_valid(cfg->number)) &&
+           ((cfg->src != CV_CTRL_SRC_NRPN) || (cfg->number <= MIDI_DATA14_MAX)) &&
+           ((cfg->src != CV_CTRL_SRC_POLY_AT) || (cfg->number <= CV_CTRL_ANY_NOTE));
+}
+
+const cv_ctrl_out_cfg_t *cv_ctrl_get_output(uint8_t out)
+{
+    USER_ASSERT(out < CV_ANALOG_NUM);
+
+    return &pxMap->out[out];
+}
+
+bool cv_ctrl_cc(uint8_t cc, uint8_t value)
+{
+    const cv_ctrl_entry_t *pxEntry;
+    bool bRetval = false;
+
+    _check_cfg();
+
+    /* Single lookup resolves controller function and output */
+    pxEntry = &pxMap->cc[cc & MIDI_DATA_MAX];
+
+    switch (pxEntry->kind)
+    {
+        case CTRL_OUT_MSB:
+            /* A new MSB replaces the LSB, 7 bit controllers stop here */
+            _set_value(pxEntry->out, CTRL_VALUE14(value));
+            bRetval = true;
+            break;
+
+        case CTRL_OUT_LSB:
+            _set_value(pxEntry->out, (xOut[pxEntry->out].value & 0x3F80U) | value);
+            bRetval = true;
+            break;
+
+        case CTRL_DATA_MSB:
+        case CTRL_DATA_LSB:
+        case CTRL_DATA_INC:
+        case CTRL_DATA_DEC:
+            bRetval = _param_data(pxEntry->kind, value);
+            break;
+
+        case CTRL_NRPN_LSB:
+        case CTRL_NRPN_MSB:
+        case CTRL_RPN_LSB:
+        case CTRL_RPN_MSB:
+        {
+            uint8_t u8Type = ((pxEntry->kind == CTRL_NRPN_LSB) || (pxEntry->kind == CTRL_NRPN_MSB)) ?
+                CTRL_PARAM_NRPN : CTRL_PARAM_RPN;
+
+            /* Switching between NRPN and RPN starts a new number */
+            if (u8Type != u8ParamType)
+            {
+                u8ParamType = u8Type;
+                u16ParamNum = 0U;
+            }
+
+            if ((pxEntry->kind == CTRL_NRPN_MSB) || (pxEntry->kind == CTRL_RPN_MSB))
+            {
+                u16ParamNum = (uint16_t)((value << 7) | (u16ParamNum & MIDI_DATA_MAX));
+            }
+            else
+            {
+                u16ParamNum = (uint16_t)((u16ParamNum & 0x3F80U) | value);
+            }
+
+            /* RPN null deselects data entry */
+            if ((u8ParamType == CTRL_PARAM_RPN) && (u16ParamNum == CTRL_RPN_NULL))
+            {
+                u8ParamType = CTRL_PARAM_NONE;
+            }
+
+            _select_param();
+            break;
+        }
+
+        default:
+            /* Not mapped */
+            break;
+    }
+
+    return bRetval;
+}
+
+void cv_ctrl_note(uint8_t note, uint8_t velocity)
+{
+    (void)_set_source(CV_CTRL_SRC_VELOCITY, note, velocity);
+}
+
+bool cv_ctrl_pressure(uint8_t value)
+{
+    return _set_source(CV_CTRL_SRC_PRESSURE, CV_CTRL_ANY_NOTE, value);
+}
+
+bool cv_ctrl_poly_pressure(uint8_t note, uint8_t value)
+{
+    return _set_source(CV_CTRL_SRC_POLY_AT, note, value);
+}
+
+void cv_ctrl_reset(void)
+{
+    for (uint32_t i = 0; i < CV_ANALOG_NUM; i++)
+    {
+        _set_value((uint8_t)i, 0U);
+    }
+
+    u8ParamType = CTRL_PARAM_NONE;
+    u16ParamNum = 0U;
+    u8ParamOut = CTRL_OUT_NONE;
+}
+
+void cv_ctrl_tick(void)
+{
+    for (uint32_t i = 0; i < CV_ANALOG_NUM; i++)
+    {
+        ctrl_out_t *pxOut = &xOut[i];
+        uint32_t u32Target = (uint32_t)pxOut->code << CTRL_LEVEL_FRAC;
+        uint32_t u32Shift = pxMap->out[i].smooth;
+
+        /* One pole low pass, steps rounded up so the target is always reached */
+        if (pxOut->level < u32Target)
+        {
+            pxOut->level += ((u32Target - pxOut->level) + ((1UL << u32Shift) - 1U)) >> u32Shift;
+        }
+        else if (pxOut->level > u32Target)
+        {
+            pxOut->level -= ((pxOut->level - u32Target) + ((1UL << u32Shift) - 1U)) >> u32Shift;
+        }
+        else
+        {
+            /* Settled */
+        }
+    }
+}
+
+bool cv_ctrl_get_code(uint8_t out, uint16_t *code)
+{
+    USER_ASSERT(code != NULL);
+
+    bool bRetval = false;
+
+    if ((out < CV_ANALOG_NUM) && (pxMap->out[out].src != CV_CTRL_SRC_NONE))
+    {
+        *code = (uint16_t)(xOut[out].level >> CTRL_LEVEL_FRAC);
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+uint16_t cv_ctrl_get_bend_range(void)
+{
+    return u16BendRange;
+}
+
+/* EOF */
@@ -0,0 +1,223 @@
+/**
+ * @file    cv_curve.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Response curves applied to controller values.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "cv_curve.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+
+/* Controller value bits below the curve index */
+#define CURVE_FRAC_BITS         6U
+#define CURVE_FRAC_MASK         ((1U << CURVE_FRAC_BITS) - 1U)
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+
+/** Fixed curves, kept in flash. Generated with Tools/curve_gen.py */
+static const uint16_t u16CurveLut[CV_CURVE_USER][CV_CURVE_SIZE] = {
+    /* Linear */
+    {
+        0x0000, 0x0101, 0x0202, 0x0303, 0x0404, 0x0505, 0x0606, 0x0707,
+        0x0808, 0x0909, 0x0A0A, 0x0B0B, 0x0C0C, 0x0D0D, 0x0E0E, 0x0F0F,
+        0x1010, 0x1111, 0x1212, 0x1313, 0x1414, 0x1515, 0x1616, 0x1717,
+        0x1818, 0x1919, 0x1A1A, 0x1B1B, 0x1C1C, 0x1D1D, 0x1E1E, 0x1F1F,
+        0x2020, 0x2121, 0x2222, 0x2323, 0x2424, 0x2525, 0x2626, 0x2727,
+        0x2828, 0x2929, 0x2A2A, 0x2B2B, 0x2C2C, 0x2D2D, 0x2E2E, 0x2F2F,
+        0x3030, 0x3131, 0x3232, 0x3333, 0x3434, 0x3535, 0x3636, 0x3737,
+        0x3838, 0x3939, 0x3A3A, 0x3B3B, 0x3C3C, 0x3D3D, 0x3E3E, 0x3F3F,
+        0x4040, 0x4141, 0x4242, 0x4343, 0x4444, 0x4545, 0x4646, 0x4747,
+        0x4848, 0x4949, 0x4A4A, 0x4B4B, 0x4C4C, 0x4D4D, 0x4E4E, 0x4F4F,
+        0x5050, 0x5151, 0x5252, 0x5353, 0x5454, 0x5555, 0x5656, 0x5757,
+        0x5858, 0x5959, 0x5A5A, 0x5B5B, 0x5C5C, 0x5D5D, 0x5E5E, 0x5F5F,
+        0x6060, 0x6161, 0x6262, 0x6363, 0x6464, 0x6565, 0x6666, 0x6767,
+        0x6868, 0x6969, 0x6A6A, 0x6B6B, 0x6C6C, 0x6D6D, 0x6E6E, 0x6F6F,
+        0x7070, 0x7171, 0x7272, 0x7373, 0x7474, 0x7575, 0x7676, 0x7777,
+        0x7878, 0x7979, 0x7A7A, 0x7B7B, 0x7C7C, 0x7D7D, 0x7E7E, 0x7F7F,
+        0x8080, 0x8181, 0x8282, 0x8383, 0x8484, 0x8585, 0x8686, 0x8787,
+        0x8888, 0x8989, 0x8A8A, 0x8B8B, 0x8C8C, 0x8D8D, 0x8E8E, 0x8F8F,
+        0x9090, 0x9191, 0x9292, 0x9393, 0x9494, 0x9595, 0x9696, 0x9797,
+        0x9898, 0x9999, 0x9A9A, 0x9B9B, 0x9C9C, 0x9D9D, 0x9E9E, 0x9F9F,
+        0xA0A0, 0xA1A1, 0xA2A2, 0xA3A3, 0xA4A4, 0xA5A5, 0xA6A6, 0xA7A7,
+        0xA8A8, 0xA9A9, 0xAAAA, 0xABAB, 0xACAC, 0xADAD, 0xAEAE, 0xAFAF,
+        0xB0B0, 0xB1B1, 0xB2B2, 0xB3B3, 0xB4B4, 0xB5B5, 0xB6B6, 0xB7B7,
+        0xB8B8, 0xB9B9, 0xBABA, 0xBBBB, 0xBCBC, 0xBDBD, 0xBEBE, 0xBFBF,
+        0xC0C0, 0xC1C1, 0xC2C2, 0xC3C3, 0xC4C4, 0xC5C5, 0xC6C6, 0xC7C7,
+        0xC8C8, 0xC9C9, 0xCACA, 0xCBCB, 0xCCCC, 0xCDCD, 0xCECE, 0xCFCF,
+        0xD0D0, 0xD1D1, 0xD2D2, 0xD3D3, 0xD4D4, 0xD5D5, 0xD6D6, 0xD7D7,
+        0xD8D8, 0xD9D9, 0xDADA, 0xDBDB, 0xDCDC, 0xDDDD, 0xDEDE, 0xDFDF,
+        0xE0E0, 0xE1E1, 0xE2E2, 0xE3E3, 0xE4E4, 0xE5E5, 0xE6E6, 0xE7E7,
+        0xE8E8, 0xE9E9, 0xEAEA, 0xEBEB, 0xECEC, 0xEDED, 0xEEEE, 0xEFEF,
+        0xF0F0, 0xF1F1, 0xF2F2, 0xF3F3, 0xF4F4, 0xF5F5, 0xF6F6, 0xF7F7,
+        0xF8F8, 0xF9F9, 0xFAFA, 0xFBFB, 0xFCFC, 0xFDFD, 0xFEFE, 0xFFFF,
+    },
+    /* Exponential */
+    {
+        0x0000, 0x0013, 0x0027, 0x003B, 0x004F, 0x0064, 0x0079, 0x008E,
+        0x00A3, 0x00B9, 0x00D0, 0x00E6, 0x00FD, 0x0115, 0x012C, 0x0144,
+        0x015D, 0x0176, 0x018F, 0x01A9, 0x01C3, 0x01DD, 0x01F8, 0x0213,
+        0x022F, 0x024B, 0x0268, 0x0285, 0x02A2, 0x02C0, 0x02DF, 0x02FE,
+        0x031D, 0x033D, 0x035E, 0x037E, 0x03A0, 0x03C2, 0x03E4, 0x0408,
+        0x042B, 0x044F, 0x0474, 0x049A, 0x04C0, 0x04E6, 0x050D, 0x0535,
+        0x055D, 0x0586, 0x05B0, 0x05DA, 0x0606, 0x0631, 0x065E, 0x068B,
+        0x06B9, 0x06E7, 0x0716, 0x0746, 0x0777, 0x07A9, 0x07DB, 0x080E,
+        0x0842, 0x0877, 0x08AC, 0x08E3, 0x091A, 0x0952, 0x098B, 0x09C5,
+        0x0A00, 0x0A3C, 0x0A79, 0x0AB6, 0x0AF5, 0x0B35, 0x0B75, 0x0BB7,
+        0x0BFA, 0x0C3E, 0x0C83, 0x0CC9, 0x0D10, 0x0D58, 0x0DA1, 0x0DEC,
+        0x0E37, 0x0E84, 0x0ED2, 0x0F22, 0x0F72, 0x0FC4, 0x1017, 0x106C,
+        0x10C1, 0x1119, 0x1171, 0x11CB, 0x1226, 0x1283, 0x12E1, 0x1341,
+        0x13A2, 0x1405, 0x146A, 0x14D0, 0x1537, 0x15A0, 0x160B, 0x1678,
+        0x16E6, 0x1756, 0x17C8, 0x183B, 0x18B1, 0x1928, 0x19A1, 0x1A1C,
+        0x1A99, 0x1B18, 0x1B99, 0x1C1C, 0x1CA1, 0x1D29, 0x1DB2, 0x1E3D,
+        0x1ECB, 0x1F5B, 0x1FED, 0x2082, 0x2119, 0x21B2, 0x224E, 0x22EC,
+        0x238D, 0x2430, 0x24D6, 0x257E, 0x2629, 0x26D7, 0x2787, 0x283B,
+        0x28F1, 0x29AA, 0x2A66, 0x2B25, 0x2BE7, 0x2CAC, 0x2D74, 0x2E3F,
+        0x2F0E, 0x2FDF, 0x30B5, 0x318D, 0x3269, 0x3348, 0x342B, 0x3512,
+        0x35FC, 0x36EA, 0x37DB, 0x38D1, 0x39CA, 0x3AC7, 0x3BC8, 0x3CCE,
+        0x3DD7, 0x3EE5, 0x3FF6, 0x410D, 0x4227, 0x4346, 0x446A, 0x4592,
+        0x46BF, 0x47F1, 0x4927, 0x4A63, 0x4BA3, 0x4CE9, 0x4E33, 0x4F83,
+        0x50D8, 0x5233, 0x5393, 0x54F8, 0x5663, 0x57D4, 0x594B, 0x5AC8,
+        0x5C4B, 0x5DD4, 0x5F63, 0x60F8, 0x6294, 0x6436, 0x65DF, 0x678F,
+        0x6945, 0x6B03, 0x6CC7, 0x6E93, 0x7065, 0x7240, 0x7421, 0x760B,
+        0x77FC, 0x79F5, 0x7BF6, 0x7DFF, 0x8010, 0x822A, 0x844C, 0x8677,
+        0x88AA, 0x8AE7, 0x8D2C, 0x8F7B, 0x91D3, 0x9434, 0x96A0, 0x9915,
+        0x9B93, 0x9E1C, 0xA0B0, 0xA34D, 0xA5F6, 0xA8A9, 0xAB67, 0xAE30,
+        0xB104, 0xB3E4, 0xB6CF, 0xB9C6, 0xBCCA, 0xBFD9, 0xC2F5, 0xC61D,
+        0xC952, 0xCC95, 0xCFE4, 0xD341, 0xD6AB, 0xDA23, 0xDDA9, 0xE13E,
+        0xE4E1, 0xE893, 0xEC53, 0xF023, 0xF402, 0xF7F1, 0xFBF0, 0xFFFF,
+    },
+    /* Logarithmic */
+    {
+        0x0000, 0x040F, 0x080E, 0x0BFD, 0x0FDC, 0x13AC, 0x176C, 0x1B1E,
+        0x1EC1, 0x2256, 0x25DC, 0x2954, 0x2CBE, 0x301B, 0x336A, 0x36AD,
+        0x39E2, 0x3D0A, 0x4026, 0x4335, 0x4639, 0x4930, 0x4C1B, 0x4EFB,
+        0x51CF, 0x5498, 0x5756, 0x5A09, 0x5CB2, 0x5F4F, 0x61E3, 0x646C,
+        0x66EA, 0x695F, 0x6BCB, 0x6E2C, 0x7084, 0x72D3, 0x7518, 0x7755,
+        0x7988, 0x7BB3, 0x7DD5, 0x7FEF, 0x8200, 0x8409, 0x860A, 0x8803,
+        0x89F4, 0x8BDE, 0x8DBF, 0x8F9A, 0x916C, 0x9338, 0x94FC, 0x96BA,
+        0x9870, 0x9A20, 0x9BC9, 0x9D6B, 0x9F07, 0xA09C, 0xA22B, 0xA3B4,
+        0xA537, 0xA6B4, 0xA82B, 0xA99C, 0xAB07, 0xAC6C, 0xADCC, 0xAF27,
+        0xB07C, 0xB1CC, 0xB316, 0xB45C, 0xB59C, 0xB6D8, 0xB80E, 0xB940,
+        0xBA6D, 0xBB95, 0xBCB9, 0xBDD8, 0xBEF2, 0xC009, 0xC11A, 0xC228,
+        0xC331, 0xC437, 0xC538, 0xC635, 0xC72E, 0xC824, 0xC915, 0xCA03,
+        0xCAED, 0xCBD4, 0xCCB7, 0xCD96, 0xCE72, 0xCF4A, 0xD020, 0xD0F1,
+        0xD1C0, 0xD28B, 0xD353, 0xD418, 0xD4DA, 0xD599, 0xD655, 0xD70E,
+        0xD7C4, 0xD878, 0xD928, 0xD9D6, 0xDA81, 0xDB29, 0xDBCF, 0xDC72,
+        0xDD13, 0xDDB1, 0xDE4D, 0xDEE6, 0xDF7D, 0xE012, 0xE0A4, 0xE134,
+        0xE1C2, 0xE24D, 0xE2D6, 0xE35E, 0xE3E3, 0xE466, 0xE4E7, 0xE566,
+        0xE5E3, 0xE65E, 0xE6D7, 0xE74E, 0xE7C4, 0xE837, 0xE8A9, 0xE919,
+        0xE987, 0xE9F4, 0xEA5F, 0xEAC8, 0xEB2F, 0xEB95, 0xEBFA, 0xEC5D,
+        0xECBE, 0xED1E, 0xED7C, 0xEDD9, 0xEE34, 0xEE8E, 0xEEE6, 0xEF3E,
+        0xEF93, 0xEFE8, 0xF03B, 0xF08D, 0xF0DD, 0xF12D, 0xF17B, 0xF1C8,
+        0xF213, 0xF25E, 0xF2A7, 0xF2EF, 0xF336, 0xF37C, 0xF3C1, 0xF405,
+        0xF448, 0xF48A, 0xF4CA, 0xF50A, 0xF549, 0xF586, 0xF5C3, 0xF5FF,
+        0xF63A, 0xF674, 0xF6AD, 0xF6E5, 0xF71C, 0xF753, 0xF788, 0xF7BD,
+        0xF7F1, 0xF824, 0xF856, 0xF888, 0xF8B9, 0xF8E9, 0xF918, 0xF946,
+        0xF974, 0xF9A1, 0xF9CE, 0xF9F9, 0xFA25, 0xFA4F, 0xFA79, 0xFAA2,
+        0xFACA, 0xFAF2, 0xFB19, 0xFB3F, 0xFB65, 0xFB8B, 0xFBB0, 0xFBD4,
+        0xFBF7, 0xFC1B, 0xFC3D, 0xFC5F, 0xFC81, 0xFCA1, 0xFCC2, 0xFCE2,
+        0xFD01, 0xFD20, 0xFD3F, 0xFD5D, 0xFD7A, 0xFD97, 0xFDB4, 0xFDD0,
+        0xFDEC, 0xFE07, 0xFE22, 0xFE3C, 0xFE56, 0xFE70, 0xFE89, 0xFEA2,
+        0xFEBB, 0xFED3, 0xFEEA, 0xFF02, 0xFF19, 0xFF2F, 0xFF46, 0xFF5C,
+        0xFF71, 0xFF86, 0xFF9B, 0xFFB0, 0xFFC4, 0xFFD8, 0xFFEC, 0xFFFF,
+    },
+};
+
+/** User curve tables, changes are written on the back one and published by
+    switching the pointer, so readers always see a whole table */
+static uint16_t u16CurveUser[2][CV_CURVE_SIZE];
+static const uint16_t * volatile pu16CurveUser = u16CurveUser[0];
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Get user curve table not being read.
+ * @retval back table.
+ */
+static uint16_t *_get_back(void);
+
+/* Private application code --------------------------------------------------*/
+
+static uint16_t *_get_back(void)
+{
+    return (pu16CurveUser == u16CurveUser[0]) ? u16CurveUser[1] : u16CurveUser[0];
+}
+
+/* Public application code ---------------------------------------------------*/
+
+void cv_curve_init(void)
+{
+    for (uint32_t i = 0; i < CV_CURVE_SIZE; i++)
+    {
+        u16CurveUser[0][i] = u16CurveLut[CV_CURVE_LINEAR][i];
+    }
+    pu16CurveUser = u16CurveUser[0];
+}
+
+uint16_t cv_curve_apply(uint8_t curve, uint16_t value)
+{
+    const uint16_t *pu16Lut = (curve == CV_CURVE_USER) ? pu16CurveUser : u16CurveLut[(curve < CV_CURVE_USER) ? curve : CV_CURVE_LINEAR];
+    uint32_t u32Index = (uint32_t)value >> CURVE_FRAC_BITS;
+    uint32_t u32Frac = (uint32_t)value & CURVE_FRAC_MASK;
+    int32_t i32Code = (int32_t)pu16Lut[u32Index];
+
+    /* 7 bit values expanded by cv_ctrl have no fraction and take a single
+       lookup, 14 bit values interpolate to the next entry */
+    if ((u32Frac != 0U) && (u32Index < (CV_CURVE_SIZE - 1U)))
+    {
+        i32Code += (((int32_t)pu16Lut[u32Index + 1U] - i32Code) * (int32_t)u32Frac) >> CURVE_FRAC_BITS;
+    }
+
+    return (uint16_t)i32Code;
+}
+
+bool cv_curve_set_user(uint8_t in_start, uint8_t in_end, uint16_t out_start, uint16_t out_end)
+{
+    bool bRetval = false;
+
+    if (in_start <= in_end)
+    {
+        uint16_t *pu16Back = _get_back();
+        uint32_t u32Span = (uint32_t)in_end - in_start;
+
+        for (uint32_t i = 0; i < CV_CURVE_SIZE; i++)
+        {
+            pu16Back[i] = pu16CurveUser[i];
+        }
+
+        for (uint32_t i = 0; i <= u32Span; i++)
+        {
+            int32_t i32Step = (u32Span != 0U) ? ((((int32_t)out_end - (int32_t)out_start) * (int32_t)i) / (int32_t)u32Span) : 0;
+            pu16Back[in_start + i] = (uint16_t)((int32_t)out_start + i32Step);
+        }
+
+        pu16CurveUser = pu16Back;
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+const uint16_t *cv_curve_get_user(void)
+{
+    return pu16CurveUser;
+}
+
+void cv_curve_load_user(const uint16_t *table)
+{
+    uint16_t *pu16Back = _get_back();
+
+    for (uint32_t i = 0; i < CV_CURVE_SIZE; i++)
+    {
+        pu16Back[i] = table[i];
+    }
+
+    pu16CurveUser = pu16Back;
+}
+
+/* EOF */
@@ -0,0 +1,820 @@
+/**
+ * @file    cv_engine.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   MIDI to CV engine. Translates MIDI messages into output frames.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "cv_engine.h"
+#include "cv_cal.h"
+#include "cv_clock.h"
+#include "cv_ctrl.h"
+#include "cv_curve.h"
+#include "cv_param.h"
+#include "cv_lfo.h"
+#include "cv_env.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+
+/** Voice state */
+typedef struct cv_voice
+{
+    uint8_t note;           /**< Current note */
+    uint8_t velocity;       /**< Note on velocity */
+    bool active;            /**< Gate state */
+    uint32_t age;           /**< Note on order, used for voice stealing */
+    int32_t glide_from;     /**< Pitch offset from the note at glide start, in codes */
+    uint32_t glide_pos;     /**< Glide progress, 16.16, CV_GLIDE_END when done */
+    uint32_t glide_step;    /**< Glide progress per tick */
+} cv_voice_t;
+
+/** Gate output state in gate mode */
+typedef struct cv_gate_state
+{
+    uint16_t count;         /**< Remaining trigger ticks */
+    uint8_t held;           /**< Held notes routed to output */
+    bool latch;             /**< Latch state */
+    bool accent;            /**< Accent of last hit */
+} cv_gate_state_t;
+
+/* Private define ------------------------------------------------------------*/
+
+/* Notes remembered for mono last note priority */
+#define CV_MONO_STACK_SIZE      8U
+
+/* Control change numbers */
+#define CV_CC_RESET_ALL         121U
+#define CV_CC_ALL_NOTES_OFF     123U
+
+/* Pitch bend times cents per code, 8192 bend steps and 100 cents per semitone */
+#define CV_BEND_DIV             ((MIDI_PITCH_BEND_CENTER * 100U) / CV_CODES_PER_SEMITONE)
+
+/* Default gate mode map, GM drum notes */
+#define CV_GM_KICK              36U
+#define CV_GM_SNARE             38U
+#define CV_GM_CLOSED_HAT        42U
+#define CV_GM_OPEN_HAT          46U
+
+/* Default accent threshold */
+#define CV_ACCENT_VEL           100U
+
+/* Glide progress given to the response curves, 14 bit */
+#define CV_GLIDE_FULL           0x3FFFU
+
+/* Glide progress at the note, 16 fraction bits per curve step */
+#define CV_GLIDE_END            (CV_GLIDE_FULL << 16)
+
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+
+/** Default engine configuration, used until a preset is applied */
+static cv_engine_cfg_t xEngineDefault;
+
+/** Active engine configuration */
+static cv_engine_cfg_t *pxEngineCfg = &xEngineDefault;
+
+/** Mode used by the current engine state */
+static uint8_t u8ActiveMode = CV_MODE_NUM;
+
+/** Parameters in use and their sequence on the registry */
+static cv_param_values_t xParam;
+static uint32_t u32ParamSeq = CV_PARAM_SEQ_NONE;
+
+/** Voice mode state */
+static cv_voice_t xVoice[CV_VOICE_NUM];
+static uint32_t u32VoiceAge = 0U;
+static uint8_t u8VoiceNext = 0U;
+static uint8_t u8MonoStack[CV_MONO_STACK_SIZE];
+static uint8_t u8MonoCount = 0U;
+
+/** Gate mode state */
+static cv_gate_state_t xGate[CV_GATE_NUM];
+
+/** Pitch bend, centered on zero */
+static int16_t i16Bend = 0;
+
+/** Number of voices used by each mode */
+static const uint8_t u8ModeVoices[CV_MODE_NUM] = {
+    1U, /* Mono */
+    2U, /* Dual */
+    4U, /* Quad */
+    0U, /* Gate */
+};
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Reset runtime state, used on init and mode change.
+ * @retval None.
+ */
+static void _reset_state(void);
+
+/**
+ * @brief  Take parameters published on the registry and apply mode changes.
+ * @retval None.
+ */
+static void _check_param(void);
+
+/**
+ * @brief  Move held notes to the voices of a new voice mode, the newest
+ *         notes keep sounding.
+ * @param  mode new voice mode.
+ * @retval None.
+ */
+static void _remap_voices(uint8_t mode);
+
+/**
+ * @brief  Move a voice to a new note, gliding from its current pitch when
+ *         glide is enabled.
+ * @param  voice voice number.
+ * @param  note MIDI note.
+ * @retval None.
+ */
+static void _voice_set_note(uint8_t voice, uint8_t note);
+
+/**
+ * @brief  Get pitch offset of a voice still gliding to its note.
+ * @param  voice voice number.
+ * @retval offset from the note in output codes.
+ */
+static int32_t _voice_glide(uint8_t voice);
+
+/**
+ * @brief  Handle note on in voice modes.
+ * @param  note MIDI note.
+ * @param  velocity MIDI velocity.
+ * @retval None.
+ */
+static void _voice_note_on(uint8_t note, uint8_t velocity);
+
+/**
+ * @brief  Handle note off in voice modes.
+ * @param  note MIDI note.
+ * @retval None.
+ */
+static void _voice_note_off(uint8_t note);
+
+/**
+ * @brief  Handle note on in gate mode.
+ * @param  note MIDI note.
+ * @param  velocity MIDI velocity.
+ * @retval None.
+ */
+static void _gate_note_on(uint8_t note, uint8_t velocity);
+
+/**
+ * @brief  Handle note off in gate mode.
+ * @param  note MIDI note.
+ * @retval None.
+ */
+static void _gate_note_off(uint8_t note);
+
+/**
+ * @brief  Get pitch code of a note with pitch bend and modulation applied.
+ * @param  out analog output.
+ * @param  note MIDI note.
+ * @param  mod pitch modulation in output codes.
+ * @retval calibrated output code.
+ */
+static uint16_t _voice_pitch(uint8_t out, uint8_t note, int32_t mod);
+
+/**
+ * @brief  Get gate outputs of current mode.
+ * @retval gate outputs, bit n for gate n.
+ */
+static uint8_t _get_gates(void);
+
+/* Private application code --------------------------------------------------*/
+
+static void _reset_state(void)
+{
+    for (uint32_t i = 0; i < CV_VOICE_NUM; i++)
+    {
+        xVoice[i].note = 0U;
+        xVoice[i].velocity = 0U;
+        xVoice[i].active = false;
+        xVoice[i].age = 0U;
+        xVoice[i].glide_pos = CV_GLIDE_END;
+    }
+
+    for (uint32_t i = 0; i < CV_GATE_NUM; i++)
+    {
+        xGate[i].count = 0U;
+        xGate[i].held = 0U;
+        xGate[i].latch = false;
+        xGate[i].accent = false;
+    }
+
+    u32VoiceAge = 0U;
+    u8VoiceNext = 0U;
+    u8MonoCount = 0U;
+}
+
+static void _check_param(void)
+{
+    uint8_t u8Mode;
+
+    /* Values are range checked by the registry, a write in progress keeps
+       the previous ones until the next call */
+    (void)cv_param_read(&xParam, &u32ParamSeq);
+    u8Mode = xParam.mode;
+
+    if (u8Mode != u8ActiveMode)
+    {
+        /* Notes held in another voice mode keep playing, gate mode listens
+           on its own channel so there is nothing to carry over */
+        if ((u8ActiveMode < CV_MODE_GATE) && (u8Mode < CV_MODE_GATE))
+        {
+            _remap_voices(u8Mode);
+        }
+        else
+        {
+            _reset_state();
+        }
+
+        u8ActiveMode = u8Mode;
+    }
+}
+
+static void _remap_voices(uint8_t mode)
+{
+    uint8_t u8Voices = u8ModeVoices[mode];
+    uint8_t u8Held[CV_MONO_STACK_SIZE];
+    uint8_t u8Vel[CV_MONO_STACK_SIZE];
+    uint8_t u8Num = 0U;
+
+    /* Held notes from oldest to newest */
+    if (u8ActiveMode == CV_MODE_MONO)
+    {
+        for (uint8_t i = 0; (i < u8MonoCount) && xVoice[0].active; i++)
+        {
+            u8Held[u8Num] = u8MonoStack[i];
+            u8Vel[u8Num++] = xVoice[0].velocity;
+        }
+    }
+    else
+    {
+        uint32_t u32Last = 0U;
+
+        for (uint8_t n = 0; n < u8ModeVoices[u8ActiveMode]; n++)
+        {
+            uint8_t u8Sel = CV_VOICE_NUM;
+
+            for (uint8_t i = 0; i < u8ModeVoices[u8ActiveMode]; i++)
+            {
+                if (xVoice[i].active && (xVoice[i].age > u32Last) &&
+                    ((u8Sel == CV_VOICE_NUM) || (xVoice[i].age < xVoice[u8Sel].age)))
+                {
+                    u8Sel = i;
+                }
+            }
+
+            if (u8Sel != CV_VOICE_NUM)
+            {
+                u32Last = xVoice[u8Sel].age;
+                u8Held[u8Num] = xVoice[u8Sel].note;
+                u8Vel[u8Num++] = xVoice[u8Sel].velocity;
+            }
+        }
+    }
+
+    if (mode == CV_MODE_MONO)
+    {
+        /* Newest note is the one to play */
+        for (uint8_t i = 0; i < u8Num; i++)
+        {
+            u8MonoStack[i] = u8Held[i];
+        }
+        u8MonoCount = u8Num;
+
+        if (u8Num != 0U)
+        {
+            bool bMoved = (xVoice[0].note != u8Held[u8Num - 1U]) || !xVoice[0].active;
+
+            _voice_set_note(0U, u8Held[u8Num - 1U]);
+            xVoice[0].velocity = u8Vel[u8Num - 1U];
+            xVoice[0].active = true;
+            if (bMoved)
+            {
+                cv_env_trigger(0U, xVoice[0].velocity);
+            }
+        }
+        else
+        {
+            xVoice[0].active = false;
+        }
+
+        for (uint32_t i = 1; i < CV_VOICE_NUM; i++)
+        {
+            xVoice[i].active = false;
+        }
+    }
+    else
+    {
+        uint8_t u8First = (u8Num > u8Voices) ? (uint8_t)(u8Num - u8Voices) : 0U;
+        uint8_t u8Sel[CV_MONO_STACK_SIZE];
+
+        for (uint8_t n = 0; n < u8Num; n++)
+        {
+            u8Sel[n] = CV_VOICE_NUM;
+        }
+
+        /* Voices that keep their note are left untouched, notes beyond the
+           voice count are dropped oldest first */
+        for (uint8_t i = 0; i < CV_VOICE_NUM; i++)
+        {
+            bool bKeep = false;
+
+            for (uint8_t n = u8First; (n < u8Num) && (i < u8Voices) && xVoice[i].active && !bKeep; n++)
+            {
+                if ((xVoice[i].note == u8Held[n]) && (u8Sel[n] == CV_VOICE_NUM))
+                {
+                    u8Sel[n] = i;
+                    bKeep = true;
+                }
+            }
+
+            xVoice[i].active = bKeep;
+        }
+
+        for (uint8_t n = u8First; n < u8Num; n++)
+        {
+            for (uint8_t i = 0; (i < u8Voices) && (u8Sel[n] == CV_VOICE_NUM); i++)
+            {
+                if (!xVoice[i].active)
+                {
+                    _voice_set_note(i, u8Held[n]);
+                    xVoice[i].velocity = u8Vel[n];
+                    xVoice[i].active = true;
+                    u8Sel[n] = i;
+                    cv_env_trigger(i, xVoice[i].velocity);
+                }
+            }
+
+            /* Ages follow note on order for voice stealing */
+            xVoice[u8Sel[n]].age = ++u32VoiceAge;
+        }
+
+        u8MonoCount = 0U;
+        u8VoiceNext = 0U;
+    }
+}
+
+static void _voice_set_note(uint8_t voice, uint8_t note)
+{
+    cv_voice_t *pxVoice = &xVoice[voice];
+    uint32_t u32Len = CV_MS_TO_TICKS(xParam.glide_ms);
+
+    if (u32Len == 0U)
+    {
+        pxVoice->glide_pos = CV_GLIDE_END;
+    }
+    else if (note != pxVoice->note)
+    {
+        /* Start from the output pitch, even in the middle of another glide.
+           Output stays between notes, so the offset fits 16 bits and its
+           product with 14 bit progress fits 32 */
+        pxVoice->glide_from = _voice_glide(voice) + (((int32_t)pxVoice->note - (int32_t)note) * (int32_t)CV_CODES_PER_SEMITONE);
+        pxVoice->glide_step = CV_GLIDE_END / u32Len;
+        pxVoice->glide_pos = 0U;
+    }
+    else
+    {
+        /* Same note keeps its glide */
+    }
+
+    pxVoice->note = note;
+}
+
+static int32_t _voice_glide(uint8_t voice)
+{
+    const cv_voice_t *pxVoice = &xVoice[voice];
+    int32_t i32Offset = 0;
+
+    if (pxVoice->glide_pos < CV_GLIDE_END)
+    {
+        /* Curve output is 16 bit, 14 are kept */
+        uint16_t u16Done = cv_curve_apply(xParam.glide_curve, (uint16_t)(pxVoice->glide_pos >> 16)) >> 2;
+
+        i32Offset = (pxVoice->glide_from * ((int32_t)CV_GLIDE_FULL - (int32_t)u16Done)) / (int32_t)(CV_GLIDE_FULL + 1U);
+    }
+
+    return i32Offset;
+}
+
+static void _voice_note_on(uint8_t note, uint8_t velocity)
+{
+    uint8_t u8Voices = u8ModeVoices[u8ActiveMode];
+    uint8_t u8Sel = CV_VOICE_NUM;
+
+    if (u8ActiveMode == CV_MODE_MONO)
+    {
+        /* Last note priority, drop oldest note when stack is full */
+        if (u8MonoCount == CV_MONO_STACK_SIZE)
+        {
+            for (uint32_t i = 1; i < CV_MONO_STACK_SIZE; i++)
+            {
+                u8MonoStack[i - 1U] = u8MonoStack[i];
+            }
+            u8MonoCount--;
+        }
+        u8MonoStack[u8MonoCount++] = note;
+        u8Sel = 0U;
+    }
+    else
+    {
+        /* Retrigger voice already playing the note */
+        for (uint8_t i = 0; i < u8Voices; i++)
+        {
+            if (xVoice[i].active && (xVoice[i].note == note))
+            {
+                u8Sel = i;
+                break;
+            }
+        }
+
+        /* Round robin over free voices */
+        for (uint8_t i = 0; (i < u8Voices) && (u8Sel == CV_VOICE_NUM); i++)
+        {
+            uint8_t u8Idx = (uint8_t)((u8VoiceNext + i) % u8Voices);
+            if (!xVoice[u8Idx].active)
+            {
+                u8Sel = u8Idx;
+            }
+        }
+
+        /* Steal oldest voice */
+        if (u8Sel == CV_VOICE_NUM)
+        {
+            u8Sel = 0U;
+            for (uint8_t i = 1; i < u8Voices; i++)
+            {
+                if (xVoice[i].age < xVoice[u8Sel].age)
+                {
+                    u8Sel = i;
+                }
+            }
+        }
+
+        u8VoiceNext = (uint8_t)((u8Sel + 1U) % u8Voices);
+    }
+
+    _voice_set_note(u8Sel, note);
+    xVoice[u8Sel].velocity = velocity;
+    xVoice[u8Sel].active = true;
+    xVoice[u8Sel].age = ++u32VoiceAge;
+
+    cv_env_trigger(u8Sel, velocity);
+}
+
+static void _voice_note_off(uint8_t note)
+{
+    if (u8ActiveMode == CV_MODE_MONO)
+    {
+        uint8_t u8Out = 0U;
+
+        /* Remove note from stack */
+        for (uint8_t i = 0; i < u8MonoCount; i++)
+        {
+            if (u8MonoStack[i] != note)
+            {
+                u8MonoStack[u8Out++] = u8MonoStack[i];
+            }
+        }
+        u8MonoCount = u8Out;
+
+        /* Fall back to previous held note */
+        if (u8MonoCount != 0U)
+        {
+            _voice_set_note(0U, u8MonoStack[u8MonoCount - 1U]);
+        }
+        else
+        {
+            xVoice[0].active = false;
+        }
+    }
+    else
+    {
+        for (uint8_t i = 0; i < u8ModeVoices[u8ActiveMode]; i++)
+        {
+            if (xVoice[i].active && (xVoice[i].note == note))
+            {
+                xVoice[i].active = false;
+            }
+        }
+    }
+}
+
+static void _gate_note_on(uint8_t note, uint8_t velocity)
+{
+    uint8_t u8Mask = pxEngineCfg->gate_map[note];
+
+    for (uint32_t i = 0; (i < CV_GATE_NUM) && (u8Mask != 0U); i++, u8Mask >>= 1)
+    {
+        if ((u8Mask & 0x01U) != 0U)
+        {
+            const cv_gate_cfg_t *pxCfg = &pxEngineCfg->gate[i];
+            cv_gate_state_t *pxGate = &xGate[i];
+
+            pxGate->count = pxCfg->len_ticks;
+            pxGate->accent = (velocity >= pxCfg->accent_vel);
+            cv_env_trigger((uint8_t)i, velocity);
+
+            if (pxCfg->type == CV_GATE_LATCH)
+            {
+                pxGate->latch = !pxGate->latch;
+            }
+            else if ((pxCfg->type == CV_GATE_GATE) && (pxGate->held < UINT8_MAX))
+            {
+                pxGate->held++;
+            }
+            else
+            {
+                /* Trigger only uses counter */
+            }
+        }
+    }
+}
+
+static void _gate_note_off(uint8_t note)
+{
+    uint8_t u8Mask = pxEngineCfg->gate_map[note];
+
+    for (uint32_t i = 0; (i < CV_GATE_NUM) && (u8Mask != 0U); i++, u8Mask >>= 1)
+    {
+        if (((u8Mask & 0x01U) != 0U) && (xGate[i].held != 0U))
+        {
+            xGate[i].held--;
+        }
+    }
+}
+
+static uint16_t _voice_pitch(uint8_t out, uint8_t note, int32_t mod)
+{
+    mod += ((int32_t)i16Bend * (int32_t)cv_ctrl_get_bend_range()) / (int32_t)CV_BEND_DIV;
+
+    return cv_cal_pitch(out, note, mod);
+}
+
+static uint8_t _get_gates(void)
+{
+    uint8_t u8Gates = 0U;
+
+    for (uint32_t i = 0; i < CV_GATE_NUM; i++)
+    {
+        bool bOn = false;
+
+        if (u8ActiveMode == CV_MODE_GATE)
+        {
+            const cv_gate_state_t *pxGate = &xGate[i];
+            uint8_t u8Type = pxEngineCfg->gate[i].type;
+
+            if (u8Type == CV_GATE_LATCH)
+            {
+                bOn = pxGate->latch;
+            }
+            else if (u8Type == CV_GATE_GATE)
+            {
+                /* Min length keeps zero length notes visible */
+                bOn = (pxGate->held != 0U) || (pxGate->count != 0U);
+            }
+            else
+            {
+                bOn = (pxGate->count != 0U);
+            }
+        }
+        else if (i < u8ModeVoices[u8ActiveMode])
+        {
+            bOn = xVoice[i].active;
+        }
+        else
+        {
+            /* Unused gate */
+        }
+
+        if (bOn)
+        {
+            u8Gates |= (uint8_t)(1U << i);
+        }
+    }
+
+    return u8Gates;
+}
+
+/* Public application code ---------------------------------------------------*/
+
+void cv_engine_init(void)
+{
+    pxEngineCfg = &xEngineDefault;
+
+    for (uint32_t i = 0; i < MIDI_NOTE_NUM; i++)
+    {
+        pxEngineCfg->gate_map[i] = 0U;
+    }
+    pxEngineCfg->gate_map[CV_GM_KICK] = (1U << 0);
+    pxEngineCfg->gate_map[CV_GM_SNARE] = (1U << 1);
+    pxEngineCfg->gate_map[CV_GM_CLOSED_HAT] = (1U << 2);
+    pxEngineCfg->gate_map[CV_GM_OPEN_HAT] = (1U << 3);
+
+    for (uint32_t i = 0; i < CV_GATE_NUM; i++)
+    {
+        pxEngineCfg->gate[i].type = CV_GATE_TRIGGER;
+        pxEngineCfg->gate[i].accent_vel = CV_ACCENT_VEL;
+        pxEngineCfg->gate[i].len_ticks = CV_MS_TO_TICKS(CV_TRIGGER_MS);
+    }
+
+    cv_clock_init();
+    cv_ctrl_init();
+    cv_lfo_init();
+    cv_env_init();
+    cv_param_init();
+    i16Bend = 0;
+
+    u8ActiveMode = CV_MODE_NUM;
+    u32ParamSeq = CV_PARAM_SEQ_NONE;
+    _check_param();
+}
+
+const cv_engine_cfg_t *cv_engine_get_cfg(void)
+{
+    return pxEngineCfg;
+}
+
+void cv_engine_set_cfg(cv_engine_cfg_t *cfg)
+{
+    USER_ASSERT(cfg != NULL);
+
+    pxEngineCfg = cfg;
+    _check_param();
+}
+
+bool cv_engine_midi(midi_msg_t msg)
+{
+    uint8_t u8Type = MIDI_MSG_TYPE(msg);
+    uint8_t u8Channel = MIDI_MSG_CHANNEL(msg);
+    uint8_t u8Data1 = MIDI_MSG_DATA1(msg);
+    bool bGateMode;
+    bool bRetval = false;
+
+    _check_param();
+    bGateMode = (u8ActiveMode == CV_MODE_GATE);
+
+    /* Channel filter, system messages are handled by other layers */
+    if ((u8Type < MIDI_SYSEX_START) &&
+        (u8Channel == (bGateMode ? xParam.gate_channel : xParam.channel)))
+    {
+        /* Controllers only count when mapped to an output */
+        bRetval = true;
+
+        if (u8Type == MIDI_NOTE_ON)
+        {
+            cv_ctrl_note(u8Data1, MIDI_MSG_DATA2(msg));
+
+            if (bGateMode)
+            {
+                _gate_note_on(u8Data1, MIDI_MSG_DATA2(msg));
+            }
+            else
+            {
+                _voice_note_on(u8Data1, MIDI_MSG_DATA2(msg));
+            }
+        }
+        else if (u8Type == MIDI_NOTE_OFF)
+        {
+            if (bGateMode)
+            {
+                _gate_note_off(u8Data1);
+            }
+            else
+            {
+                _voice_note_off(u8Data1);
+            }
+        }
+        else if ((u8Type == MIDI_CONTROL_CHANGE) && (u8Data1 == CV_CC_ALL_NOTES_OFF))
+        {
+            _reset_state();
+        }
+        else if ((u8Type == MIDI_CONTROL_CHANGE) && (u8Data1 == CV_CC_RESET_ALL))
+        {
+            i16Bend = 0;
+            cv_ctrl_reset();
+        }
+        else if (u8Type == MIDI_CONTROL_CHANGE)
+        {
+            bRetval = cv_ctrl_cc(u8Data1, MIDI_MSG_DATA2(msg));
+        }
+        else if (u8Type == MIDI_CHANNEL_PRESSURE)
+        {
+            bRetval = cv_ctrl_pressure(u8Data1);
+        }
+        else if (u8Type == MIDI_POLY_PRESSURE)
+        {
+            bRetval = cv_ctrl_poly_pressure(u8Data1, MIDI_MSG_DATA2(msg));
+        }
+        else if (u8Type == MIDI_PITCH_BEND)
+        {
+            i16Bend = (int16_t)((int32_t)MIDI_MSG_DATA14(msg) - (int32_t)MIDI_PITCH_BEND_CENTER);
+        }
+        else
+        {
+            /* Not handled */
+            bRetval = false;
+        }
+    }
+
+    return bRetval;
+}
+
+void cv_engine_tick(void)
+{
+    _check_param();
+
+    for (uint32_t i = 0; i < CV_GATE_NUM; i++)
+    {
+        if (xGate[i].count != 0U)
+        {
+            xGate[i].count--;
+        }
+    }
+
+    for (uint32_t i = 0; i < CV_VOICE_NUM; i++)
+    {
+        uint32_t u32Left = CV_GLIDE_END - xVoice[i].glide_pos;
+
+        xVoice[i].glide_pos += (u32Left > xVoice[i].glide_step) ? xVoice[i].glide_step : u32Left;
+    }
+
+    cv_clock_tick();
+    cv_ctrl_tick();
+    cv_lfo_tick();
+    cv_env_tick(_get_gates());
+}
+
+void cv_engine_get_frame(cv_frame_t *frame)
+{
+    USER_ASSERT(frame != NULL);
+
+    /* A new configuration may have been applied since the last tick */
+    _check_param();
+
+    frame->gates = _get_gates();
+
+    if (u8ActiveMode == CV_MODE_GATE)
+    {
+        for (uint32_t i = 0; i < CV_GATE_NUM; i++)
+        {
+            bool bOn = ((frame->gates & (1U << i)) != 0U);
+
+            /* Analog output n carries accent of gate n */
+            frame->analog[i] = (bOn && xGate[i].accent) ? CV_CODE_MAX : 0U;
+        }
+    }
+    else
+    {
+        int32_t i32Vibrato = cv_lfo_get_pitch();
+
+        for (uint32_t i = 0; i < CV_ANALOG_NUM; i++)
+        {
+            if (i < u8ModeVoices[u8ActiveMode])
+            {
+                frame->analog[i] = _voice_pitch((uint8_t)i, xVoice[i].note, i32Vibrato + _voice_glide((uint8_t)i));
+            }
+            else
+            {
+                frame->analog[i] = 0U;
+            }
+        }
+    }
+
+    /* Mapped controllers, LFOs and envelopes take over their outputs */
+    for (uint32_t i = 0; i < CV_ANALOG_NUM; i++)
+    {
+        bool bPitch = (u8ActiveMode != CV_MODE_GATE) && (i < u8ModeVoices[u8ActiveMode]);
+
+        bPitch = !cv_ctrl_get_code((uint8_t)i, &frame->analog[i]) && bPitch;
+        bPitch = !cv_lfo_get_code((uint8_t)i, &frame->analog[i]) && bPitch;
+        bPitch = !cv_env_get_code((uint8_t)i, &frame->analog[i]) && bPitch;
+
+        /* Pitch is calibrated through the note table */
+        if (!bPitch)
+        {
+            frame->analog[i] = cv_cal_apply((uint8_t)i, frame->analog[i]);
+        }
+    }
+
+    /* Clock functions take over their assigned gates */
+    frame->gates = cv_clock_apply_gates(frame->gates);
+}
+
+/* EOF */
@@ -0,0 +1,276 @@
+/**
+ * @file    cv_env.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   ADSR envelope generators triggered by note gates.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "cv_env.h"
+#include "cv_engine.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+
+/** Envelope stages */
+typedef enum
+{
+    ENV_IDLE = 0U,
+    ENV_ATTACK,
+    ENV_DECAY,
+    ENV_SUSTAIN,
+    ENV_RELEASE,
+} env_stage_t;
+
+/** Envelope state */
+typedef struct env_state
+{
+    uint8_t stage;          /**< Current stage, env_stage_t */
+    uint16_t level;         /**< Output level */
+    uint16_t peak;          /**< Attack target, scaled by velocity */
+    int32_t start;          /**< Segment start level */
+    int32_t delta;          /**< Segment target minus start */
+    uint32_t pos;           /**< Segment position, 24 fractional bits */
+    uint32_t rate;          /**< Segment position increment per tick */
+} env_state_t;
+
+/* Private define ------------------------------------------------------------*/
+
+/* Segment table, 2^n steps plus end point */
+#define ENV_TABLE_BITS          8U
+#define ENV_TABLE_SIZE          (1U << ENV_TABLE_BITS)
+
+/* Segment position, full segment is 2^n */
+#define ENV_POS_BITS            24U
+#define ENV_POS_END             (1UL << ENV_POS_BITS)
+
+/* Position bits below table index */
+#define ENV_FRAC_BITS           (ENV_POS_BITS - ENV_TABLE_BITS)
+
+/* Table amplitude bits */
+#define ENV_SHAPE_BITS          15U
+
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+
+/** Exponential segment, 15 bit amplitude. Generated with Tools/curve_gen.py */
+static const uint16_t u16EnvLut[ENV_TABLE_SIZE + 1U] = {
+    0x0000, 0x027E, 0x04F0, 0x0755, 0x09AF, 0x0BFD, 0x0E40, 0x1078,
+    0x12A4, 0x14C6, 0x16DD, 0x18EA, 0x1AED, 0x1CE5, 0x1ED4, 0x20BA,
+    0x2296, 0x2469, 0x2632, 0x27F3, 0x29AC, 0x2B5B, 0x2D03, 0x2EA2,
+    0x3039, 0x31C8, 0x3350, 0x34D0, 0x3649, 0x37BA, 0x3924, 0x3A87,
+    0x3BE3, 0x3D39, 0x3E88, 0x3FD0, 0x4112, 0x424E, 0x4384, 0x44B4,
+    0x45DE, 0x4702, 0x4820, 0x4939, 0x4A4D, 0x4B5B, 0x4C64, 0x4D68,
+    0x4E66, 0x4F60, 0x5055, 0x5146, 0x5231, 0x5318, 0x53FB, 0x54D9,
+    0x55B3, 0x5689, 0x575B, 0x5828, 0x58F2, 0x59B7, 0x5A79, 0x5B37,
+    0x5BF2, 0x5CA9, 0x5D5C, 0x5E0C, 0x5EB8, 0x5F61, 0x6007, 0x60A9,
+    0x6149, 0x61E5, 0x627F, 0x6315, 0x63A8, 0x6439, 0x64C7, 0x6552,
+    0x65DA, 0x6660, 0x66E3, 0x6764, 0x67E2, 0x685E, 0x68D7, 0x694E,
+    0x69C3, 0x6A35, 0x6AA5, 0x6B13, 0x6B7F, 0x6BE9, 0x6C51, 0x6CB6,
+    0x6D1A, 0x6D7C, 0x6DDC, 0x6E3A, 0x6E96, 0x6EF1, 0x6F4A, 0x6FA1,
+    0x6FF6, 0x704A, 0x709C, 0x70EC, 0x713B, 0x7189, 0x71D5, 0x721F,
+    0x7268, 0x72B0, 0x72F6, 0x733B, 0x737E, 0x73C0, 0x7401, 0x7441,
+    0x747F, 0x74BD, 0x74F9, 0x7534, 0x756D, 0x75A6, 0x75DD, 0x7614,
+    0x7649, 0x767E, 0x76B1, 0x76E3, 0x7715, 0x7745, 0x7775, 0x77A3,
+    0x77D1, 0x77FE, 0x782A, 0x7855, 0x787F, 0x78A9, 0x78D1, 0x78F9,
+    0x7920, 0x7946, 0x796C, 0x7991, 0x79B5, 0x79D8, 0x79FB, 0x7A1D,
+    0x7A3F, 0x7A5F, 0x7A80, 0x7A9F, 0x7ABE, 0x7ADC, 0x7AFA, 0x7B17,
+    0x7B34, 0x7B50, 0x7B6B, 0x7B86, 0x7BA1, 0x7BBB, 0x7BD4, 0x7BED,
+    0x7C06, 0x7C1D, 0x7C35, 0x7C4C, 0x7C63, 0x7C79, 0x7C8F, 0x7CA4,
+    0x7CB9, 0x7CCD, 0x7CE1, 0x7CF5, 0x7D09, 0x7D1C, 0x7D2E, 0x7D40,
+    0x7D52, 0x7D64, 0x7D75, 0x7D86, 0x7D96, 0x7DA7, 0x7DB7, 0x7DC6,
+    0x7DD5, 0x7DE4, 0x7DF3, 0x7E02, 0x7E10, 0x7E1E, 0x7E2B, 0x7E39,
+    0x7E46, 0x7E53, 0x7E5F, 0x7E6B, 0x7E78, 0x7E83, 0x7E8F, 0x7E9A,
+    0x7EA6, 0x7EB1, 0x7EBB, 0x7EC6, 0x7ED0, 0x7EDA, 0x7EE4, 0x7EEE,
+    0x7EF8, 0x7F01, 0x7F0A, 0x7F13, 0x7F1C, 0x7F25, 0x7F2D, 0x7F36,
+    0x7F3E, 0x7F46, 0x7F4E, 0x7F56, 0x7F5D, 0x7F65, 0x7F6C, 0x7F73,
+    0x7F7A, 0x7F81, 0x7F88, 0x7F8E, 0x7F95, 0x7F9B, 0x7FA1, 0x7FA7,
+    0x7FAD, 0x7FB3, 0x7FB9, 0x7FBF, 0x7FC4, 0x7FCA, 0x7FCF, 0x7FD4,
+    0x7FD9, 0x7FDE, 0x7FE3, 0x7FE8, 0x7FED, 0x7FF2, 0x7FF6, 0x7FFB,
+    0x7FFF,
+};
+
+/** Default envelope configuration, used until a preset is applied */
+static cv_env_cfg_t xEnvDefault[CV_ENV_NUM];
+
+/** Active envelope configuration */
+static cv_env_cfg_t *pxEnvCfg = xEnvDefault;
+
+/** Envelope state */
+static env_state_t xEnv[CV_ENV_NUM];
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Start a new segment from current level.
+ * @param  pxEnv envelope state.
+ * @param  stage new stage.
+ * @param  target segment target level.
+ * @param  time_ms segment time.
+ * @retval None.
+ */
+static void _start_segment(env_state_t *pxEnv, uint8_t stage, uint16_t target, uint16_t time_ms);
+
+/**
+ * @brief  Get sustain level of an envelope.
+ * @param  env envelope index.
+ * @retval sustain level.
+ */
+static uint16_t _sustain_level(uint32_t env);
+
+/* Private application code --------------------------------------------------*/
+
+static void _start_segment(env_state_t *pxEnv, uint8_t stage, uint16_t target, uint16_t time_ms)
+{
+    uint32_t u32Ticks = CV_MS_TO_TICKS((time_ms <= CV_ENV_TIME_MAX_MS) ? time_ms : CV_ENV_TIME_MAX_MS);
+
+    pxEnv->stage = stage;
+    pxEnv->start = (int32_t)pxEnv->level;
+    pxEnv->delta = (int32_t)target - (int32_t)pxEnv->level;
+    pxEnv->pos = 0U;
+
+    /* Only division of a segment, tick path is table lookup and interpolation */
+    pxEnv->rate = (u32Ticks != 0U) ? (ENV_POS_END / u32Ticks) : ENV_POS_END;
+}
+
+static uint16_t _sustain_level(uint32_t env)
+{
+    return (uint16_t)(((uint32_t)xEnv[env].peak * pxEnvCfg[env].sustain) / CV_CODE_MAX);
+}
+
+/* Public application code ---------------------------------------------------*/
+
+void cv_env_init(void)
+{
+    pxEnvCfg = xEnvDefault;
+
+    for (uint32_t i = 0; i < CV_ENV_NUM; i++)
+    {
+        pxEnvCfg[i].out = CV_ENV_OUT_NONE;
+        pxEnvCfg[i].gate = (uint8_t)i;
+        pxEnvCfg[i].velocity = false;
+        pxEnvCfg[i].attack_ms = 5U;
+        pxEnvCfg[i].decay_ms = 200U;
+        pxEnvCfg[i].sustain = CV_CODE_MAX / 2U;
+        pxEnvCfg[i].release_ms = 300U;
+
+        xEnv[i].stage = ENV_IDLE;
+        xEnv[i].level = 0U;
+        xEnv[i].peak = CV_CODE_MAX;
+    }
+}
+
+const cv_env_cfg_t *cv_env_get_cfg(uint8_t env)
+{
+    USER_ASSERT(env < CV_ENV_NUM);
+
+    return &pxEnvCfg[env];
+}
+
+void cv_env_set_cfg(cv_env_cfg_t *cfg)
+{
+    USER_ASSERT(cfg != NULL);
+
+    pxEnvCfg = cfg;
+}
+
+void cv_env_trigger(uint8_t gate, uint8_t velocity)
+{
+    for (uint32_t i = 0; i < CV_ENV_NUM; i++)
+    {
+        if (pxEnvCfg[i].gate == gate)
+        {
+            env_state_t *pxEnv = &xEnv[i];
+
+            /* Velocity sets peak with a 7 to 16 bit expansion */
+            pxEnv->peak = pxEnvCfg[i].velocity ? (uint16_t)(((uint32_t)velocity << 9) | ((uint32_t)velocity << 2) | ((uint32_t)velocity >> 5)) : CV_CODE_MAX;
+
+            /* Retrigger starts from current level, no clicks */
+            _start_segment(pxEnv, ENV_ATTACK, pxEnv->peak, pxEnvCfg[i].attack_ms);
+        }
+    }
+}
+
+void cv_env_tick(uint8_t gates)
+{
+    for (uint32_t i = 0; i < CV_ENV_NUM; i++)
+    {
+        env_state_t *pxEnv = &xEnv[i];
+        const cv_env_cfg_t *pxCfg = &pxEnvCfg[i];
+        bool bGate = (pxCfg->gate < CV_GATE_NUM) && ((gates & (1U << pxCfg->gate)) != 0U);
+
+        if ((pxEnv->stage != ENV_IDLE) && (pxEnv->stage != ENV_RELEASE) && !bGate)
+        {
+            _start_segment(pxEnv, ENV_RELEASE, 0U, pxCfg->release_ms);
+        }
+
+        if ((pxEnv->stage == ENV_ATTACK) || (pxEnv->stage == ENV_DECAY) || (pxEnv->stage == ENV_RELEASE))
+        {
+            pxEnv->pos += pxEnv->rate;
+
+            if (pxEnv->pos >= ENV_POS_END)
+            {
+                /* Segment done, land exactly on target */
+                pxEnv->level = (uint16_t)(pxEnv->start + pxEnv->delta);
+
+                if (pxEnv->stage == ENV_ATTACK)
+                {
+                    _start_segment(pxEnv, ENV_DECAY, _sustain_level(i), pxCfg->decay_ms);
+                }
+                else
+                {
+                    pxEnv->stage = (pxEnv->stage == ENV_DECAY) ? ENV_SUSTAIN : ENV_IDLE;
+                }
+            }
+            else
+            {
+                uint32_t u32Index = pxEnv->pos >> ENV_FRAC_BITS;
+                uint32_t u32Frac = (pxEnv->pos >> (ENV_FRAC_BITS - 8U)) & 0xFFU;
+                int32_t i32Shape = (int32_t)u16EnvLut[u32Index];
+
+                /* Interpolate between table entries, constant cost whatever the segment length */
+                i32Shape += (((int32_t)u16EnvLut[u32Index + 1U] - i32Shape) * (int32_t)u32Frac) >> 8;
+                pxEnv->level = (uint16_t)(pxEnv->start + ((pxEnv->delta * i32Shape) >> ENV_SHAPE_BITS));
+            }
+        }
+        else if (pxEnv->stage == ENV_SUSTAIN)
+        {
+            /* Follow sustain changes */
+            pxEnv->level = _sustain_level(i);
+        }
+        else
+        {
+            /* Idle */
+        }
+    }
+}
+
+bool cv_env_get_code(uint8_t out, uint16_t *code)
+{
+    USER_ASSERT(code != NULL);
+
+    bool bRetval = false;
+
+    /* Last envelope wins when several share an output */
+    for (uint32_t i = 0; i < CV_ENV_NUM; i++)
+    {
+        if (pxEnvCfg[i].out == out)
+        {
+            *code = xEnv[i].level;
+            bRetval = true;
+        }
+    }
+
+    return bRetval;
+}
+
+/* EOF */
@@ -0,0 +1,136 @@
+/**
+ * @file    cv_latency.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   MIDI input to CV output latency histograms.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "cv_latency.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/** Keep compiler from moving memory accesses across the sequence updates */
+#define LATENCY_BARRIER()       __asm volatile ("" ::: "memory")
+
+/* Private variables ---------------------------------------------------------*/
+
+/** Histograms */
+static cv_latency_hist_t xHist[CV_LATENCY_CLASS_NUM];
+
+/** Sequence counter, odd while an update is in progress */
+static volatile uint32_t u32HistSeq = 0U;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private application code --------------------------------------------------*/
+/* Public application code ---------------------------------------------------*/
+
+void cv_latency_reset(void)
+{
+    u32HistSeq++;
+    LATENCY_BARRIER();
+
+    for (uint32_t i = 0; i < CV_LATENCY_CLASS_NUM; i++)
+    {
+        xHist[i].count = 0U;
+        xHist[i].min_us = UINT32_MAX;
+        xHist[i].max_us = 0U;
+
+        for (uint32_t j = 0; j < CV_LATENCY_BUCKETS; j++)
+        {
+            xHist[i].bucket[j] = 0U;
+        }
+    }
+
+    LATENCY_BARRIER();
+    u32HistSeq++;
+}
+
+void cv_latency_add(uint8_t cls, uint32_t latency_us)
+{
+    if (cls < CV_LATENCY_CLASS_NUM)
+    {
+        cv_latency_hist_t *pxHist = &xHist[cls];
+        uint32_t u32Bucket = 0U;
+
+        /* Log2 bucket, shift count keeps it cheap without CLZ on M0+ */
+        for (uint32_t u32Value = latency_us >> 1; (u32Value != 0U) && (u32Bucket < (CV_LATENCY_BUCKETS - 1U)); u32Value >>= 1)
+        {
+            u32Bucket++;
+        }
+
+        u32HistSeq++;
+        LATENCY_BARRIER();
+
+        pxHist->count++;
+        pxHist->bucket[u32Bucket]++;
+        if (latency_us < pxHist->min_us)
+        {
+            pxHist->min_us = latency_us;
+        }
+        if (latency_us > pxHist->max_us)
+        {
+            pxHist->max_us = latency_us;
+        }
+
+        LATENCY_BARRIER();
+        u32HistSeq++;
+    }
+}
+
+void cv_latency_get(uint8_t cls, cv_latency_hist_t *hist)
+{
+    USER_ASSERT(hist != NULL);
+    USER_ASSERT(cls < CV_LATENCY_CLASS_NUM);
+
+    uint32_t u32Seq;
+
+    /* Retry while the writer was in the middle of an update */
+    do
+    {
+        u32Seq = u32HistSeq;
+        LATENCY_BARRIER();
+        *hist = xHist[cls];
+        LATENCY_BARRIER();
+    } while (((u32Seq & 0x01U) != 0U) || (u32Seq != u32HistSeq));
+}
+
+uint32_t cv_latency_percentile(const cv_latency_hist_t *hist, uint32_t percent)
+{
+    USER_ASSERT(hist != NULL);
+
+    uint32_t u32Retval = 0U;
+    uint32_t u32Target = ((hist->count * percent) + 99U) / 100U;
+    uint32_t u32Acc = 0U;
+
+    for (uint32_t i = 0; (i < CV_LATENCY_BUCKETS) && (hist->count != 0U); i++)
+    {
+        u32Acc += hist->bucket[i];
+
+        if (u32Acc >= u32Target)
+        {
+            u32Retval = (2UL << i) - 1U;
+            break;
+        }
+    }
+
+    if (u32Retval > hist->max_us)
+    {
+        u32Retval = hist->max_us;
+    }
+
+    return u32Retval;
+}
+
+/* EOF */
@@ -0,0 +1,337 @@
+/**
+ * @file    cv_lfo.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   LFO bank locked to MIDI clock, computed on the output tick.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "cv_lfo.h"
+#include "cv_clock.h"
+#include "cv_engine.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+
+/** LFO state */
+typedef struct lfo_state
+{
+    uint32_t phase;         /**< Phase, full turn is 2^32 */
+    uint32_t inc;           /**< Phase increment per output tick */
+    uint32_t step;          /**< Phase increment per MIDI clock */
+    uint32_t period;        /**< Clock period used for increment */
+    uint16_t clocks;        /**< Cycle length used for increment */
+    uint16_t count;         /**< MIDI clocks into the cycle */
+    int16_t value;          /**< Bipolar output of last tick */
+} lfo_state_t;
+
+/* Private define ------------------------------------------------------------*/
+
+/* Quarter wave sine table size */
+#define LFO_SINE_BITS           8U
+#define LFO_SINE_SIZE           (1U << LFO_SINE_BITS)
+
+/* Clock period used while no MIDI clock is received, 120 BPM in Q8 us */
+#define LFO_DEFAULT_PERIOD      (20833UL << 8)
+
+/* Full turn phase times Q8 microseconds per second, divided by cycle length
+ * in Q8 microseconds and tick rate gives the increment per tick */
+#define LFO_PHASE_SCALE         ((1ULL << 32) * 256000000ULL)
+
+/* Pitch codes per cent of vibrato at full wave amplitude */
+#define LFO_VIBRATO_DIV         ((32768UL * 100UL) / CV_CODES_PER_SEMITONE)
+
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+
+/** First quarter of sine, 15 bit amplitude. Generated with Tools/curve_gen.py */
+static const uint16_t u16SineLut[LFO_SINE_SIZE] = {
+    0x0065, 0x012E, 0x01F7, 0x02C0, 0x0389, 0x0452, 0x051B, 0x05E3,
+    0x06AC, 0x0775, 0x083E, 0x0906, 0x09CF, 0x0A97, 0x0B5F, 0x0C28,
+    0x0CF0, 0x0DB8, 0x0E80, 0x0F47, 0x100F, 0x10D6, 0x119D, 0x1264,
+    0x132B, 0x13F2, 0x14B9, 0x157F, 0x1645, 0x170B, 0x17D0, 0x1896,
+    0x195B, 0x1A20, 0x1AE5, 0x1BA9, 0x1C6D, 0x1D31, 0x1DF5, 0x1EB8,
+    0x1F7B, 0x203E, 0x2100, 0x21C2, 0x2284, 0x2346, 0x2407, 0x24C8,
+    0x2588, 0x2648, 0x2708, 0x27C7, 0x2886, 0x2944, 0x2A02, 0x2AC0,
+    0x2B7D, 0x2C3A, 0x2CF7, 0x2DB3, 0x2E6E, 0x2F2A, 0x2FE4, 0x309E,
+    0x3158, 0x3211, 0x32CA, 0x3383, 0x343A, 0x34F2, 0x35A8, 0x365F,
+    0x3715, 0x37CA, 0x387E, 0x3933, 0x39E6, 0x3A99, 0x3B4C, 0x3BFE,
+    0x3CAF, 0x3D60, 0x3E10, 0x3EBF, 0x3F6E, 0x401D, 0x40CA, 0x4177,
+    0x4224, 0x42D0, 0x437B, 0x4425, 0x44CF, 0x4578, 0x4621, 0x46C9,
+    0x4770, 0x4816, 0x48BC, 0x4961, 0x4A06, 0x4AA9, 0x4B4C, 0x4BEE,
+    0x4C90, 0x4D31, 0x4DD1, 0x4E70, 0x4F0E, 0x4FAC, 0x5049, 0x50E5,
+    0x5181, 0x521B, 0x52B5, 0x534E, 0x53E7, 0x547E, 0x5515, 0x55AA,
+    0x563F, 0x56D3, 0x5767, 0x57F9, 0x588B, 0x591C, 0x59AC, 0x5A3B,
+    0x5AC9, 0x5B56, 0x5BE2, 0x5C6E, 0x5CF9, 0x5D82, 0x5E0B, 0x5E93,
+    0x5F1A, 0x5FA0, 0x6025, 0x60AA, 0x612D, 0x61AF, 0x6231, 0x62B1,
+    0x6331, 0x63AF, 0x642D, 0x64AA, 0x6525, 0x65A0, 0x661A, 0x6693,
+    0x670A, 0x6781, 0x67F7, 0x686C, 0x68E0, 0x6952, 0x69C4, 0x6A35,
+    0x6AA4, 0x6B13, 0x6B81, 0x6BED, 0x6C59, 0x6CC3, 0x6D2D, 0x6D95,
+    0x6DFD, 0x6E63, 0x6EC8, 0x6F2C, 0x6F90, 0x6FF2, 0x7053, 0x70B2,
+    0x7111, 0x716F, 0x71CB, 0x7227, 0x7281, 0x72DB, 0x7333, 0x738A,
+    0x73E0, 0x7435, 0x7488, 0x74DB, 0x752D, 0x757D, 0x75CC, 0x761A,
+    0x7667, 0x76B3, 0x76FE, 0x7747, 0x778F, 0x77D7, 0x781D, 0x7862,
+    0x78A5, 0x78E8, 0x7929, 0x796A, 0x79A9, 0x79E6, 0x7A23, 0x7A5F,
+    0x7A99, 0x7AD2, 0x7B0A, 0x7B41, 0x7B77, 0x7BAB, 0x7BDE, 0x7C10,
+    0x7C41, 0x7C71, 0x7C9F, 0x7CCD, 0x7CF9, 0x7D24, 0x7D4D, 0x7D76,
+    0x7D9D, 0x7DC3, 0x7DE8, 0x7E0B, 0x7E2E, 0x7E4F, 0x7E6F, 0x7E8D,
+    0x7EAB, 0x7EC7, 0x7EE2, 0x7EFC, 0x7F15, 0x7F2C, 0x7F42, 0x7F57,
+    0x7F6B, 0x7F7D, 0x7F8F, 0x7F9F, 0x7FAD, 0x7FBB, 0x7FC7, 0x7FD2,
+    0x7FDC, 0x7FE5, 0x7FEC, 0x7FF3, 0x7FF7, 0x7FFB, 0x7FFE, 0x7FFF,
+};
+
+/** Default LFO configuration, used until a preset is applied */
+static cv_lfo_cfg_t xLfoDefault[CV_LFO_NUM];
+
+/** Active LFO configuration */
+static cv_lfo_cfg_t *pxLfoCfg = xLfoDefault;
+
+/** LFO state */
+static lfo_state_t xLfo[CV_LFO_NUM];
+
+/** Last song position applied to phases */
+static uint32_t u32LfoPosition = 0U;
+
+/** Sample and hold noise generator */
+static uint32_t u32LfoNoise = 0x12345678UL;
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Update phase increment on tempo or length changes.
+ * @param  lfo LFO index.
+ * @param  period clock period in Q8 microseconds.
+ * @retval None.
+ */
+static void _update_rate(uint32_t lfo, uint32_t period);
+
+/**
+ * @brief  Get bipolar waveform value.
+ * @param  lfo LFO index.
+ * @param  wrapped true if phase wrapped on this tick.
+ * @retval wave value, +-32767.
+ */
+static int16_t _wave(uint32_t lfo, bool wrapped);
+
+/* Private application code --------------------------------------------------*/
+
+static void _update_rate(uint32_t lfo, uint32_t period)
+{
+    lfo_state_t *pxLfo = &xLfo[lfo];
+    uint16_t u16Clocks = pxLfoCfg[lfo].clocks;
+    uint32_t u32Diff = (period > pxLfo->period) ? (period - pxLfo->period) : (pxLfo->period - period);
+
+    /* Divisions only on real changes, clock sync removes any small drift */
+    if ((u32Diff > (pxLfo->period >> 8)) || (pxLfo->clocks != u16Clocks))
+    {
+        pxLfo->period = period;
+        pxLfo->clocks = u16Clocks;
+
+        if ((u16Clocks != 0U) && (u16Clocks <= CV_LFO_CLOCKS_MAX))
+        {
+            pxLfo->inc = (uint32_t)(LFO_PHASE_SCALE / ((uint64_t)u16Clocks * period * CV_ENGINE_TICK_HZ));
+            pxLfo->step = (uint32_t)((1ULL << 32) / u16Clocks);
+        }
+        else
+        {
+            pxLfo->inc = 0U;
+            pxLfo->step = 0U;
+        }
+    }
+}
+
+static int16_t _wave(uint32_t lfo, bool wrapped)
+{
+    uint32_t u32Phase = xLfo[lfo].phase;
+    int32_t i32Value;
+
+    switch (pxLfoCfg[lfo].wave)
+    {
+        case CV_LFO_SINE:
+        {
+            uint32_t u32Index = (u32Phase >> (30U - LFO_SINE_BITS)) & (LFO_SINE_SIZE - 1U);
+
+            /* Odd quadrants run the table backwards, second half is negative */
+            if ((u32Phase & (1UL << 30)) != 0U)
+            {
+                u32Index = (LFO_SINE_SIZE - 1U) - u32Index;
+            }
+            i32Value = (int32_t)u16SineLut[u32Index];
+            if ((u32Phase & (1UL << 31)) != 0U)
+            {
+                i32Value = -i32Value;
+            }
+            break;
+        }
+
+        case CV_LFO_TRIANGLE:
+            /* Rise on first half, fall on second one */
+            i32Value = (int32_t)(u32Phase >> 15);
+            if (i32Value > 0xFFFF)
+            {
+                i32Value = 0x1FFFF - i32Value;
+            }
+            i32Value -= 0x8000;
+            break;
+
+        case CV_LFO_SAW:
+            i32Value = (int32_t)(u32Phase >> 16) - 0x8000;
+            break;
+
+        case CV_LFO_SQUARE:
+            i32Value = ((u32Phase & (1UL << 31)) == 0U) ? 0x7FFF : -0x7FFF;
+            break;
+
+        case CV_LFO_SAMPLE_HOLD:
+            i32Value = xLfo[lfo].value;
+            if (wrapped)
+            {
+                /* Xorshift, new random level each cycle */
+                u32LfoNoise ^= u32LfoNoise << 13;
+                u32LfoNoise ^= u32LfoNoise >> 17;
+                u32LfoNoise ^= u32LfoNoise << 5;
+                i32Value = (int32_t)(u32LfoNoise >> 16) - 0x8000;
+            }
+            break;
+
+        default:
+            i32Value = 0;
+            break;
+    }
+
+    return (int16_t)i32Value;
+}
+
+/* Public application code ---------------------------------------------------*/
+
+void cv_lfo_init(void)
+{
+    pxLfoCfg = xLfoDefault;
+
+    for (uint32_t i = 0; i < CV_LFO_NUM; i++)
+    {
+        pxLfoCfg[i].wave = CV_LFO_SINE;
+        pxLfoCfg[i].out = CV_LFO_OUT_NONE;
+        pxLfoCfg[i].clocks = 24U;
+        pxLfoCfg[i].depth = 0U;
+
+        xLfo[i].phase = 0U;
+        xLfo[i].period = 0U;
+        xLfo[i].clocks = 0U;
+        xLfo[i].count = 0U;
+        xLfo[i].value = 0;
+        _update_rate(i, LFO_DEFAULT_PERIOD);
+    }
+
+    u32LfoPosition = 0U;
+}
+
+const cv_lfo_cfg_t *cv_lfo_get_cfg(uint8_t lfo)
+{
+    USER_ASSERT(lfo < CV_LFO_NUM);
+
+    return &pxLfoCfg[lfo];
+}
+
+void cv_lfo_set_cfg(cv_lfo_cfg_t *cfg)
+{
+    USER_ASSERT(cfg != NULL);
+
+    pxLfoCfg = cfg;
+}
+
+void cv_lfo_tick(void)
+{
+    uint32_t u32Period = cv_clock_get_period();
+    uint32_t u32Position = cv_clock_get_position();
+    bool bSync = false;
+
+    if (u32Period == 0U)
+    {
+        u32Period = LFO_DEFAULT_PERIOD;
+    }
+
+    /* New MIDI clock, phases are realigned to song position */
+    if (u32Position != u32LfoPosition)
+    {
+        u32LfoPosition = u32Position;
+        bSync = (u32Position != 0U) && cv_clock_is_running();
+    }
+
+    for (uint32_t i = 0; i < CV_LFO_NUM; i++)
+    {
+        lfo_state_t *pxLfo = &xLfo[i];
+        uint32_t u32Last = pxLfo->phase;
+        bool bWrapped;
+
+        _update_rate(i, u32Period);
+
+        if (bSync)
+        {
+            /* First clock after start is the cycle start */
+            pxLfo->count++;
+            if ((u32Position == 1U) || (pxLfo->count >= pxLfo->clocks))
+            {
+                pxLfo->count = 0U;
+            }
+            pxLfo->phase = pxLfo->count * pxLfo->step;
+
+            /* Free run may have crossed the cycle start already */
+            bWrapped = (pxLfo->count == 0U) && (u32Last >= pxLfo->step);
+        }
+        else
+        {
+            pxLfo->phase += pxLfo->inc;
+            bWrapped = (pxLfo->phase < u32Last);
+        }
+
+        pxLfo->value = _wave(i, bWrapped);
+    }
+}
+
+bool cv_lfo_get_code(uint8_t out, uint16_t *code)
+{
+    USER_ASSERT(code != NULL);
+
+    bool bRetval = false;
+
+    /* Last LFO wins when several share an output */
+    for (uint32_t i = 0; i < CV_LFO_NUM; i++)
+    {
+        if (pxLfoCfg[i].out == out)
+        {
+            uint32_t u32Unipolar = (uint32_t)((int32_t)xLfo[i].value + 0x8000);
+
+            *code = (uint16_t)((u32Unipolar * pxLfoCfg[i].depth) >> 16);
+            bRetval = true;
+        }
+    }
+
+    return bRetval;
+}
+
+int32_t cv_lfo_get_pitch(void)
+{
+    int32_t i32Pitch = 0;
+
+    for (uint32_t i = 0; i < CV_LFO_NUM; i++)
+    {
+        if (pxLfoCfg[i].out == CV_LFO_OUT_PITCH)
+        {
+            i32Pitch += ((int32_t)xLfo[i].value * (int32_t)pxLfoCfg[i].depth) / (int32_t)LFO_VIBRATO_DIV;
+        }
+    }
+
+    return i32Pitch;
+}
+
+/* EOF */
@@ -0,0 +1,414 @@
+/**
+ * @file    cv_loop.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Body of the CV task, MIDI input to output frames, free of RTOS
+ *          calls so the simulator runs the same code on a virtual clock.
+ *
+ *          Frames are double buffered: the task fills the back one while the
+ *          output tick latches the published one.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "cv_loop.h"
+#include "cv_cal.h"
+#include "cv_clock.h"
+#include "cv_latency.h"
+#include "cv_param.h"
+#include "cv_preset.h"
+#include "midi_lib.h"
+#include "sys_cv.h"
+#ifdef USE_USER_RTOS
+#include "sys_rtos.h"
+#endif
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+
+/* Bytes read from serial on each access */
+#define LOOP_MIDI_READ_SIZE     16U
+
+/* Time of a MIDI byte on the wire, 10 bits at 31250 baud */
+#define LOOP_MIDI_BYTE_US       320U
+
+/* Messages waiting for their output frame to be latched */
+#define LOOP_LATENCY_STAMPS     16U
+
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Interrupts share the clock gate state, the simulator has none */
+#ifdef USE_USER_RTOS
+#define LOOP_ENTER_CRITICAL()   taskENTER_CRITICAL()
+#define LOOP_EXIT_CRITICAL()    taskEXIT_CRITICAL()
+#else
+#define LOOP_ENTER_CRITICAL()
+#define LOOP_EXIT_CRITICAL()
+#endif
+
+/* Keep compiler from moving frame accesses across the sequence reads */
+#define LOOP_BARRIER()          __asm volatile ("" ::: "memory")
+
+/* Private variables ---------------------------------------------------------*/
+
+/* Time source */
+static cv_loop_time_cb pxGetTime = NULL;
+
+/* Output ticks generated by timer and processed by task */
+static volatile uint32_t u32TickCount = 0U;
+static uint32_t u32TickDone = 0U;
+
+/* Output frames. Index of the published frame is the sequence LSB */
+static cv_frame_t xFrameBuf[2];
+static volatile uint32_t u32FrameSeq = 0U;
+static uint32_t u32FrameLatched = 0U;
+
+/* Gates on the outputs */
+static uint8_t u8GatesOut = 0U;
+
+/* Gate of the clock output, raised by the compare interrupt on the pulse time
+ * and forced until the task publishes a frame holding the pulse */
+static volatile uint8_t u8ClockGate = 0U;
+static volatile uint8_t u8ClockForce = 0U;
+
+/* Time the last published frame was latched on the outputs */
+static volatile uint32_t u32LatchUs = 0U;
+
+/* Reception time, class and frame to wait for of messages not yet latched */
+static uint32_t u32StampUs[LOOP_LATENCY_STAMPS];
+static uint32_t u32StampSeq[LOOP_LATENCY_STAMPS];
+static uint8_t u8StampClass[LOOP_LATENCY_STAMPS];
+static uint8_t u8StampNum = 0U;
+
+static midi_parser_t xMidiParser;
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Read all pending MIDI data and apply it to the engine.
+ * @retval None.
+ */
+static void _process_midi(void);
+
+/**
+ * @brief  Check for a program change on the channel of the active mode.
+ * @param  msg MIDI message.
+ * @retval true if message selects a preset.
+ */
+static bool _is_program(midi_msg_t msg);
+
+/**
+ * @brief  Program compare timer for the next interpolated clock pulse.
+ * @retval None.
+ */
+static void _schedule_clock(void);
+
+/**
+ * @brief  Publish a complete output frame to be latched on next tick.
+ * @param  frame output frame.
+ * @retval None.
+ */
+static void _publish_frame(const cv_frame_t *frame);
+
+/**
+ * @brief  Keep reception time of a message to measure its latency.
+ * @param  msg MIDI message that changed the outputs.
+ * @param  time_us reception time of the message last byte.
+ * @retval None.
+ */
+static void _latency_stamp(midi_msg_t msg, uint32_t time_us);
+
+/**
+ * @brief  Add latency of stamped messages once their frame is latched.
+ * @retval None.
+ */
+static void _latency_flush(void);
+
+/* Private application code --------------------------------------------------*/
+
+static void _process_midi(void)
+{
+    uint8_t u8RxData[LOOP_MIDI_READ_SIZE];
+    uint16_t u16Len;
+    midi_msg_t xMsg;
+    uint32_t u32RxTime = SYS_SERIAL_GetRxTime(CV_LOOP_SERIAL);
+    uint32_t u32Pending = SYS_SERIAL_GetReadCount(CV_LOOP_SERIAL);
+
+    /* Every message pending is applied before the outputs are updated */
+    while ((u16Len = SYS_SERIAL_Read(CV_LOOP_SERIAL, u8RxData, LOOP_MIDI_READ_SIZE)) != 0U)
+    {
+        for (uint16_t i = 0; i < u16Len; i++)
+        {
+            /* Bytes before the last one arrived a byte time earlier each */
+            u32Pending = (u32Pending != 0U) ? (u32Pending - 1U) : 0U;
+
+            if (midi_parser_put(&xMidiParser, u8RxData[i], &xMsg))
+            {
+                uint32_t u32ByteTime = u32RxTime - (u32Pending * LOOP_MIDI_BYTE_US);
+                bool bOutput = false;
+
+                if (MIDI_IS_REALTIME(MIDI_MSG_STATUS(xMsg)))
+                {
+                    bOutput = cv_clock_midi(MIDI_MSG_STATUS(xMsg), u32ByteTime);
+                }
+                else if (_is_program(xMsg))
+                {
+                    /* Following messages already use the new preset */
+                    if (cv_preset_load(MIDI_MSG_DATA1(xMsg)))
+                    {
+                        cv_preset_apply();
+                        bOutput = true;
+                    }
+                }
+                else
+                {
+                    bOutput = cv_engine_midi(xMsg);
+                }
+
+                /* Active sensing, other channels and unmapped controllers
+                 * would pull the figures down */
+                if (bOutput)
+                {
+                    _latency_stamp(xMsg, u32ByteTime);
+                }
+            }
+        }
+    }
+}
+
+static bool _is_program(midi_msg_t msg)
+{
+    uint8_t u8Param = (cv_param_get(CV_PARAM_MODE) == CV_MODE_GATE) ? CV_PARAM_GATE_CHANNEL : CV_PARAM_CHANNEL;
+    uint8_t u8Channel = (uint8_t)cv_param_get(u8Param);
+
+    return (MIDI_MSG_TYPE(msg) == MIDI_PROGRAM_CHANGE) && (MIDI_MSG_CHANNEL(msg) == u8Channel);
+}
+
+static void _publish_frame(const cv_frame_t *frame)
+{
+    uint32_t u32Seq = u32FrameSeq + 1U;
+
+    /* Fill back buffer, then a single store makes it visible */
+    xFrameBuf[u32Seq & 0x01U] = *frame;
+    u32FrameSeq = u32Seq;
+
+    /* Clock pulse raised by the compare interrupt is held by the frame now */
+    LOOP_ENTER_CRITICAL();
+    u8ClockForce &= (uint8_t)~frame->gates;
+    LOOP_EXIT_CRITICAL();
+}
+
+static void _latency_stamp(midi_msg_t msg, uint32_t time_us)
+{
+    uint8_t u8Type = MIDI_MSG_TYPE(msg);
+    uint8_t u8Class = CV_LATENCY_CTRL;
+
+    if (MIDI_IS_REALTIME(MIDI_MSG_STATUS(msg)))
+    {
+        u8Class = CV_LATENCY_CLOCK;
+    }
+    else if ((u8Type == MIDI_NOTE_ON) || (u8Type == MIDI_NOTE_OFF))
+    {
+        u8Class = CV_LATENCY_NOTE;
+    }
+    else
+    {
+        /* Controllers, pressure, bend and program change */
+    }
+
+    /* Messages beyond the list are not measured. Each one is measured
+       against the next published frame */
+    if (u8StampNum < LOOP_LATENCY_STAMPS)
+    {
+        u32StampUs[u8StampNum] = time_us;
+        u32StampSeq[u8StampNum] = u32FrameSeq + 1U;
+        u8StampClass[u8StampNum] = u8Class;
+        u8StampNum++;
+    }
+}
+
+static void _latency_flush(void)
+{
+    uint32_t u32Latched;
+    uint32_t u32Time;
+
+    /* Tick may latch between both reads, retry until consistent */
+    do
+    {
+        u32Latched = u32FrameLatched;
+        u32Time = u32LatchUs;
+    } while (u32Latched != u32FrameLatched);
+
+    /* Stamps are in frame order, latched ones go and the rest move down */
+    uint8_t u8Keep = 0U;
+
+    for (uint8_t i = 0; i < u8StampNum; i++)
+    {
+        if ((int32_t)(u32Latched - u32StampSeq[i]) >= 0)
+        {
+            cv_latency_add(u8StampClass[i], u32Time - u32StampUs[i]);
+        }
+        else
+        {
+            u32StampUs[u8Keep] = u32StampUs[i];
+            u32StampSeq[u8Keep] = u32StampSeq[i];
+            u8StampClass[u8Keep] = u8StampClass[i];
+            u8Keep++;
+        }
+    }
+
+    u8StampNum = u8Keep;
+}
+
+static void _schedule_clock(void)
+{
+    uint32_t u32Delay;
+
+    if (cv_clock_get_event(pxGetTime(), &u32Delay))
+    {
+        uint8_t u8Out = cv_clock_get_cfg()->clock_out;
+
+        u8ClockGate = (u8Out < CV_GATE_NUM) ? (uint8_t)(1U << u8Out) : 0U;
+        SYS_CV_CompareStart(u32Delay);
+    }
+    else
+    {
+        SYS_CV_CompareStop();
+    }
+}
+
+/* Public application code ---------------------------------------------------*/
+
+void cv_loop_init(cv_loop_time_cb time_cb)
+{
+    USER_ASSERT(time_cb != NULL);
+
+    pxGetTime = time_cb;
+
+    /* Calibration is used in place from flash */
+    (void)cv_cal_init();
+    cv_engine_init();
+    cv_preset_init();
+    cv_latency_reset();
+    midi_parser_init(&xMidiParser);
+}
+
+void cv_loop_start(void)
+{
+    cv_frame_t xFrame;
+
+    /* The tick keeps the outputs from here on */
+    cv_engine_get_frame(&xFrame);
+    _publish_frame(&xFrame);
+    SYS_CV_WriteAnalog(xFrame.analog);
+    SYS_CV_WriteGates(xFrame.gates);
+    u8GatesOut = xFrame.gates;
+    u32FrameLatched = u32FrameSeq;
+}
+
+void cv_loop_run(uint32_t events)
+{
+    cv_frame_t xFrame;
+
+    /* Messages of the last published frame are on the outputs */
+    _latency_flush();
+
+    if ((events & CV_LOOP_EVENT_RX) != 0U)
+    {
+        _process_midi();
+    }
+
+    if ((events & CV_LOOP_EVENT_ERROR) != 0U)
+    {
+        /* Drop partial message, line errors or lost bytes */
+        midi_parser_init(&xMidiParser);
+        _process_midi();
+    }
+
+    if ((events & CV_LOOP_EVENT_CLOCK) != 0U)
+    {
+        /* Edge raised from an old schedule is dropped on next latch */
+        if (!cv_clock_event(pxGetTime()))
+        {
+            LOOP_ENTER_CRITICAL();
+            u8ClockForce = 0U;
+            LOOP_EXIT_CRITICAL();
+        }
+    }
+
+    /* Preset requested by other tasks */
+    cv_preset_apply();
+
+    /* Catch up ticks elapsed while busy */
+    while (u32TickDone != u32TickCount)
+    {
+        cv_engine_tick();
+        u32TickDone++;
+    }
+
+    /* Single output update for all changes, latched on next tick */
+    cv_engine_get_frame(&xFrame);
+    _publish_frame(&xFrame);
+
+    _schedule_clock();
+}
+
+void cv_loop_latch(void)
+{
+    uint32_t u32Seq = u32FrameSeq;
+
+    /* Latch last published frame, the task never writes this buffer and
+     * cannot run in the middle of the interrupt, no lock is needed */
+    if (u32Seq != u32FrameLatched)
+    {
+        const cv_frame_t *pxFrame = &xFrameBuf[u32Seq & 0x01U];
+
+        u8GatesOut = pxFrame->gates | u8ClockForce;
+        SYS_CV_WriteAnalog(pxFrame->analog);
+        SYS_CV_WriteGates(u8GatesOut);
+        u32LatchUs = pxGetTime();
+        u32FrameLatched = u32Seq;
+    }
+
+    u32TickCount++;
+}
+
+void cv_loop_clock_edge(void)
+{
+    uint8_t u8Gate = u8ClockGate;
+
+    /* Pulse edge goes out now instead of on the next output tick, the task
+     * times its length */
+    if (u8Gate != 0U)
+    {
+        u8ClockForce = u8Gate;
+        u8GatesOut |= u8Gate;
+        SYS_CV_WriteGates(u8GatesOut);
+    }
+}
+
+void cv_loop_get_frame(cv_frame_t *frame)
+{
+    uint32_t u32Seq;
+
+    USER_ASSERT(frame != NULL);
+
+    /* The task writes the other buffer first, copy is only torn if it
+     * publishes twice meanwhile */
+    do
+    {
+        u32Seq = u32FrameSeq;
+        LOOP_BARRIER();
+        *frame = xFrameBuf[u32Seq & 0x01U];
+        LOOP_BARRIER();
+    } while ((u32FrameSeq - u32Seq) >= 2U);
+}
+
+/* EOF */
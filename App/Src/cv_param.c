@@ -0,0 +1,373 @@
+/**
+ * @file    cv_param.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Registry of engine parameters. Typed, range checked values
+ *          addressed by id, published to the engine with a sequence counter.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "cv_param.h"
+#include "cv_engine.h"
+#include "cv_curve.h"
+#ifdef USE_USER_RTOS
+#include "sys_rtos.h"
+#endif
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+
+/* Default MIDI channels, gate mode on the GM drum channel */
+#define PARAM_CHANNEL_DEF       0U
+#define PARAM_GATE_CHANNEL_DEF  9U
+
+/* Digits of the largest number parsed, values are 16 bit */
+#define PARAM_DIGITS_MAX        5U
+
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/** Keep compiler from moving memory accesses across the sequence updates */
+#define PARAM_BARRIER()         __asm volatile ("" ::: "memory")
+
+/** Description entry */
+#define PARAM_DESC(NAME, NAMES, TYPE, FIELD, MIN, MAX, DEF) \
+    {(NAME), (NAMES), (TYPE), (uint8_t)offsetof(cv_param_values_t, FIELD), (MIN), (MAX), (DEF)}
+
+/* Private variables ---------------------------------------------------------*/
+
+/** Mode names, cv_mode_t order */
+static const char * const pcModeNames[CV_MODE_NUM] = {
+    "mono", "dual", "quad", "gate"
+};
+
+/** Response curve names, cv_curve_t order */
+static const char * const pcCurveNames[CV_CURVE_NUM] = {
+    "lin", "exp", "log", "user"
+};
+
+/** Parameter descriptions, cv_param_id_t order */
+static const cv_param_desc_t xParamDesc[CV_PARAM_NUM] = {
+    PARAM_DESC("mode", pcModeNames, CV_PARAM_U8, mode, 0U, CV_MODE_NUM - 1U, CV_MODE_MONO),
+    PARAM_DESC("channel", NULL, CV_PARAM_U8, channel, 0U, MIDI_CHANNEL_NUM - 1U, PARAM_CHANNEL_DEF),
+    PARAM_DESC("gchannel", NULL, CV_PARAM_U8, gate_channel, 0U, MIDI_CHANNEL_NUM - 1U, PARAM_GATE_CHANNEL_DEF),
+    PARAM_DESC("glide", NULL, CV_PARAM_U16, glide_ms, 0U, CV_PARAM_GLIDE_MAX_MS, 0U),
+    PARAM_DESC("gcurve", pcCurveNames, CV_PARAM_U8, glide_curve, 0U, CV_CURVE_NUM - 1U, CV_CURVE_LINEAR),
+};
+
+/** Published values */
+static cv_param_values_t xParam;
+
+/** Sequence counter, odd while a write is in progress */
+static volatile uint32_t u32ParamSeq = 0U;
+
+/** Nested writes open */
+static uint32_t u32WriteDepth = 0U;
+
+#ifdef USE_USER_RTOS
+/** Writers are the CLI task and the cv task applying presets, the engine
+    reads without locking */
+static SemaphoreHandle_t xParamMutex = NULL;
+static StaticSemaphore_t xParamMutexBuf;
+#endif
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Take writer lock, nested calls from the same task are allowed.
+ * @retval None.
+ */
+static void _write_lock(void);
+
+/**
+ * @brief  Release writer lock.
+ * @retval None.
+ */
+static void _write_unlock(void);
+
+/**
+ * @brief  Get a field of a values block.
+ * @param  values values block.
+ * @param  id parameter, valid cv_param_id_t.
+ * @retval field value.
+ */
+static int32_t _get_field(const cv_param_values_t *values, uint8_t id);
+
+/**
+ * @brief  Set a field of a values block, range is not checked.
+ * @param  values values block.
+ * @param  id parameter, valid cv_param_id_t.
+ * @param  value new value.
+ * @retval None.
+ */
+static void _set_field(cv_param_values_t *values, uint8_t id, int32_t value);
+
+/* Private application code --------------------------------------------------*/
+
+static void _write_lock(void)
+{
+#ifdef USE_USER_RTOS
+    /* Boot has a single writer and no scheduler to block on */
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+    {
+        (void)xSemaphoreTakeRecursive(xParamMutex, portMAX_DELAY);
+    }
+#endif
+}
+
+static void _write_unlock(void)
+{
+#ifdef USE_USER_RTOS
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+    {
+        (void)xSemaphoreGiveRecursive(xParamMutex);
+    }
+#endif
+}
+
+static int32_t _get_field(const cv_param_values_t *values, uint8_t id)
+{
+    int32_t i32Value;
+    const uint8_t *pu8Field = (const uint8_t *)values + xParamDesc[id].offset;
+
+    if (xParamDesc[id].type == CV_PARAM_U16)
+    {
+        i32Value = *(const uint16_t *)pu8Field;
+    }
+    else
+    {
+        i32Value = *pu8Field;
+    }
+
+    return i32Value;
+}
+
+static void _set_field(cv_param_values_t *values, uint8_t id, int32_t value)
+{
+    uint8_t *pu8Field = (uint8_t *)values + xParamDesc[id].offset;
+
+    if (xParamDesc[id].type == CV_PARAM_U16)
+    {
+        *(uint16_t *)pu8Field = (uint16_t)value;
+    }
+    else
+    {
+        *pu8Field = (uint8_t)value;
+    }
+}
+
+/* Public application code ---------------------------------------------------*/
+
+void cv_param_init(void)
+{
+#ifdef USE_USER_RTOS
+    if (xParamMutex == NULL)
+    {
+        xParamMutex = xSemaphoreCreateRecursiveMutexStatic(&xParamMutexBuf);
+        USER_ASSERT(xParamMutex != NULL);
+    }
+#endif
+
+    cv_param_begin();
+
+    for (uint8_t i = 0; i < CV_PARAM_NUM; i++)
+    {
+        (void)cv_param_set(i, xParamDesc[i].def);
+    }
+
+    cv_param_end();
+}
+
+const cv_param_desc_t *cv_param_get_desc(uint8_t id)
+{
+    return (id < CV_PARAM_NUM) ? &xParamDesc[id] : NULL;
+}
+
+bool cv_param_find(const char *name, size_t len, uint8_t *id)
+{
+    USER_ASSERT(name != NULL);
+    USER_ASSERT(id != NULL);
+
+    bool bRetval = false;
+
+    for (uint8_t i = 0; (i < CV_PARAM_NUM) && !bRetval; i++)
+    {
+        if ((strlen(xParamDesc[i].name) == len) && (strncmp(name, xParamDesc[i].name, len) == 0))
+        {
+            *id = i;
+            bRetval = true;
+        }
+    }
+
+    return bRetval;
+}
+
+bool cv_param_parse(uint8_t id, const char *text, size_t len, int32_t *value)
+{
+    USER_ASSERT(text != NULL);
+    USER_ASSERT(value != NULL);
+
+    bool bRetval = false;
+    const cv_param_desc_t *pxDesc = cv_param_get_desc(id);
+
+    if ((pxDesc != NULL) && (pxDesc->names != NULL))
+    {
+        for (uint32_t i = pxDesc->min; (i <= pxDesc->max) && !bRetval; i++)
+        {
+            if ((strlen(pxDesc->names[i]) == len) && (strncmp(text, pxDesc->names[i], len) == 0))
+            {
+                *value = (int32_t)i;
+                bRetval = true;
+            }
+        }
+    }
+    else if ((pxDesc != NULL) && (len != 0U) && (len <= PARAM_DIGITS_MAX))
+    {
+        int32_t i32Value = 0;
+
+        bRetval = true;
+        for (size_t i = 0; (i < len) && bRetval; i++)
+        {
+            bRetval = (text[i] >= '0') && (text[i] <= '9');
+            i32Value = (i32Value * 10) + (text[i] - '0');
+        }
+
+        *value = i32Value;
+    }
+    else
+    {
+        /* Unknown parameter or empty value */
+    }
+
+    return bRetval;
+}
+
+int32_t cv_param_get(uint8_t id)
+{
+    USER_ASSERT(id < CV_PARAM_NUM);
+
+    int32_t i32Value = 0;
+
+    if (id < CV_PARAM_NUM)
+    {
+        i32Value = _get_field(&xParam, id);
+    }
+
+    return i32Value;
+}
+
+bool cv_param_set(uint8_t id, int32_t value)
+{
+    bool bRetval = false;
+
+    if ((id < CV_PARAM_NUM) && (value >= xParamDesc[id].min) && (value <= xParamDesc[id].max))
+    {
+        cv_param_begin();
+        _set_field(&xParam, id, value);
+        cv_param_end();
+
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+void cv_param_get_values(cv_param_values_t *values)
+{
+    USER_ASSERT(values != NULL);
+
+    /* Writers may run on another task, values is taken whole */
+    _write_lock();
+    *values = xParam;
+    _write_unlock();
+}
+
+void cv_param_check_values(cv_param_values_t *values)
+{
+    USER_ASSERT(values != NULL);
+
+    for (uint8_t i = 0; i < CV_PARAM_NUM; i++)
+    {
+        int32_t i32Value = _get_field(values, i);
+
+        if ((i32Value < xParamDesc[i].min) || (i32Value > xParamDesc[i].max))
+        {
+            _set_field(values, i, xParamDesc[i].def);
+        }
+    }
+}
+
+void cv_param_set_values(const cv_param_values_t *values)
+{
+    USER_ASSERT(values != NULL);
+
+    cv_param_values_t xValues = *values;
+
+    cv_param_check_values(&xValues);
+
+    cv_param_begin();
+    xParam = xValues;
+    cv_param_end();
+}
+
+void cv_param_begin(void)
+{
+    _write_lock();
+
+    if (u32WriteDepth++ == 0U)
+    {
+        u32ParamSeq++;
+        PARAM_BARRIER();
+    }
+}
+
+void cv_param_end(void)
+{
+    USER_ASSERT(u32WriteDepth != 0U);
+
+    if (--u32WriteDepth == 0U)
+    {
+        PARAM_BARRIER();
+        u32ParamSeq++;
+    }
+
+    _write_unlock();
+}
+
+bool cv_param_read(cv_param_values_t *values, uint32_t *seq)
+{
+    USER_ASSERT(values != NULL);
+    USER_ASSERT(seq != NULL);
+
+    bool bRetval = false;
+    uint32_t u32Seq = u32ParamSeq;
+
+    /* Nothing new or a write in progress, the engine may not wait for it */
+    if ((u32Seq != *seq) && ((u32Seq & 0x01U) == 0U))
+    {
+        cv_param_values_t xCopy;
+
+        PARAM_BARRIER();
+        xCopy = xParam;
+        PARAM_BARRIER();
+
+        if (u32Seq == u32ParamSeq)
+        {
+            *values = xCopy;
+            *seq = u32Seq;
+            bRetval = true;
+        }
+    }
+
+    return bRetval;
+}
+
+/* EOF */
@@ -0,0 +1,347 @@
+/**
+ * @file    cv_preset.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Presets of mode, routing, curves, glide and MIDI channels kept on the
+ *          flash key value store.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
+#include "cv_preset.h"
+#include "cv_curve.h"
+#include "cv_param.h"
+#include "cv_store.h"
+
+/* Private typedef -----------------------------------------------------------*/
+
+/** Preset compiled to the form used by the engine, applied by pointer */
+typedef struct cv_preset_image
+{
+    cv_param_values_t param;                /**< Mode, MIDI channels and glide */
+    cv_engine_cfg_t engine;                 /**< Gate routing */
+    cv_clock_cfg_t clock;                   /**< Clock outputs */
+    cv_ctrl_map_t ctrl;                     /**< Controller routing with its tables */
+    cv_lfo_cfg_t lfo[CV_LFO_NUM];           /**< LFOs */
+    cv_env_cfg_t env[CV_ENV_NUM];           /**< Envelopes */
+} cv_preset_image_t;
+
+/* Private define ------------------------------------------------------------*/
+
+/* Store keys, one per preset and the user curve shared by all of them */
+#define PRESET_KEY(n)           ((uint16_t)(n))
+#define PRESET_KEY_CURVE        ((uint16_t)CV_PRESET_NUM)
+
+/* Size of user curve table */
+#define PRESET_CURVE_LEN        ((uint16_t)(CV_CURVE_SIZE * sizeof(uint16_t)))
+
+/* No preset change pending */
+#define PRESET_NONE             0xFFU
+
+/* Stored with one cv_store_set call */
+_Static_assert(sizeof(cv_preset_t) <= CV_STORE_VALUE_MAX,
+               "cv_preset_t does not fit on a store value");
+
+/* Private macro -------------------------------------------------------------*/
+
+/* Keep image writes ahead of the swap request */
+#define PRESET_BARRIER()        __asm volatile ("" ::: "memory")
+
+/* Private variables ---------------------------------------------------------*/
+
+/** Preset being saved or compiled, too large for the caller stack */
+static cv_preset_t xPresetBuf;
+
+/** Compiled presets and one spare */
+static cv_preset_image_t xImageBuf[CV_PRESET_NUM + 1U];
+
+/** Image of each preset, swapped by the engine task only */
+static cv_preset_image_t *pxImage[CV_PRESET_NUM];
+
+/** Image free to compile into, owned by the other task until swapped */
+static cv_preset_image_t *pxSpare = &xImageBuf[CV_PRESET_NUM];
+
+/** Active preset and preset requested for next output frame */
+static uint8_t u8Active = 0U;
+static volatile uint8_t u8Pending = PRESET_NONE;
+
+/** Preset whose image is replaced by the spare on next output frame */
+static volatile uint8_t u8Swap = PRESET_NONE;
+
+/** Preset being edited, active one when the edit started */
+static uint8_t u8Edit = 0U;
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Copy active configuration to a preset.
+ * @param  preset where to store configuration.
+ * @retval None.
+ */
+static void _snapshot(cv_preset_t *preset);
+
+/**
+ * @brief  Compile a preset, invalid fields are replaced by safe values.
+ * @param  image where to store compiled preset.
+ * @param  preset preset contents.
+ * @retval None.
+ */
+static void _compile(cv_preset_image_t *image, const cv_preset_t *preset);
+
+/**
+ * @brief  Switch all modules to a compiled preset.
+ * @param  preset preset number.
+ * @retval None.
+ */
+static void _use_image(uint8_t preset);
+
+/* Private application code --------------------------------------------------*/
+
+static void _snapshot(cv_preset_t *preset)
+{
+    cv_param_get_values(&preset->param);
+    preset->engine = *cv_engine_get_cfg();
+    preset->clock = *cv_clock_get_cfg();
+    for (uint8_t i = 0; i < CV_ANALOG_NUM; i++)
+    {
+        preset->ctrl[i] = *cv_ctrl_get_output(i);
+    }
+    for (uint8_t i = 0; i < CV_LFO_NUM; i++)
+    {
+        preset->lfo[i] = *cv_lfo_get_cfg(i);
+    }
+    for (uint8_t i = 0; i < CV_ENV_NUM; i++)
+    {
+        preset->env[i] = *cv_env_get_cfg(i);
+    }
+}
+
+static void _compile(cv_preset_image_t *image, const cv_preset_t *preset)
+{
+    image->param = preset->param;
+    cv_param_check_values(&image->param);
+
+    image->engine = preset->engine;
+    for (uint32_t i = 0; i < CV_GATE_NUM; i++)
+    {
+        if (image->engine.gate[i].type >= CV_GATE_TYPE_NUM)
+        {
+            image->engine.gate[i].type = CV_GATE_TRIGGER;
+        }
+    }
+
+    image->clock = preset->clock;
+    if (image->clock.div == 0U)
+    {
+        image->clock.div = 1U;
+    }
+    else if (image->clock.div > CV_CLOCK_DIV_MAX)
+    {
+        image->clock.div = CV_CLOCK_DIV_MAX;
+    }
+    else
+    {
+        /* In range */
+    }
+    if (image->clock.mul == 0U)
+    {
+        image->clock.mul = 1U;
+    }
+    else if (image->clock.mul > CV_CLOCK_MUL_MAX)
+    {
+        image->clock.mul = CV_CLOCK_MUL_MAX;
+    }
+    else
+    {
+        /* In range */
+    }
+
+    /* Invalid mappings are left unmapped */
+    cv_ctrl_map_init(&image->ctrl);
+    for (uint8_t i = 0; i < CV_ANALOG_NUM; i++)
+    {
+        (void)cv_ctrl_map_set(&image->ctrl, i, &preset->ctrl[i]);
+    }
+    cv_ctrl_map_build(&image->ctrl);
+
+    for (uint32_t i = 0; i < CV_LFO_NUM; i++)
+    {
+        image->lfo[i] = preset->lfo[i];
+    }
+    for (uint32_t i = 0; i < CV_ENV_NUM; i++)
+    {
+        image->env[i] = preset->env[i];
+    }
+}
+
+static void _use_image(uint8_t preset)
+{
+    cv_preset_image_t *pxNew = pxImage[preset];
+
+    /* Engine goes last, notes moved to new voices trigger new envelopes */
+    cv_lfo_set_cfg(pxNew->lfo);
+    cv_env_set_cfg(pxNew->env);
+    cv_ctrl_set_map(&pxNew->ctrl);
+    cv_clock_set_cfg(&pxNew->clock);
+
+    /* Live parameters stay with the preset they were set on */
+    cv_param_get_values(&pxImage[u8Active]->param);
+    cv_param_set_values(&pxNew->param);
+    cv_engine_set_cfg(&pxNew->engine);
+
+    u8Active = preset;
+}
+
+/* Public application code ---------------------------------------------------*/
+
+void cv_preset_init(void)
+{
+    uint16_t u16Len = 0U;
+    const uint16_t *pu16Curve;
+
+    (void)cv_store_init();
+
+    pu16Curve = (const uint16_t *)cv_store_get(PRESET_KEY_CURVE, &u16Len);
+    if ((pu16Curve != NULL) && (u16Len == PRESET_CURVE_LEN))
+    {
+        cv_curve_load_user(pu16Curve);
+    }
+
+    /* Presets not stored start from the default configuration */
+    _snapshot(&xPresetBuf);
+
+    for (uint8_t i = 0; i < CV_PRESET_NUM; i++)
+    {
+        const cv_preset_t *pxPreset = (const cv_preset_t *)cv_store_get(PRESET_KEY(i), &u16Len);
+
+        pxImage[i] = &xImageBuf[i];
+
+        /* Presets stored by a firmware with a different layout are ignored */
+        if ((pxPreset != NULL) && (u16Len == sizeof(cv_preset_t)))
+        {
+            _compile(pxImage[i], pxPreset);
+        }
+        else
+        {
+            _compile(pxImage[i], &xPresetBuf);
+        }
+    }
+    pxSpare = &xImageBuf[CV_PRESET_NUM];
+
+    /* First preset parameters become the live ones */
+    u8Pending = PRESET_NONE;
+    u8Swap = PRESET_NONE;
+    cv_param_set_values(&pxImage[0]->param);
+    u8Active = 0U;
+    _use_image(0U);
+}
+
+bool cv_preset_save(uint8_t preset)
+{
+    bool bRetval = false;
+
+    /* Spare image is needed unless saving the active preset */
+    if ((preset < CV_PRESET_NUM) && !cv_preset_is_busy())
+    {
+        uint16_t u16Len = 0U;
+        const void *pvCurve = cv_store_get(PRESET_KEY_CURVE, &u16Len);
+
+        _snapshot(&xPresetBuf);
+
+        bRetval = cv_store_set(PRESET_KEY(preset), &xPresetBuf, sizeof(xPresetBuf));
+
+        /* Active preset already holds this configuration, others may be
+         * in use by the engine task and are replaced on its frame boundary */
+        if (bRetval && (preset != u8Active))
+        {
+            _compile(pxSpare, &xPresetBuf);
+            PRESET_BARRIER();
+            u8Swap = preset;
+        }
+
+        /* Avoid flash wear, the curve rarely changes between saves */
+        if (bRetval &&
+            ((pvCurve == NULL) || (u16Len != PRESET_CURVE_LEN) || (memcmp(pvCurve, cv_curve_get_user(), PRESET_CURVE_LEN) != 0)))
+        {
+            bRetval = cv_store_set(PRESET_KEY_CURVE, cv_curve_get_user(), PRESET_CURVE_LEN);
+        }
+    }
+
+    return bRetval;
+}
+
+bool cv_preset_load(uint8_t preset)
+{
+    bool bRetval = false;
+
+    if (preset < CV_PRESET_NUM)
+    {
+        u8Pending = preset;
+        bRetval = true;
+    }
+
+    return bRetval;
+}
+
+void cv_preset_apply(void)
+{
+    uint8_t u8Preset = u8Swap;
+
+    /* Swap first, a preset requested on the same frame gets the new image */
+    if (u8Preset != PRESET_NONE)
+    {
+        cv_preset_image_t *pxOld = pxImage[u8Preset];
+
+        PRESET_BARRIER();
+        pxImage[u8Preset] = pxSpare;
+        if (u8Preset == u8Active)
+        {
+            _use_image(u8Preset);
+        }
+        pxSpare = pxOld;
+        PRESET_BARRIER();
+        u8Swap = PRESET_NONE;
+    }
+
+    u8Preset = u8Pending;
+    if (u8Preset != PRESET_NONE)
+    {
+        u8Pending = PRESET_NONE;
+        _use_image(u8Preset);
+    }
+}
+
+cv_preset_t *cv_preset_edit(void)
+{
+    cv_preset_t *pxRetval = NULL;
+
+    if (!cv_preset_is_busy())
+    {
+        u8Edit = u8Active;
+        _snapshot(&xPresetBuf);
+        pxRetval = &xPresetBuf;
+    }
+
+    return pxRetval;
+}
+
+void cv_preset_publish(void)
+{
+    /* Live parameters are kept by the swap, edited copy may be older */
+    _compile(pxSpare, &xPresetBuf);
+    PRESET_BARRIER();
+    u8Swap = u8Edit;
+}
+
+bool cv_preset_is_busy(void)
+{
+    return (u8Swap != PRESET_NONE);
+}
+
+uint8_t cv_preset_get_active(void)
+{
+    return u8Active;
+}
+
+/* EOF */
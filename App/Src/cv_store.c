@@ -0,0 +1,417 @@
+/**
+ * @file    cv_store.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Log structured key value store on flash. Values are read in place
+ *          through a RAM index, writes append records and never erase.
+ *
+ *          Pages are used as a ring. The page after the write page is kept
+ *          erased as spare. When the write page is full the spare becomes the
+ *          write page and live records of the oldest page are copied to it.
+ *          The oldest page is the new spare, erased later by cv_store_reclaim
+ *          as an erase stalls the whole flash.
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
+#include "cv_store.h"
+#include "crc32.h"
+#include "sys_flash.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+
+/** Page header */
+typedef struct store_page
+{
+    uint32_t magic;         /**< Page marker */
+    uint32_t seq;           /**< Page sequence, newest is highest */
+} store_page_t;
+
+/** Record header, followed by value padded to write size */
+typedef struct store_record
+{
+    uint16_t key;           /**< Value key */
+    uint16_t len;           /**< Value length */
+    uint32_t crc;           /**< CRC of key, length and value */
+} store_record_t;
+
+/* Private define ------------------------------------------------------------*/
+
+/* Page marker */
+#define STORE_MAGIC             0x3053564BUL
+
+/* Flash area used */
+#define STORE_AREA              SYS_FLASH_AREA_PRESET
+
+/* Key of an erased record */
+#define STORE_KEY_ERASED        0xFFFFU
+
+/* No write page */
+#define STORE_PAGE_NONE         0xFFU
+
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/** Round length up to flash write size */
+#define STORE_ALIGN(len)        (((uint32_t)(len) + SYS_FLASH_WRITE_SIZE - 1U) & ~(SYS_FLASH_WRITE_SIZE - 1U))
+
+/** Record size on flash */
+#define STORE_RECORD_SIZE(len)  ((uint32_t)sizeof(store_record_t) + STORE_ALIGN(len))
+
+/* A record of the largest value must fit on an empty page */
+_Static_assert((sizeof(store_page_t) + STORE_RECORD_SIZE(CV_STORE_VALUE_MAX)) <= SYS_FLASH_PAGE_SIZE,
+               "CV_STORE_VALUE_MAX does not fit on a flash page");
+
+/* Private variables ---------------------------------------------------------*/
+
+/** Area offset of the newest record of each key, 0 if not stored */
+static uint16_t u16StoreIndex[CV_STORE_KEY_NUM];
+
+/** Write position */
+static uint8_t u8StorePage = STORE_PAGE_NONE;
+static uint32_t u32StoreOffset = 0U;
+static uint32_t u32StoreSeq = 0U;
+
+/** Spare page is blank, ready for the next page switch */
+static bool bStoreSpare = false;
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+ * @brief  Get flash address of an area offset.
+ * @param  offset area offset.
+ * @retval pointer to flash.
+ */
+static const uint8_t *_get_addr(uint32_t offset);
+
+/**
+ * @brief  Get number of pages of the store.
+ * @retval number of pages.
+ */
+static uint32_t _get_pages(void);
+
+/**
+ * @brief  Check a record CRC.
+ * @param  record record header in flash.
+ * @retval true if record is valid.
+ */
+static bool _check_record(const store_record_t *record);
+
+/**
+ * @brief  Scan records of a page and update index.
+ * @param  page page number.
+ * @retval offset after last record, page end if page is damaged.
+ */
+static uint32_t _scan_page(uint8_t page);
+
+/**
+ * @brief  Check a page is blank.
+ * @param  page page number.
+ * @retval true if page is blank.
+ */
+static bool _is_blank(uint8_t page);
+
+/**
+ * @brief  Get spare page, the one after the write page.
+ * @retval page number.
+ */
+static uint8_t _get_spare(void);
+
+/**
+ * @brief  Write a record at the write position.
+ * @param  key value key.
+ * @param  value value data.
+ * @param  len value length.
+ * @retval true if record was written.
+ */
+static bool _write_record(uint16_t key, const void *value, uint16_t len);
+
+/**
+ * @brief  Copy live records of a page to the write page.
+ * @param  page page number.
+ * @retval true if done, false if live values do not fit or flash fails.
+ */
+static bool _move_live(uint8_t page);
+
+/**
+ * @brief  Move write position to the spare page, taking live records out of
+ *         the oldest one. The oldest page is left to be erased as spare.
+ * @retval true if done.
+ */
+static bool _next_page(void);
+
+/* Private application code --------------------------------------------------*/
+
+static const uint8_t *_get_addr(uint32_t offset)
+{
+    return &((const uint8_t *)SYS_FLASH_GetAddr(STORE_AREA))[offset];
+}
+
+static uint32_t _get_pages(void)
+{
+    return SYS_FLASH_GetSize(STORE_AREA) / SYS_FLASH_PAGE_SIZE;
+}
+
+static bool _check_record(const store_record_t *record)
+{
+    uint32_t u32Crc = crc32_update(CRC32_INIT, record, offsetof(store_record_t, crc));
+
+    u32Crc = crc32_final(crc32_update(u32Crc, &record[1], record->len));
+
+    return (record->key < CV_STORE_KEY_NUM) && (record->crc == u32Crc);
+}
+
+static uint32_t _scan_page(uint8_t page)
+{
+    uint32_t u32Offset = (page * SYS_FLASH_PAGE_SIZE) + sizeof(store_page_t);
+    uint32_t u32End = (page + 1U) * SYS_FLASH_PAGE_SIZE;
+
+    while ((u32Offset + sizeof(store_record_t)) <= u32End)
+    {
+        const store_record_t *pxRecord = (const store_record_t *)_get_addr(u32Offset);
+
+        if ((pxRecord->key == STORE_KEY_ERASED) && (pxRecord->len == 0xFFFFU))
+        {
+            /* End of written records */
+            break;
+        }
+        else if ((pxRecord->len > CV_STORE_VALUE_MAX) || ((u32Offset + STORE_RECORD_SIZE(pxRecord->len)) > u32End))
+        {
+            /* Damaged, nothing is appended after it */
+            u32Offset = u32End;
+        }
+        else
+        {
+            /* Records cut by a reset are skipped */
+            if (_check_record(pxRecord))
+            {
+                u16StoreIndex[pxRecord->key] = (uint16_t)u32Offset;
+            }
+            u32Offset += STORE_RECORD_SIZE(pxRecord->len);
+        }
+    }
+
+    return u32Offset;
+}
+
+static bool _is_blank(uint8_t page)
+{
+    const uint32_t *pu32Page = (const uint32_t *)_get_addr(page * SYS_FLASH_PAGE_SIZE);
+    bool bBlank = true;
+
+    for (uint32_t i = 0; bBlank && (i < (SYS_FLASH_PAGE_SIZE / sizeof(uint32_t))); i++)
+    {
+        bBlank = (pu32Page[i] == UINT32_MAX);
+    }
+
+    return bBlank;
+}
+
+static uint8_t _get_spare(void)
+{
+    return (u8StorePage == STORE_PAGE_NONE) ? 0U : (uint8_t)((u8StorePage + 1U) % _get_pages());
+}
+
+static bool _write_record(uint16_t key, const void *value, uint16_t len)
+{
+    store_record_t xRecord;
+    uint8_t u8Tail[SYS_FLASH_WRITE_SIZE];
+    uint32_t u32Body = len & ~(SYS_FLASH_WRITE_SIZE - 1U);
+    uint32_t u32Offset = u32StoreOffset;
+    bool bRetval;
+
+    xRecord.key = key;
+    xRecord.len = len;
+    xRecord.crc = crc32_final(crc32_update(crc32_update(CRC32_INIT, &xRecord, offsetof(store_record_t, crc)), value, len));
+
+    memset(u8Tail, 0xFF, sizeof(u8Tail));
+    memcpy(u8Tail, &((const uint8_t *)value)[u32Body], len - u32Body);
+
+    /* Record start is kept even on failure, space is skipped */
+    u32StoreOffset += STORE_RECORD_SIZE(len);
+
+    bRetval = (SYS_FLASH_Write(STORE_AREA, u32Offset, &xRecord, sizeof(xRecord)) == SYS_FLASH_STATUS_OK) &&
+              ((u32Body == 0U) || (SYS_FLASH_Write(STORE_AREA, u32Offset + sizeof(xRecord), value, u32Body) == SYS_FLASH_STATUS_OK)) &&
+              ((u32Body == len) || (SYS_FLASH_Write(STORE_AREA, u32Offset + sizeof(xRecord) + u32Body, u8Tail, sizeof(u8Tail)) == SYS_FLASH_STATUS_OK)) &&
+              _check_record((const store_record_t *)_get_addr(u32Offset));
+
+    if (bRetval)
+    {
+        u16StoreIndex[key] = (uint16_t)u32Offset;
+    }
+
+    return bRetval;
+}
+
+static bool _move_live(uint8_t page)
+{
+    bool bRetval = true;
+
+    for (uint16_t i = 0; bRetval && (i < CV_STORE_KEY_NUM); i++)
+    {
+        uint32_t u32Offset = u16StoreIndex[i];
+
+        if ((u32Offset != 0U) && ((u32Offset / SYS_FLASH_PAGE_SIZE) == page))
+        {
+            const store_record_t *pxRecord = (const store_record_t *)_get_addr(u32Offset);
+
+            /* Page is kept when its live values do not fit */
+            bRetval = (cv_store_get_free() >= STORE_RECORD_SIZE(pxRecord->len)) &&
+                      _write_record(i, &pxRecord[1], pxRecord->len);
+        }
+    }
+
+    return bRetval;
+}
+
+static bool _next_page(void)
+{
+    uint8_t u8Page = _get_spare();
+    uint8_t u8Oldest = (uint8_t)((u8Page + 1U) % _get_pages());
+    store_page_t xHeader = {STORE_MAGIC, u32StoreSeq + 1U};
+    bool bRetval = bStoreSpare &&
+                   (SYS_FLASH_Write(STORE_AREA, u8Page * SYS_FLASH_PAGE_SIZE, &xHeader, sizeof(xHeader)) == SYS_FLASH_STATUS_OK);
+
+    if (bRetval)
+    {
+        u8StorePage = u8Page;
+        u32StoreOffset = (u8Page * SYS_FLASH_PAGE_SIZE) + sizeof(store_page_t);
+        u32StoreSeq++;
+
+        /* Oldest page is the new spare, its erase is left for later */
+        bRetval = _move_live(u8Oldest);
+        bStoreSpare = _is_blank(u8Oldest);
+    }
+
+    return bRetval;
+}
+
+/* Public application code ---------------------------------------------------*/
+
+bool cv_store_init(void)
+{
+    uint32_t u32Pages = _get_pages();
+    uint32_t u32Last = 0U;
+    bool bRetval = false;
+
+    for (uint32_t i = 0; i < CV_STORE_KEY_NUM; i++)
+    {
+        u16StoreIndex[i] = 0U;
+    }
+    u8StorePage = STORE_PAGE_NONE;
+    u32StoreOffset = 0U;
+    u32StoreSeq = 0U;
+
+    /* Replay pages from oldest to newest, newer records win */
+    do
+    {
+        const store_page_t *pxNext = NULL;
+        uint8_t u8Next = 0U;
+
+        for (uint8_t i = 0; i < u32Pages; i++)
+        {
+            const store_page_t *pxPage = (const store_page_t *)_get_addr(i * SYS_FLASH_PAGE_SIZE);
+
+            if ((pxPage->magic == STORE_MAGIC) && (pxPage->seq > u32Last) &&
+                ((pxNext == NULL) || (pxPage->seq < pxNext->seq)))
+            {
+                pxNext = pxPage;
+                u8Next = i;
+            }
+        }
+
+        if (pxNext != NULL)
+        {
+            u32Last = pxNext->seq;
+            u8StorePage = u8Next;
+            u32StoreSeq = u32Last;
+            u32StoreOffset = _scan_page(u8Next);
+            bRetval = true;
+        }
+        else
+        {
+            u32Last = 0U;
+        }
+    } while (u32Last != 0U);
+
+    bStoreSpare = _is_blank(_get_spare());
+
+    return bRetval;
+}
+
+const void *cv_store_get(uint16_t key, uint16_t *len)
+{
+    const void *pvRetval = NULL;
+
+    if ((key < CV_STORE_KEY_NUM) && (u16StoreIndex[key] != 0U))
+    {
+        const store_record_t *pxRecord = (const store_record_t *)_get_addr(u16StoreIndex[key]);
+
+        if (len != NULL)
+        {
+            *len = pxRecord->len;
+        }
+        pvRetval = &pxRecord[1];
+    }
+
+    return pvRetval;
+}
+
+bool cv_store_set(uint16_t key, const void *value, uint16_t len)
+{
+    USER_ASSERT(value != NULL);
+
+    bool bRetval = (key < CV_STORE_KEY_NUM) && (len <= CV_STORE_VALUE_MAX);
+    uint32_t u32Pages = _get_pages();
+
+    /* Every page is reclaimed once at most, the store is full after that */
+    for (uint32_t i = 0; bRetval && (cv_store_get_free() < STORE_RECORD_SIZE(len)); i++)
+    {
+        bRetval = (i < u32Pages) && _next_page();
+    }
+
+    bRetval = bRetval && _write_record(key, value, len);
+
+    return bRetval;
+}
+
+bool cv_store_need_reclaim(void)
+{
+    return !bStoreSpare;
+}
+
+bool cv_store_reclaim(void)
+{
+    if (!bStoreSpare)
+    {
+        uint8_t u8Spare = _get_spare();
+
+        /* Live values are only left there by a reset or a full store */
+        bStoreSpare = _move_live(u8Spare) &&
+                      (SYS_FLASH_Erase(STORE_AREA, u8Spare * SYS_FLASH_PAGE_SIZE) == SYS_FLASH_STATUS_OK);
+    }
+
+    return bStoreSpare;
+}
+
+uint32_t cv_store_get_free(void)
+{
+    uint32_t u32Retval = 0U;
+
+    if (u8StorePage != STORE_PAGE_NONE)
+    {
+        u32Retval = ((u8StorePage + 1U) * SYS_FLASH_PAGE_SIZE) - u32StoreOffset;
+    }
+
+    return u32Retval;
+}
+
+/* EOF */
@@ -0,0 +1,252 @@
+/**
+  ******************************************************************************
+  * @file           : cv_task.c
+  * @brief          : Task to handle MIDI input and CV outputs
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "cv_task.h"
+#include "cv_clock.h"
+#include "cv_latency.h"
+#include "cv_loop.h"
+#include "cv_preset.h"
+#include "boot_prof.h"
+#include "sys_serial.h"
+#include "sys_cv.h"
+#include "sys_flash.h"
+#include "sys_mcu.h"
+#include "sys_rtos.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private includes ----------------------------------------------------------*/
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+
+/* MIDI input quiet time for the outputs to be idle */
+#define CV_IDLE_QUIET_US    500000UL
+
+/* Task signals, the engine events of cv_loop first */
+#define CV_SIGNAL_RX_IDLE   CV_LOOP_EVENT_RX
+#define CV_SIGNAL_ERROR     CV_LOOP_EVENT_ERROR
+#define CV_SIGNAL_CLOCK     CV_LOOP_EVENT_CLOCK
+#define CV_SIGNAL_TICK      (1UL << 3)
+#define CV_SIGNAL_LAT_RESET (1UL << 4)
+#define CV_SIGNAL_ALL       (CV_SIGNAL_RX_IDLE | CV_SIGNAL_TICK | CV_SIGNAL_ERROR | CV_SIGNAL_CLOCK | CV_SIGNAL_LAT_RESET)
+
+/* Private macro -------------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+
+TaskHandle_t cv_task_handle = NULL;
+
+/* Time the last reception idle event notified the task */
+static volatile uint32_t u32WakeUs = 0U;
+
+/* Task memory, no heap is used */
+static StaticTask_t xCvTcb;
+static StackType_t xCvStack[CV_TASK_STACK];
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+  * @brief Main CV task
+  * @param pvParameters function paramters
+  * @retval None
+  */
+void _cv_main(void *pvParameters);
+
+/**
+  * @brief Callback to handle MIDI serial events
+  * @param event serial event generated
+  * @retval None
+  */
+SYS_RAM_FUNC void _cv_event_cb(sys_serial_event_t event);
+
+/**
+  * @brief Callback executed on every output tick
+  * @retval None
+  */
+SYS_RAM_FUNC void _cv_tick_cb(void);
+
+/**
+  * @brief Callback executed while flash is erased, keeps output ticks
+  * @retval None
+  */
+SYS_RAM_FUNC void _cv_erase_cb(void);
+
+/**
+  * @brief Callback executed when a scheduled clock pulse is due
+  * @retval None
+  */
+SYS_RAM_FUNC void _cv_compare_cb(void);
+
+/* Private fuctions ----------------------------------------------------------*/
+
+void _cv_event_cb(sys_serial_event_t event)
+{
+    BaseType_t wakeTask = pdFALSE;
+
+    if (cv_task_handle != NULL)
+    {
+        if (event == SYS_SERIAL_EVENT_RX_IDLE)
+        {
+            u32WakeUs = SYS_RTOS_GetTimeUs();
+            xTaskNotifyFromISR(cv_task_handle, CV_SIGNAL_RX_IDLE, eSetBits, &wakeTask);
+        }
+        else if ((event == SYS_SERIAL_EVENT_ERROR) || (event == SYS_SERIAL_EVENT_RX_BUF_FULL))
+        {
+            xTaskNotifyFromISR(cv_task_handle, CV_SIGNAL_ERROR, eSetBits, &wakeTask);
+        }
+        else
+        {
+            /* code */
+        }
+    }
+
+    portYIELD_FROM_ISR(wakeTask);
+}
+
+void _cv_tick_cb(void)
+{
+    BaseType_t wakeTask = pdFALSE;
+
+    cv_loop_latch();
+
+    if (cv_task_handle != NULL)
+    {
+        xTaskNotifyFromISR(cv_task_handle, CV_SIGNAL_TICK, eSetBits, &wakeTask);
+    }
+
+    portYIELD_FROM_ISR(wakeTask);
+}
+
+void _cv_erase_cb(void)
+{
+    /* Ticks are counted so the engine catches up once flash is back */
+    if (SYS_CV_TickPoll())
+    {
+        cv_loop_latch();
+    }
+}
+
+void _cv_compare_cb(void)
+{
+    BaseType_t wakeTask = pdFALSE;
+
+    cv_loop_clock_edge();
+
+    if (cv_task_handle != NULL)
+    {
+        xTaskNotifyFromISR(cv_task_handle, CV_SIGNAL_CLOCK, eSetBits, &wakeTask);
+    }
+
+    portYIELD_FROM_ISR(wakeTask);
+}
+
+void _cv_main( void *pvParameters )
+{
+    uint32_t u32Events;
+
+    boot_prof_mark(BOOT_PROF_SCHEDULER);
+
+    /* Infinite loop */
+    for(;;)
+    {
+        if (xTaskNotifyWait(0, CV_SIGNAL_ALL, &u32Events, portMAX_DELAY) == pdPASS)
+        {
+            /* Histograms have a single writer, cleared here for other tasks */
+            if ((u32Events & CV_SIGNAL_LAT_RESET) != 0U)
+            {
+                cv_latency_reset();
+            }
+
+            /* Interrupt to task wake up, includes any work pending when notified */
+            if ((u32Events & CV_SIGNAL_RX_IDLE) != 0U)
+            {
+                cv_latency_add(CV_LATENCY_WAKE, SYS_RTOS_GetTimeUs() - u32WakeUs);
+            }
+
+            cv_loop_run(u32Events);
+        }
+    }
+}
+
+/* Public fuctions -----------------------------------------------------------*/
+
+bool bCvTaskInit(void)
+{
+    bool bRetval = false;
+
+    /* Init engine state */
+    cv_loop_init(SYS_RTOS_GetTimeUs);
+
+    /* Create task */
+    cv_task_handle = xTaskCreateStatic(_cv_main, CV_TASK_NAME, CV_TASK_STACK, NULL, CV_TASK_PRIO, xCvStack, &xCvTcb);
+
+    /* Init HW resources */
+    (void)SYS_SERIAL_Init(CV_LOOP_SERIAL, _cv_event_cb);
+    (void)SYS_CV_Init(CV_ENGINE_TICK_HZ, _cv_tick_cb);
+    (void)SYS_CV_CompareInit(_cv_compare_cb);
+    SYS_FLASH_SetEraseCb(_cv_erase_cb);
+
+    /* Drive outputs from the initial engine state right away, the tick
+     * keeps them once the scheduler starts */
+    cv_loop_start();
+    boot_prof_mark(BOOT_PROF_OUTPUT);
+
+    /* Check resources */
+    if (cv_task_handle != NULL)
+    {
+        bRetval = true;
+    }
+    else
+    {
+        ERR_ASSERT(0U);
+    }
+
+    return bRetval;
+}
+
+void vCvTaskGetFrame(cv_frame_t *pxFrame)
+{
+    USER_ASSERT(pxFrame != NULL);
+
+    cv_loop_get_frame(pxFrame);
+}
+
+bool bCvTaskIsIdle(void)
+{
+    cv_frame_t xFrame;
+
+    vCvTaskGetFrame(&xFrame);
+
+    return (xFrame.gates == 0U) && !cv_clock_is_running() &&
+           ((SYS_RTOS_GetTimeUs() - SYS_SERIAL_GetRxTime(CV_LOOP_SERIAL)) >= CV_IDLE_QUIET_US);
+}
+
+void vCvTaskLatencyReset(void)
+{
+    if (cv_task_handle != NULL)
+    {
+        (void)xTaskNotify(cv_task_handle, CV_SIGNAL_LAT_RESET, eSetBits);
+    }
+}
+
+void vCvTaskWaitPreset(void)
+{
+    /* Swap is done on the next output frame */
+    while (cv_preset_is_busy())
+    {
+        vTaskDelay(1);
+    }
+}
+
+/*****END OF FILE****/
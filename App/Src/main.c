@@ -21,6 +21,8 @@
 #include "sys_mcu.h"
 #include "sys_rtos.h"
 #include "cli_task.h"
+#include "cv_task.h"
+#include "boot_prof.h"
 #ifdef USE_USER_ASSERT
 #include "user_error.h"
 #endif
@@ -49,12 +51,21 @@ int main(void)
 
   /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
   SYS_Init();
+  boot_prof_mark(BOOT_PROF_SYS_INIT);
 
   /* Configure the system clock */
   SYS_SystemClockConfig();
+  boot_prof_mark(BOOT_PROF_CLOCK);
 
-  /* Init user tasks */
+  /* Start microsecond time base */
+  SYS_RTOS_ClockConfig();
+  boot_prof_mark(BOOT_PROF_TIME_BASE);
+
+  /* Init user tasks, outputs first so they reach defined levels early */
+  (void)bCvTaskInit();
+  boot_prof_mark(BOOT_PROF_CV_INIT);
   (void)bCliTaskInit();
+  boot_prof_mark(BOOT_PROF_CLI_INIT);
 
   /* Start the scheduler so the tasks start executing. */
   vTaskStartScheduler();
@@ -0,0 +1,55 @@
+/**
+ * @file sys_host.h
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief Shared resources of the host BSP, firmware running on Linux over
+ *        the FreeRTOS POSIX port.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __SYS_HOST_H
+#define __SYS_HOST_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Exported includes --------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ---------------------------------------------------------*/
+/* Exported macro -----------------------------------------------------------*/
+/* Exported functions prototypes --------------------------------------------*/
+
+/**
+ * @brief Get monotonic time since the process started
+ * @retval time in nanoseconds
+ */
+uint64_t SYS_HOST_GetTimeNs(void);
+
+/**
+ * @brief Serve serial reception, called from the interrupt emulation task
+ *        with the kernel in a critical section
+ * @retval None
+ */
+void SYS_HOST_SerialPoll(void);
+
+/**
+ * @brief Serve output tick and compare events, called from the interrupt
+ *        emulation task with the kernel in a critical section
+ * @retval None
+ */
+void SYS_HOST_CvPoll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYS_HOST_H */
+
+/*EOF*/
@@ -0,0 +1,42 @@
+/**
+ * @file sys_crc.c
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief Host BSP, CRC-32 computed in software with the flash record CRC.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Private includes --------------------------------------------------------*/
+#include <stddef.h>
+#include "sys_crc.h"
+#include "crc32.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private macro -----------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Public function definition ----------------------------------------------*/
+
+sys_crc_status_t SYS_CRC_Init(void)
+{
+    /* No unit to configure on host */
+    return SYS_CRC_STATUS_OK;
+}
+
+uint32_t SYS_CRC_Calc(const uint8_t *data, uint32_t len)
+{
+    USER_ASSERT(data != NULL);
+
+    return crc32_calc(data, len);
+}
+
+/*EOF*/
@@ -0,0 +1,150 @@
+/**
+ * @file sys_cv.c
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief Host BSP, analog and gate outputs. Output values are kept in memory,
+ *        output tick and compare events are served from the interrupt
+ *        emulation task against the RTOS time base.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Private includes --------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
+#include "sys_cv.h"
+#include "sys_host.h"
+#include "sys_rtos.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private macro -----------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private defines ---------------------------------------------------------*/
+
+/* Max output ticks served on a poll, the rest are dropped as on an overrun */
+#define CV_TICK_CATCH_UP    (64U)
+
+/* Private variable ---------------------------------------------------------*/
+
+static sys_cv_tick_cb cv_tick_cb = NULL;
+static sys_cv_compare_cb cv_compare_cb = NULL;
+
+/* Output tick period and next tick time */
+static uint32_t cv_tick_us = 0U;
+static uint32_t cv_tick_next = 0U;
+
+/* Pending compare event */
+static bool cv_compare_on = false;
+static uint32_t cv_compare_time = 0U;
+
+/* Output state */
+static uint16_t cv_codes[SYS_CV_ANALOG_NUM] = {0};
+static uint8_t cv_gates = 0U;
+
+/* Private functions prototypes --------------------------------------------*/
+/* Private functions definition --------------------------------------------*/
+/* Public functions definition ---------------------------------------------*/
+
+void SYS_HOST_CvPoll(void)
+{
+    uint32_t u32Now = SYS_RTOS_GetTimeUs();
+
+    if (cv_tick_cb != NULL)
+    {
+        uint32_t u32Ticks = 0U;
+
+        while (((int32_t)(u32Now - cv_tick_next) >= 0) && (u32Ticks < CV_TICK_CATCH_UP))
+        {
+            cv_tick_next += cv_tick_us;
+            cv_tick_cb();
+            u32Ticks++;
+        }
+
+        if (u32Ticks == CV_TICK_CATCH_UP)
+        {
+            /* Process was stopped, restart the tick from now */
+            cv_tick_next = u32Now + cv_tick_us;
+        }
+    }
+
+    if (cv_compare_on && ((int32_t)(u32Now - cv_compare_time) >= 0))
+    {
+        cv_compare_on = false;
+        if (cv_compare_cb != NULL)
+        {
+            cv_compare_cb();
+        }
+    }
+}
+
+sys_cv_status_t SYS_CV_Init(uint32_t tick_hz, sys_cv_tick_cb tick_cb)
+{
+    sys_cv_status_t eRetval = SYS_CV_STATUS_ERROR;
+
+    if ((tick_hz != 0U) && (tick_hz <= 1000000UL))
+    {
+        cv_tick_us = 1000000UL / tick_hz;
+        cv_tick_next = SYS_RTOS_GetTimeUs() + cv_tick_us;
+        cv_tick_cb = tick_cb;
+        eRetval = SYS_CV_STATUS_OK;
+    }
+
+    return eRetval;
+}
+
+void SYS_CV_WriteAnalog(const uint16_t *codes)
+{
+    USER_ASSERT(codes != NULL);
+
+    memcpy(cv_codes, codes, sizeof(cv_codes));
+}
+
+void SYS_CV_WriteGates(uint8_t mask)
+{
+    cv_gates = mask & ((1U << SYS_CV_GATE_NUM) - 1U);
+}
+
+sys_cv_status_t SYS_CV_CompareInit(sys_cv_compare_cb compare_cb)
+{
+    cv_compare_cb = compare_cb;
+
+    return SYS_CV_STATUS_OK;
+}
+
+void SYS_CV_CompareStart(uint32_t delay_us)
+{
+    cv_compare_time = SYS_RTOS_GetTimeUs() + delay_us;
+    cv_compare_on = true;
+}
+
+void SYS_CV_CompareStop(void)
+{
+    cv_compare_on = false;
+}
+
+bool SYS_CV_TickPoll(void)
+{
+    /* Ticks are never masked on host, they are served by the poll */
+    return false;
+}
+
+void SYS_CV_TickIRQHandler(void)
+{
+    /* No timer interrupt on host */
+}
+
+void SYS_CV_CompareIRQHandler(void)
+{
+    /* No timer interrupt on host */
+}
+
+/*EOF*/
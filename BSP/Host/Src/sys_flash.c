@@ -0,0 +1,115 @@
+/**
+ * @file sys_flash.c
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief Host BSP, flash areas emulated on RAM with flash write rules.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Private includes --------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
+#include "sys_flash.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private macro -----------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private defines ---------------------------------------------------------*/
+
+/* Area sizes, as reserved on linker script */
+#define FLASH_AREA_SIZE     (8U * 1024U)
+
+/* Private variable ---------------------------------------------------------*/
+
+/* Areas start erased, aligned as flash pages are */
+static uint8_t flash_area[SYS_FLASH_AREA_NUM][FLASH_AREA_SIZE] __attribute__((aligned(SYS_FLASH_WRITE_SIZE))) = {
+    [0 ... (SYS_FLASH_AREA_NUM - 1)] = {[0 ... (FLASH_AREA_SIZE - 1)] = SYS_FLASH_ERASED},
+};
+
+static sys_flash_erase_cb flash_erase_cb = NULL;
+
+/* Private functions prototypes --------------------------------------------*/
+/* Private functions definition --------------------------------------------*/
+/* Public functions definition ---------------------------------------------*/
+
+const void *SYS_FLASH_GetAddr(sys_flash_area_t area)
+{
+    USER_ASSERT(area < SYS_FLASH_AREA_NUM);
+
+    return flash_area[area];
+}
+
+uint32_t SYS_FLASH_GetSize(sys_flash_area_t area)
+{
+    USER_ASSERT(area < SYS_FLASH_AREA_NUM);
+
+    return FLASH_AREA_SIZE;
+}
+
+void SYS_FLASH_SetEraseCb(sys_flash_erase_cb erase_cb)
+{
+    flash_erase_cb = erase_cb;
+}
+
+sys_flash_status_t SYS_FLASH_Erase(sys_flash_area_t area, uint32_t offset)
+{
+    sys_flash_status_t eRetval = SYS_FLASH_STATUS_ERROR;
+
+    if ((area < SYS_FLASH_AREA_NUM) && (offset < FLASH_AREA_SIZE))
+    {
+        offset -= offset % SYS_FLASH_PAGE_SIZE;
+        memset(&flash_area[area][offset], SYS_FLASH_ERASED, SYS_FLASH_PAGE_SIZE);
+
+        /* Erase is instant, let the caller service once as on target */
+        if (flash_erase_cb != NULL)
+        {
+            flash_erase_cb();
+        }
+        eRetval = SYS_FLASH_STATUS_OK;
+    }
+
+    return eRetval;
+}
+
+sys_flash_status_t SYS_FLASH_Write(sys_flash_area_t area, uint32_t offset, const void *data, uint32_t len)
+{
+    USER_ASSERT(data != NULL);
+
+    sys_flash_status_t eRetval = SYS_FLASH_STATUS_ERROR;
+
+    if ((area < SYS_FLASH_AREA_NUM) &&
+        ((offset % SYS_FLASH_WRITE_SIZE) == 0U) &&
+        ((len % SYS_FLASH_WRITE_SIZE) == 0U) &&
+        ((offset + len) <= FLASH_AREA_SIZE))
+    {
+        eRetval = SYS_FLASH_STATUS_OK;
+
+        /* Programming a word not erased fails on target */
+        for (uint32_t i = 0; (i < len) && (eRetval == SYS_FLASH_STATUS_OK); i++)
+        {
+            if (flash_area[area][offset + i] != SYS_FLASH_ERASED)
+            {
+                eRetval = SYS_FLASH_STATUS_ERROR;
+            }
+        }
+
+        if (eRetval == SYS_FLASH_STATUS_OK)
+        {
+            memcpy(&flash_area[area][offset], data, len);
+        }
+    }
+
+    return eRetval;
+}
+
+/*EOF*/
@@ -0,0 +1,127 @@
+/**
+ * @file sys_mcu.c
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief Host BSP, process level init and reset.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#include "sys_mcu.h"
+#include "sys_host.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private variables --------------------------------------------------------*/
+
+/** Core clock used by the RTOS configuration */
+uint32_t SystemCoreClock = 64000000UL;
+
+/** Process start time */
+static uint64_t u64StartNs = 0U;
+
+/* Private macro -----------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private defines ----------------------------------------------------------*/
+/* Private declarations -----------------------------------------------------*/
+
+/**
+ * @brief Get monotonic clock
+ * @retval time in nanoseconds
+ */
+static uint64_t _get_clock_ns(void);
+
+#ifdef USE_USER_ASSERT
+/**
+  * @brief  Show assert info on stderr and stop the process
+  * @param  msg: error message
+  * @param  len: size of error msg
+  * @retval None
+  */
+static void vErrorHandler(char *msg, uint32_t len);
+#endif
+
+/* Private definitions ------------------------------------------------------*/
+
+static uint64_t _get_clock_ns(void)
+{
+  struct timespec xNow;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &xNow);
+
+  return ((uint64_t)xNow.tv_sec * 1000000000ULL) + (uint64_t)xNow.tv_nsec;
+}
+
+#ifdef USE_USER_ASSERT
+static void vErrorHandler(char *msg, uint32_t len)
+{
+  (void)write(STDERR_FILENO, msg, len);
+  abort();
+}
+#endif
+
+/* Public functions ---------------------------------------------------------*/
+
+uint64_t SYS_HOST_GetTimeNs(void)
+{
+  return _get_clock_ns() - u64StartNs;
+}
+
+void SYS_Init(void)
+{
+  u64StartNs = _get_clock_ns();
+
+#ifdef USE_USER_ASSERT
+  /* Init Error interface */
+  vErrorInit(vErrorHandler);
+#endif
+}
+
+void SYS_SystemClockConfig(void)
+{
+  /* Nothing to configure on host */
+}
+
+uint32_t SYS_MCU_GetTickUs(void)
+{
+  return (uint32_t)(SYS_HOST_GetTimeNs() / 1000U);
+}
+
+uint32_t SYS_MCU_GetStackFree(void)
+{
+  /* Main stack is not painted on host */
+  return 0U;
+}
+
+uint32_t SYS_MCU_GetStackSize(void)
+{
+  return 0U;
+}
+
+void SYS_Reset(void)
+{
+  struct itimerval xStop = {0};
+
+  /* Tick timer survives exec and would kill the new process before the
+     scheduler installs its handler */
+  (void)setitimer(ITIMER_REAL, &xStop, NULL);
+
+  /* Start over as a new process, descriptors are closed on exec */
+  (void)execl("/proc/self/exe", "/proc/self/exe", (char *)NULL);
+  exit(EXIT_FAILURE);
+}
+
+/*EOF*/
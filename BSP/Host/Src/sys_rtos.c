@@ -0,0 +1,121 @@
+/**
+ * @file sys_rtos.c
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief Host BSP, RTOS support. Peripheral interrupts are emulated by the
+ *        highest priority task, which serves them every tick inside a
+ *        critical section so interrupt safe kernel calls stay valid.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "sys_rtos.h"
+#include "sys_host.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+#include "task.h"
+
+/* Private variables --------------------------------------------------------*/
+
+/** Time base start, relative to process start */
+static uint64_t u64TimeBaseNs = 0U;
+
+/** Kernel task memory, no heap is used */
+static StaticTask_t xIdleTcb;
+static StackType_t xIdleStack[configMINIMAL_STACK_SIZE];
+static StaticTask_t xTimerTcb;
+static StackType_t xTimerStack[configTIMER_TASK_STACK_DEPTH];
+
+/** Interrupt emulation task memory */
+static StaticTask_t xIrqTcb;
+static StackType_t xIrqStack[configMINIMAL_STACK_SIZE];
+
+/* Private macro -----------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private defines ----------------------------------------------------------*/
+
+/* Interrupt emulation task */
+#define RTOS_IRQ_TASK_NAME  "IRQ"
+#define RTOS_IRQ_TASK_PRIO  (configMAX_PRIORITIES - 1U)
+
+/* Private declarations -----------------------------------------------------*/
+
+/**
+ * @brief Interrupt emulation task
+ * @param pvParameters task parameters
+ * @retval None
+ */
+static void _irq_main(void *pvParameters);
+
+/* Private definitions ------------------------------------------------------*/
+
+static void _irq_main(void *pvParameters)
+{
+  for (;;)
+  {
+    vTaskDelay(1U);
+
+    /* Callbacks only wake lower priority tasks, no yield happens inside */
+    taskENTER_CRITICAL();
+    SYS_HOST_SerialPoll();
+    SYS_HOST_CvPoll();
+    taskEXIT_CRITICAL();
+  }
+}
+
+void vApplicationTickHook(void)
+{
+  /* No HAL tick on host */
+}
+
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
+{
+  ERR_ASSERT(0U);
+}
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+  *ppxIdleTaskTCBBuffer = &xIdleTcb;
+  *ppxIdleTaskStackBuffer = xIdleStack;
+  *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+  *ppxTimerTaskTCBBuffer = &xTimerTcb;
+  *ppxTimerTaskStackBuffer = xTimerStack;
+  *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+/* Public functions ---------------------------------------------------------*/
+
+void SYS_RTOS_ClockConfig(void)
+{
+  u64TimeBaseNs = SYS_HOST_GetTimeNs();
+
+  if (xTaskCreateStatic(_irq_main, RTOS_IRQ_TASK_NAME, configMINIMAL_STACK_SIZE, NULL,
+                        RTOS_IRQ_TASK_PRIO, xIrqStack, &xIrqTcb) == NULL)
+  {
+    USER_ASSERT(0);
+  }
+}
+
+uint32_t SYS_RTOS_GetTimeUs(void)
+{
+  return (uint32_t)((SYS_HOST_GetTimeNs() - u64TimeBaseNs) / 1000U);
+}
+
+/*EOF*/
@@ -0,0 +1,325 @@
+/**
+ * @file sys_serial.c
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief Host BSP, serial interfaces. Serial 0 (CLI) runs on stdin and
+ *        stdout, serial 1 (MIDI input) on a pseudo terminal whose name is
+ *        shown on stderr at init.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Private includes --------------------------------------------------------*/
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#include "sys_serial.h"
+#include "sys_host.h"
+#include "sys_rtos.h"
+#include "circular_buffer.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private macro -----------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private defines ---------------------------------------------------------*/
+
+/* Serial 0 circular buffer size */
+#define SERIAL_0_CBUF_SIZE  (350U)
+
+/* Serial 1 (MIDI) circular buffer size */
+#define SERIAL_1_CBUF_SIZE  (128U)
+
+/* Bytes read from a descriptor on each poll, like a DMA reception block */
+#define SERIAL_READ_SIZE    (16U)
+
+/* Number of serial interfaces */
+#define SERIAL_NUM          (2U)
+
+/* Private types -----------------------------------------------------------*/
+
+/** Serial interface state */
+typedef struct host_serial
+{
+    int fd_in;                      /**< Reception descriptor, -1 if closed */
+    int fd_out;                     /**< Transmission descriptor, -1 if none */
+    circular_buf_t cbuf;            /**< Received data */
+    sys_serial_event_cb event_cb;   /**< Event callback */
+    volatile uint32_t rx_time;      /**< Reception time of last byte */
+} host_serial_t;
+
+/* Private variable ---------------------------------------------------------*/
+
+static host_serial_t xSerial[SERIAL_NUM] = {
+    {.fd_in = -1, .fd_out = -1},
+    {.fd_in = -1, .fd_out = -1},
+};
+
+static uint8_t rx_cbuf_serial0[SERIAL_0_CBUF_SIZE] = {0};
+static uint8_t rx_cbuf_serial1[SERIAL_1_CBUF_SIZE] = {0};
+
+/* MIDI pseudo terminal slave, kept open so reads do not fail between writers */
+static int serial1_slave = -1;
+
+/* Private functions prototypes --------------------------------------------*/
+
+/**
+  * @brief  Open pseudo terminal used as MIDI input, in raw mode
+  * @retval master descriptor, -1 on error
+  */
+static int BSP_OpenPty(void);
+
+/**
+  * @brief  Move available data from a descriptor to the circular buffer
+  * @param  serial serial interface
+  * @retval None
+  */
+static void BSP_PollRx(host_serial_t *serial);
+
+/* Private functions definition --------------------------------------------*/
+
+static int BSP_OpenPty(void)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+
+    if (fd >= 0)
+    {
+        struct termios xTerm;
+
+        if ((grantpt(fd) == 0) && (unlockpt(fd) == 0) && (tcgetattr(fd, &xTerm) == 0))
+        {
+            /* MIDI is binary, no line discipline processing */
+            cfmakeraw(&xTerm);
+            (void)tcsetattr(fd, TCSANOW, &xTerm);
+
+            serial1_slave = open(ptsname(fd), O_RDWR | O_NOCTTY | O_CLOEXEC);
+            fprintf(stderr, "MIDI input: %s\n", ptsname(fd));
+        }
+        else
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    return fd;
+}
+
+static void BSP_PollRx(host_serial_t *serial)
+{
+    struct pollfd xPoll = {.fd = serial->fd_in, .events = POLLIN};
+
+    if ((serial->fd_in >= 0) && (poll(&xPoll, 1, 0) > 0))
+    {
+        uint8_t u8Data[SERIAL_READ_SIZE];
+        ssize_t len = read(serial->fd_in, u8Data, sizeof(u8Data));
+
+        if (len > 0)
+        {
+            serial->rx_time = SYS_RTOS_GetTimeUs();
+
+            for (ssize_t i = 0; i < len; i++)
+            {
+                if (circular_buf_put2(&serial->cbuf, u8Data[i]) != 0)
+                {
+                    if (serial->event_cb != NULL)
+                    {
+                        serial->event_cb(SYS_SERIAL_EVENT_RX_BUF_FULL);
+                    }
+                    break;
+                }
+            }
+
+            if (serial->event_cb != NULL)
+            {
+                serial->event_cb(SYS_SERIAL_EVENT_RX_IDLE);
+            }
+        }
+        else if ((len == 0) && (serial->fd_in == STDIN_FILENO))
+        {
+            /* End of input, keep running for piped sessions */
+            serial->fd_in = -1;
+        }
+        else
+        {
+            /* Pseudo terminal hang up or interrupted read, retry next poll */
+        }
+    }
+}
+
+/* Public function definition ----------------------------------------------*/
+
+void SYS_HOST_SerialPoll(void)
+{
+    for (uint32_t i = 0; i < SERIAL_NUM; i++)
+    {
+        BSP_PollRx(&xSerial[i]);
+    }
+}
+
+sys_serial_status_t SYS_SERIAL_Init(sys_serial_port_t dev, sys_serial_event_cb event_cb)
+{
+    USER_ASSERT((dev == SYS_SERIAL_0) || (dev == SYS_SERIAL_1));
+
+    sys_serial_status_t eRetval = SYS_SERIAL_STATUS_ERROR;
+
+    if (dev == SYS_SERIAL_0)
+    {
+        circular_buf_init(&xSerial[0].cbuf, rx_cbuf_serial0, SERIAL_0_CBUF_SIZE);
+        xSerial[0].fd_in = STDIN_FILENO;
+        xSerial[0].fd_out = STDOUT_FILENO;
+        xSerial[0].event_cb = event_cb;
+        eRetval = SYS_SERIAL_STATUS_OK;
+    }
+    else if (dev == SYS_SERIAL_1)
+    {
+        circular_buf_init(&xSerial[1].cbuf, rx_cbuf_serial1, SERIAL_1_CBUF_SIZE);
+        xSerial[1].fd_in = BSP_OpenPty();
+        xSerial[1].event_cb = event_cb;
+
+        if (xSerial[1].fd_in >= 0)
+        {
+            eRetval = SYS_SERIAL_STATUS_OK;
+        }
+    }
+    else
+    {
+        /* No action */
+    }
+
+    return eRetval;
+}
+
+sys_serial_status_t SERIAL_DeInit(sys_serial_port_t dev)
+{
+    USER_ASSERT((dev == SYS_SERIAL_0) || (dev == SYS_SERIAL_1));
+
+    sys_serial_status_t eRetval = SYS_SERIAL_STATUS_ERROR;
+
+    if (dev < SERIAL_NUM)
+    {
+        taskENTER_CRITICAL();
+        if (dev == SYS_SERIAL_1)
+        {
+            close(xSerial[1].fd_in);
+            close(serial1_slave);
+            serial1_slave = -1;
+        }
+        xSerial[dev].fd_in = -1;
+        xSerial[dev].fd_out = -1;
+        xSerial[dev].event_cb = NULL;
+        taskEXIT_CRITICAL();
+
+        eRetval = SYS_SERIAL_STATUS_OK;
+    }
+
+    return eRetval;
+}
+
+sys_serial_status_t SYS_SERIAL_Send(sys_serial_port_t dev, uint8_t *pdata, uint16_t len)
+{
+    USER_ASSERT(dev == SYS_SERIAL_0);
+    USER_ASSERT(pdata != NULL);
+
+    sys_serial_status_t retval = SYS_SERIAL_STATUS_NODEF;
+
+    if ((dev < SERIAL_NUM) && (xSerial[dev].fd_out >= 0))
+    {
+        retval = SYS_SERIAL_STATUS_OK;
+
+        /* Tick signal may interrupt the write */
+        while ((len != 0U) && (retval == SYS_SERIAL_STATUS_OK))
+        {
+            ssize_t written = write(xSerial[dev].fd_out, pdata, len);
+
+            if (written > 0)
+            {
+                pdata += written;
+                len -= (uint16_t)written;
+            }
+            else if ((written < 0) && (errno != EINTR) && (errno != EAGAIN))
+            {
+                retval = SYS_SERIAL_STATUS_ERROR;
+            }
+            else
+            {
+                /* Retry */
+            }
+        }
+
+        /* Data is out, complete the transfer as the DMA interrupt would */
+        if (xSerial[dev].event_cb != NULL)
+        {
+            taskENTER_CRITICAL();
+            xSerial[dev].event_cb((retval == SYS_SERIAL_STATUS_OK) ? SYS_SERIAL_EVENT_TX_DONE : SYS_SERIAL_EVENT_ERROR);
+            taskEXIT_CRITICAL();
+        }
+    }
+
+    return retval;
+}
+
+uint16_t SYS_SERIAL_Read(sys_serial_port_t dev, uint8_t *pdata, uint16_t max_len)
+{
+    USER_ASSERT((dev == SYS_SERIAL_0) || (dev == SYS_SERIAL_1));
+    USER_ASSERT(pdata != NULL);
+
+    uint16_t u16ReadCount = 0;
+
+    if (dev < SERIAL_NUM)
+    {
+        taskENTER_CRITICAL();
+        while ((u16ReadCount < max_len) && (circular_buf_get(&xSerial[dev].cbuf, &pdata[u16ReadCount]) == 0))
+        {
+            u16ReadCount++;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    return u16ReadCount;
+}
+
+uint16_t SYS_SERIAL_GetReadCount(sys_serial_port_t dev)
+{
+    USER_ASSERT((dev == SYS_SERIAL_0) || (dev == SYS_SERIAL_1));
+
+    uint16_t u16ReadCount = 0;
+
+    if (dev < SERIAL_NUM)
+    {
+        taskENTER_CRITICAL();
+        u16ReadCount = (uint16_t)circular_buf_size(&xSerial[dev].cbuf);
+        taskEXIT_CRITICAL();
+    }
+
+    return u16ReadCount;
+}
+
+uint32_t SYS_SERIAL_GetRxTime(sys_serial_port_t dev)
+{
+    USER_ASSERT((dev == SYS_SERIAL_0) || (dev == SYS_SERIAL_1));
+
+    uint32_t u32RxTime = 0U;
+
+    if (dev < SERIAL_NUM)
+    {
+        u32RxTime = xSerial[dev].rx_time;
+    }
+
+    return u32RxTime;
+}
+
+/*EOF*/
@@ -0,0 +1,142 @@
+/**
+ * @file sys_trace.c
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief Host BSP, scheduler event trace on a circular RAM buffer. Same
+ *        format as target, the tick signal is blocked while recording.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Private includes --------------------------------------------------------*/
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include "sys_trace.h"
+#include "sys_rtos.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private macro -----------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private defines ---------------------------------------------------------*/
+
+/* Index mask of the event buffer */
+#define TRACE_EVENT_MASK    (SYS_TRACE_EVENT_NUM - 1U)
+
+/* Private variable ---------------------------------------------------------*/
+
+/* Event buffer, written on a circle */
+static sys_trace_event_t xTraceEvents[SYS_TRACE_EVENT_NUM];
+
+/* Events recorded since last start, next write position */
+static volatile uint32_t u32TraceHead = 0U;
+
+/* Recording state, off until started as on target */
+static volatile bool bTraceOn = false;
+
+/* Private functions prototypes --------------------------------------------*/
+/* Private functions definition --------------------------------------------*/
+/* Public functions definition ---------------------------------------------*/
+
+void SYS_TRACE_Record(uint8_t type, uint8_t id, uint16_t arg)
+{
+    if (bTraceOn)
+    {
+        sigset_t xAll;
+        sigset_t xSaved;
+
+        /* Tick signal runs kernel hooks too, keep slot and timestamp in order */
+        (void)sigfillset(&xAll);
+        (void)pthread_sigmask(SIG_BLOCK, &xAll, &xSaved);
+
+        sys_trace_event_t *pxEvent = &xTraceEvents[u32TraceHead & TRACE_EVENT_MASK];
+
+        pxEvent->time_us = SYS_RTOS_GetTimeUs();
+        pxEvent->type = type;
+        pxEvent->id = id;
+        pxEvent->arg = arg;
+        u32TraceHead++;
+
+        (void)pthread_sigmask(SIG_SETMASK, &xSaved, NULL);
+    }
+}
+
+void SYS_TRACE_IsrEnter(void)
+{
+    /* No exception number on host */
+    SYS_TRACE_Record(SYS_TRACE_ISR, 0U, 0U);
+}
+
+void SYS_TRACE_IsrExit(void)
+{
+    /* Interrupts are emulated by a task on host */
+}
+
+bool SYS_TRACE_GetIsr(uint8_t irq, sys_trace_isr_t *stats)
+{
+    USER_ASSERT(stats != NULL);
+
+    stats->count = 0U;
+    stats->min_cycles = 0U;
+    stats->max_cycles = 0U;
+    stats->sum_cycles = 0U;
+
+    return false;
+}
+
+void SYS_TRACE_ResetIsr(void)
+{
+    /* No statistics on host */
+}
+
+void SYS_TRACE_Start(void)
+{
+    bTraceOn = false;
+    u32TraceHead = 0U;
+    bTraceOn = true;
+}
+
+void SYS_TRACE_Stop(void)
+{
+    bTraceOn = false;
+}
+
+uint32_t SYS_TRACE_GetCount(void)
+{
+    uint32_t u32Head = u32TraceHead;
+
+    return (u32Head < SYS_TRACE_EVENT_NUM) ? u32Head : SYS_TRACE_EVENT_NUM;
+}
+
+uint32_t SYS_TRACE_GetDropped(void)
+{
+    return u32TraceHead - SYS_TRACE_GetCount();
+}
+
+uint32_t SYS_TRACE_Read(uint32_t index, sys_trace_event_t *events, uint32_t num)
+{
+    uint32_t u32Count = SYS_TRACE_GetCount();
+    uint32_t u32Oldest = u32TraceHead - u32Count;
+    uint32_t u32Copied = 0U;
+
+    USER_ASSERT(events != NULL);
+
+    while ((index < u32Count) && (u32Copied < num))
+    {
+        events[u32Copied++] = xTraceEvents[(u32Oldest + index) & TRACE_EVENT_MASK];
+        index++;
+    }
+
+    return u32Copied;
+}
+
+/*EOF*/
@@ -39,6 +39,9 @@ void SysTick_Handler(void);
 void DMA1_Channel1_IRQHandler(void);
 void DMA1_Channel2_3_IRQHandler(void);
 void TIM3_IRQHandler(void);
+void TIM6_IRQHandler(void);
+void TIM17_IRQHandler(void);
+void USART1_IRQHandler(void);
 void USART2_IRQHandler(void);
 
 #ifdef __cplusplus
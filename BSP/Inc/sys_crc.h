@@ -0,0 +1,59 @@
+/**
+ * @file sys_crc.h
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief System support packet for CRC-32 computation on the CRC unit.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __SYS_CRC_H
+#define __SYS_CRC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Exported includes --------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ---------------------------------------------------------*/
+/* Exported types -----------------------------------------------------------*/
+
+/** Operation status */
+typedef enum
+{
+    SYS_CRC_STATUS_ERROR =      0U,
+    SYS_CRC_STATUS_OK =         1U,
+    SYS_CRC_STATUS_NODEF =      0xFFU,
+} sys_crc_status_t;
+
+/* Exported macro -----------------------------------------------------------*/
+/* Exported functions prototypes --------------------------------------------*/
+
+/**
+  * @brief  Init CRC unit for CRC-32 (IEEE 802.3), same result as crc32_calc
+  * @retval Operation status
+  */
+sys_crc_status_t SYS_CRC_Init(void);
+
+/**
+  * @brief  Compute CRC-32 of a data block. The unit is not shared, call from
+  *         a single task
+  * @param  data data block
+  * @param  len data length in bytes
+  * @retval CRC value
+  */
+uint32_t SYS_CRC_Calc(const uint8_t *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYS_CRC_H */
+
+/*EOF*/
@@ -0,0 +1,124 @@
+/**
+ * @file sys_cv.h
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief System support packet to handle analog and gate outputs.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __SYS_CV_H
+#define __SYS_CV_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Exported includes --------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported defines ---------------------------------------------------------*/
+
+/** Number of analog outputs */
+#define SYS_CV_ANALOG_NUM       4U
+
+/** Number of gate outputs */
+#define SYS_CV_GATE_NUM         4U
+
+/** Max analog code, outputs are always handled as 16 bit values */
+#define SYS_CV_CODE_MAX         0xFFFFU
+
+/* Exported types -----------------------------------------------------------*/
+
+/** Operation status */
+typedef enum
+{
+    SYS_CV_STATUS_ERROR =   0U,
+    SYS_CV_STATUS_OK =      1U,
+    SYS_CV_STATUS_NODEF =   0xFFU,
+} sys_cv_status_t;
+
+/** Output tick callback, called from interrupt context */
+typedef void (* sys_cv_tick_cb)(void);
+
+/** Compare event callback, called from interrupt context */
+typedef void (* sys_cv_compare_cb)(void);
+
+/* Exported macro -----------------------------------------------------------*/
+/* Exported functions prototypes --------------------------------------------*/
+
+/**
+  * @brief  Init analog outputs, gate outputs and output tick timer
+  * @param  tick_hz frequency of the output tick
+  * @param  tick_cb callback executed on every output tick
+  * @retval Operation status
+  */
+sys_cv_status_t SYS_CV_Init(uint32_t tick_hz, sys_cv_tick_cb tick_cb);
+
+/**
+  * @brief  Write all analog outputs. New values are applied on the same
+  *         PWM period for all channels. Safe to call from interrupt context,
+  *         runs from RAM.
+  * @param  codes array of SYS_CV_ANALOG_NUM output codes
+  * @retval None
+  */
+void SYS_CV_WriteAnalog(const uint16_t *codes);
+
+/**
+  * @brief  Write all gate outputs with a single port access, runs from RAM
+  * @param  mask bit n set drives gate output n high
+  * @retval None
+  */
+void SYS_CV_WriteGates(uint8_t mask);
+
+/**
+  * @brief  Init compare timer used to schedule events between output ticks
+  * @param  compare_cb callback executed when a scheduled event expires
+  * @retval Operation status
+  */
+sys_cv_status_t SYS_CV_CompareInit(sys_cv_compare_cb compare_cb);
+
+/**
+  * @brief  Schedule a compare event, replaces any pending one
+  * @param  delay_us microseconds from now, up to 65535, 0 fires right away
+  * @retval None
+  */
+void SYS_CV_CompareStart(uint32_t delay_us);
+
+/**
+  * @brief  Cancel pending compare event
+  * @retval None
+  */
+void SYS_CV_CompareStop(void);
+
+/**
+  * @brief  Check and clear an elapsed output tick, used while interrupts are
+  *         masked. Runs from RAM.
+  * @retval true if an output tick elapsed
+  */
+bool SYS_CV_TickPoll(void);
+
+/**
+  * @brief  Output tick interrupt handler
+  * @retval None
+  */
+void SYS_CV_TickIRQHandler(void);
+
+/**
+  * @brief  Compare timer interrupt handler
+  * @retval None
+  */
+void SYS_CV_CompareIRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYS_CV_H */
+
+/*EOF*/
@@ -0,0 +1,108 @@
+/**
+ * @file sys_flash.h
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief System support packet to store data on internal flash pages.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __SYS_FLASH_H
+#define __SYS_FLASH_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Exported includes --------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ---------------------------------------------------------*/
+
+/** Erase unit */
+#define SYS_FLASH_PAGE_SIZE     2048U
+
+/** Write unit, offsets and lengths must be multiple of it */
+#define SYS_FLASH_WRITE_SIZE    8U
+
+/** Value of erased bytes */
+#define SYS_FLASH_ERASED        0xFFU
+
+/* Exported types -----------------------------------------------------------*/
+
+/** Operation status */
+typedef enum
+{
+    SYS_FLASH_STATUS_ERROR =    0U,
+    SYS_FLASH_STATUS_OK =       1U,
+    SYS_FLASH_STATUS_NODEF =    0xFFU,
+} sys_flash_status_t;
+
+/** Flash areas reserved on linker script */
+typedef enum
+{
+    SYS_FLASH_AREA_CAL = 0U,    /**< Output calibration */
+    SYS_FLASH_AREA_PRESET,      /**< Preset store */
+    SYS_FLASH_AREA_NUM,
+} sys_flash_area_t;
+
+/** Callback executed while an erase is in progress with interrupts masked.
+ *  It must run from RAM and only access RAM and peripherals */
+typedef void (* sys_flash_erase_cb)(void);
+
+/* Exported macro -----------------------------------------------------------*/
+/* Exported functions prototypes --------------------------------------------*/
+
+/**
+  * @brief  Get memory mapped address of an area, data is read directly
+  * @param  area flash area
+  * @retval Area start address
+  */
+const void *SYS_FLASH_GetAddr(sys_flash_area_t area);
+
+/**
+  * @brief  Get size of an area
+  * @param  area flash area
+  * @retval Area size in bytes, multiple of SYS_FLASH_PAGE_SIZE
+  */
+uint32_t SYS_FLASH_GetSize(sys_flash_area_t area);
+
+/**
+  * @brief  Set callback executed while a page erase is in progress
+  * @param  erase_cb RAM resident callback, NULL for none
+  * @retval None
+  */
+void SYS_FLASH_SetEraseCb(sys_flash_erase_cb erase_cb);
+
+/**
+  * @brief  Erase a page of an area. Flash is not readable during the erase,
+  *         the wait runs from RAM with interrupts masked and only the erase
+  *         callback is executed until it completes.
+  * @param  area flash area
+  * @param  offset any offset inside the page to erase
+  * @retval Operation status
+  */
+sys_flash_status_t SYS_FLASH_Erase(sys_flash_area_t area, uint32_t offset);
+
+/**
+  * @brief  Program erased flash with double word writes. Interrupts are
+  *         only delayed by the programming time of a double word.
+  * @param  area flash area
+  * @param  offset area offset, multiple of SYS_FLASH_WRITE_SIZE
+  * @param  data data to write
+  * @param  len data length, multiple of SYS_FLASH_WRITE_SIZE
+  * @retval Operation status
+  */
+sys_flash_status_t SYS_FLASH_Write(sys_flash_area_t area, uint32_t offset, const void *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYS_FLASH_H */
+
+/*EOF*/
@@ -22,6 +22,16 @@ extern "C"
 #include <stdint.h>
 
 /* Exported defines ---------------------------------------------------------*/
+
+/** Place a function on .ramfunc, copied to RAM at startup, so it runs with no
+    flash wait states. Callers in flash reach it with a long call, calls out of
+    it go through linker veneers. Host builds run everything from RAM */
+#ifdef SYS_HOST
+#define SYS_RAM_FUNC
+#else
+#define SYS_RAM_FUNC    __attribute__((section(".ramfunc"), long_call, noinline))
+#endif
+
 /* Exported macro -----------------------------------------------------------*/
 /* Exported functions prototypes --------------------------------------------*/
 
@@ -37,6 +47,26 @@ void SYS_Init(void);
  */
 void SYS_SystemClockConfig(void);
 
+/**
+ * @brief Get microseconds since HAL init from HAL tick and SysTick counter.
+ *        Only valid before the scheduler starts, while the HAL tick runs
+ * @retval time in microseconds
+ */
+uint32_t SYS_MCU_GetTickUs(void);
+
+/**
+ * @brief Get main stack never used since reset, from the pattern painted by
+ *        the startup code
+ * @retval free bytes at the bottom of the main stack
+ */
+uint32_t SYS_MCU_GetStackFree(void);
+
+/**
+ * @brief Get main stack size reserved by the linker script
+ * @retval size in bytes
+ */
+uint32_t SYS_MCU_GetStackSize(void);
+
 /**
  * @brief Force system reset
  * @retval None
@@ -35,6 +35,12 @@ extern "C"
  */
 void SYS_RTOS_ClockConfig(void);
 
+/**
+ * @brief Get microseconds elapsed since time base start, TIM3 based
+ * @retval time in microseconds, wraps every 71 minutes. Runs from RAM
+ */
+uint32_t SYS_RTOS_GetTimeUs(void);
+
 #ifdef __cplusplus
 }
 #endif
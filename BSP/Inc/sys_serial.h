@@ -29,6 +29,7 @@ extern "C"
 typedef enum
 {
     SYS_SERIAL_0 = 0U,
+    SYS_SERIAL_1 = 1U,
     SYS_SERIAL_NODEF = 0xFFU,
 } sys_serial_port_t;
 
@@ -99,6 +100,13 @@ uint16_t SYS_SERIAL_Read(sys_serial_port_t dev, uint8_t *pdata, uint16_t max_len
   */
 uint16_t SYS_SERIAL_GetReadCount(sys_serial_port_t dev);
 
+/**
+  * @brief  Get reception time of the last byte stored on serial buffer
+  * @param  dev serial interface number to use
+  * @retval time in microseconds, SYS_RTOS_GetTimeUs time base
+  */
+uint32_t SYS_SERIAL_GetRxTime(sys_serial_port_t dev);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,148 @@
+/**
+ * @file sys_trace.h
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief Scheduler and interrupt event trace on a circular RAM buffer.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Define to prevent recursive inclusion ------------------------------------*/
+#ifndef __SYS_TRACE_H
+#define __SYS_TRACE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Exported includes --------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported defines ---------------------------------------------------------*/
+
+/** Events kept on the buffer, power of 2 */
+#define SYS_TRACE_EVENT_NUM     256U
+
+/** Peripheral interrupts with duration statistics */
+#define SYS_TRACE_IRQ_NUM       32U
+
+/* Exported types -----------------------------------------------------------*/
+
+/** Event types, stored on dumps so values must not change */
+typedef enum
+{
+    SYS_TRACE_TASK_IN =         1U,     /**< Task switched in, id is task number */
+    SYS_TRACE_TASK_OUT =        2U,     /**< Task switched out, id is task number */
+    SYS_TRACE_ISR =             3U,     /**< Interrupt entry, arg is exception number */
+    SYS_TRACE_QUEUE_SEND =      4U,     /**< Queue send or semaphore give, arg is queue address */
+    SYS_TRACE_QUEUE_RECEIVE =   5U,     /**< Queue receive or semaphore take, arg is queue address */
+    SYS_TRACE_NOTIFY_ISR =      6U,     /**< Task notified from interrupt, id is task number */
+    SYS_TRACE_NOTIFY_WAIT =     7U,     /**< Task waits for a notification, id is task number */
+    SYS_TRACE_MARK =            8U,     /**< User mark, id and arg set by caller */
+} sys_trace_type_t;
+
+/** Trace event, 8 bytes, dumped as is in little endian */
+typedef struct sys_trace_event
+{
+    uint32_t time_us;       /**< Time base timestamp */
+    uint8_t type;           /**< Event type, sys_trace_type_t */
+    uint8_t id;             /**< Task number or mark id */
+    uint16_t arg;           /**< Event argument */
+} sys_trace_event_t;
+
+/** Interrupt duration from entry to exit in core cycles, preemption by higher
+ *  priority interrupts included */
+typedef struct sys_trace_isr
+{
+    uint32_t count;         /**< Handler runs */
+    uint32_t min_cycles;    /**< Shortest run */
+    uint32_t max_cycles;    /**< Longest run */
+    uint64_t sum_cycles;    /**< Total of all runs */
+} sys_trace_isr_t;
+
+/* Exported macro -----------------------------------------------------------*/
+/* Exported functions prototypes --------------------------------------------*/
+
+/**
+  * @brief  Record an event if trace is running. Safe to call from interrupt
+  *         and kernel context, runs from RAM.
+  * @param  type event type
+  * @param  id task number or mark id
+  * @param  arg event argument
+  * @retval None
+  */
+void SYS_TRACE_Record(uint8_t type, uint8_t id, uint16_t arg);
+
+/**
+  * @brief  Record entry of the interrupt being served, call first thing on
+  *         the handler. Runs from RAM.
+  * @retval None
+  */
+void SYS_TRACE_IsrEnter(void);
+
+/**
+  * @brief  Add duration of the interrupt being served to its statistics,
+  *         call last thing on the handler. Runs from RAM.
+  * @retval None
+  */
+void SYS_TRACE_IsrExit(void);
+
+/**
+  * @brief  Get duration statistics of a peripheral interrupt
+  * @param  irq interrupt number, up to SYS_TRACE_IRQ_NUM
+  * @param  stats where to copy statistics
+  * @retval true if interrupt has been served since last reset
+  */
+bool SYS_TRACE_GetIsr(uint8_t irq, sys_trace_isr_t *stats);
+
+/**
+  * @brief  Clear duration statistics of all interrupts
+  * @retval None
+  */
+void SYS_TRACE_ResetIsr(void);
+
+/**
+  * @brief  Clear buffer and start recording. Trace is stopped from reset.
+  * @retval None
+  */
+void SYS_TRACE_Start(void);
+
+/**
+  * @brief  Stop recording, buffer is kept to be read
+  * @retval None
+  */
+void SYS_TRACE_Stop(void);
+
+/**
+  * @brief  Get number of events on the buffer
+  * @retval recorded events, up to SYS_TRACE_EVENT_NUM
+  */
+uint32_t SYS_TRACE_GetCount(void);
+
+/**
+  * @brief  Get number of events overwritten since last start
+  * @retval dropped events
+  */
+uint32_t SYS_TRACE_GetDropped(void);
+
+/**
+  * @brief  Copy events from the buffer, oldest first. Stop trace before
+  *         reading to get a consistent copy.
+  * @param  index first event to copy, 0 is the oldest one
+  * @param  events where to copy events
+  * @param  num max events to copy
+  * @retval copied events
+  */
+uint32_t SYS_TRACE_Read(uint32_t index, sys_trace_event_t *events, uint32_t num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYS_TRACE_H */
+
+/*EOF*/
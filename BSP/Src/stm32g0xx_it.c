@@ -19,6 +19,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32g0xx_hal.h"
 #include "stm32g0xx_it.h"
+#include "sys_cv.h"
+#include "sys_mcu.h"
+#include "sys_trace.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* Private typedef -----------------------------------------------------------*/
@@ -32,6 +35,8 @@ extern TIM_HandleTypeDef htim3;
 extern DMA_HandleTypeDef hdma_usart2_rx;
 extern DMA_HandleTypeDef hdma_usart2_tx;
 extern UART_HandleTypeDef huart2;
+extern DMA_HandleTypeDef hdma_usart1_rx;
+extern UART_HandleTypeDef huart1;
 
 /******************************************************************************/
 /*           Cortex-M0+ Processor Interruption and Exception Handlers          */
@@ -94,17 +99,22 @@ void SysTick_Handler(void)
 /**
   * @brief This function handles DMA1 channel 1 interrupt.
   */
-void DMA1_Channel1_IRQHandler(void)
+SYS_RAM_FUNC void DMA1_Channel1_IRQHandler(void)
 {
+  SYS_TRACE_IsrEnter();
   HAL_DMA_IRQHandler(&hdma_usart2_rx);
+  SYS_TRACE_IsrExit();
 }
 
 /**
   * @brief This function handles DMA1 channel 2 and channel 3 interrupts.
   */
-void DMA1_Channel2_3_IRQHandler(void)
+SYS_RAM_FUNC void DMA1_Channel2_3_IRQHandler(void)
 {
+  SYS_TRACE_IsrEnter();
   HAL_DMA_IRQHandler(&hdma_usart2_tx);
+  HAL_DMA_IRQHandler(&hdma_usart1_rx);
+  SYS_TRACE_IsrExit();
 }
 
 /**
@@ -112,14 +122,57 @@ void DMA1_Channel2_3_IRQHandler(void)
   */
 void TIM3_IRQHandler(void)
 {
+  SYS_TRACE_IsrEnter();
   HAL_TIM_IRQHandler(&htim3);
+  SYS_TRACE_IsrExit();
+}
+
+/**
+  * @brief This function handles TIM6 global interrupt, output tick.
+  */
+SYS_RAM_FUNC void TIM6_IRQHandler(void)
+{
+  SYS_TRACE_IsrEnter();
+  SYS_CV_TickIRQHandler();
+  SYS_TRACE_IsrExit();
+}
+
+/**
+  * @brief This function handles TIM17 global interrupt, scheduled output events.
+  */
+SYS_RAM_FUNC void TIM17_IRQHandler(void)
+{
+  SYS_TRACE_IsrEnter();
+  SYS_CV_CompareIRQHandler();
+  SYS_TRACE_IsrExit();
+}
+
+/**
+  * @brief This function handles USART1 global interrupt / USART1 wake-up interrupt through EXTI line 25.
+  */
+SYS_RAM_FUNC void USART1_IRQHandler(void)
+{
+  SYS_TRACE_IsrEnter();
+  HAL_UART_IRQHandler(&huart1);
+
+  /* Handle idle event on usart */
+  if (__HAL_UART_GET_IT(&huart1, UART_IT_IDLE))
+  {
+    __HAL_UART_CLEAR_IT(&huart1, UART_CLEAR_IDLEF);
+
+    /* Abort and retrigger reception */
+    HAL_UART_AbortReceive_IT(&huart1);
+  }
+
+  SYS_TRACE_IsrExit();
 }
 
 /**
   * @brief This function handles USART2 global interrupt / USART2 wake-up interrupt through EXTI line 26.
   */
-void USART2_IRQHandler(void)
+SYS_RAM_FUNC void USART2_IRQHandler(void)
 {
+  SYS_TRACE_IsrEnter();
   HAL_UART_IRQHandler(&huart2);
 
   /* Handle idle event on usart */
@@ -130,6 +183,8 @@ void USART2_IRQHandler(void)
     /* Abort and retrigger reception */
     HAL_UART_AbortReceive_IT(&huart2);
   }
+
+  SYS_TRACE_IsrExit();
 }
 
 /*EOF*/
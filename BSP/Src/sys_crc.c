@@ -0,0 +1,64 @@
+/**
+ * @file sys_crc.c
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief System support packet for CRC-32 computation on the CRC unit.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Private includes --------------------------------------------------------*/
+#include "sys_crc.h"
+#include "stm32g0xx_hal.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private macro -----------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private defines ---------------------------------------------------------*/
+/* Private variable ---------------------------------------------------------*/
+
+static CRC_HandleTypeDef hcrc;
+
+/* Private functions prototypes --------------------------------------------*/
+/* Private functions definition --------------------------------------------*/
+/* Public function definition ----------------------------------------------*/
+
+sys_crc_status_t SYS_CRC_Init(void)
+{
+    sys_crc_status_t eRetval = SYS_CRC_STATUS_ERROR;
+
+    /* Reflected input and output with all ones init, final inversion is done
+       on the result */
+    hcrc.Instance = CRC;
+    hcrc.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_ENABLE;
+    hcrc.Init.DefaultInitValueUse = DEFAULT_INIT_VALUE_ENABLE;
+    hcrc.Init.InputDataInversionMode = CRC_INPUTDATA_INVERSION_BYTE;
+    hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_ENABLE;
+    hcrc.InputDataFormat = CRC_INPUTDATA_FORMAT_BYTES;
+
+    if (HAL_CRC_Init(&hcrc) == HAL_OK)
+    {
+        eRetval = SYS_CRC_STATUS_OK;
+    }
+
+    return eRetval;
+}
+
+uint32_t SYS_CRC_Calc(const uint8_t *data, uint32_t len)
+{
+    USER_ASSERT(data != NULL);
+
+    /* Byte input format, the buffer is read a byte at a time */
+    return ~HAL_CRC_Calculate(&hcrc, (uint32_t *)data, len);
+}
+
+/*EOF*/
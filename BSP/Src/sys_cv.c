@@ -0,0 +1,304 @@
+/**
+ * @file sys_cv.c
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief System support packet to handle analog and gate outputs.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Private includes --------------------------------------------------------*/
+#include "sys_cv.h"
+#include "sys_mcu.h"
+#include "stm32g0xx_hal.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private macro -----------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private defines ---------------------------------------------------------*/
+
+/* PWM resolution used on analog outputs, 12 bits at 15.6 kHz */
+#define CV_PWM_BITS         (12U)
+#define CV_PWM_PERIOD       ((1UL << CV_PWM_BITS) - 1U)
+
+/* Counter clock of the output tick timer */
+#define CV_TICK_CLK_HZ      (1000000UL)
+
+/* Gate outputs port and pins, gate n is on pin n */
+#define CV_GATE_PORT        GPIOC
+#define CV_GATE_PINS        (GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3)
+
+/* Private variable ---------------------------------------------------------*/
+
+/* Analog outputs timer */
+TIM_HandleTypeDef htim1;
+
+/* Output tick timer */
+TIM_HandleTypeDef htim6;
+
+/* Compare event timer */
+TIM_HandleTypeDef htim17;
+
+static sys_cv_tick_cb cv_tick_cb = NULL;
+static sys_cv_compare_cb cv_compare_cb = NULL;
+
+/* Private functions prototypes --------------------------------------------*/
+
+/**
+  * @brief TIM1 PWM Initialization Function
+  * @retval None
+  */
+static void BSP_TIM1_PWM_Init(void);
+
+/**
+  * @brief TIM6 tick Initialization Function
+  * @param tick_hz tick frequency
+  * @retval None
+  */
+static void BSP_TIM6_Tick_Init(uint32_t tick_hz);
+
+/**
+  * @brief Gate GPIO Initialization Function
+  * @retval None
+  */
+static void BSP_Gate_Init(void);
+
+/* Private functions definition --------------------------------------------*/
+
+static void BSP_TIM1_PWM_Init(void)
+{
+    TIM_OC_InitTypeDef sConfigOC = {0};
+    TIM_MasterConfigTypeDef sMasterConfig = {0};
+    static const uint32_t u32Channels[SYS_CV_ANALOG_NUM] = {
+        TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4
+    };
+
+    htim1.Instance = TIM1;
+    htim1.Init.Prescaler = 0;
+    htim1.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim1.Init.Period = CV_PWM_PERIOD;
+    htim1.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    htim1.Init.RepetitionCounter = 0;
+    htim1.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    if (HAL_TIM_PWM_Init(&htim1) != HAL_OK)
+    {
+        USER_ASSERT(0);
+    }
+
+    sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+    sMasterConfig.MasterOutputTrigger2 = TIM_TRGO2_RESET;
+    sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    if (HAL_TIMEx_MasterConfigSynchronization(&htim1, &sMasterConfig) != HAL_OK)
+    {
+        USER_ASSERT(0);
+    }
+
+    /* Preload keeps all channels switching on the same update event */
+    sConfigOC.OCMode = TIM_OCMODE_PWM1;
+    sConfigOC.Pulse = 0;
+    sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+    sConfigOC.OCNPolarity = TIM_OCNPOLARITY_HIGH;
+    sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+    sConfigOC.OCIdleState = TIM_OCIDLESTATE_RESET;
+    sConfigOC.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+
+    for (uint32_t i_ch = 0; i_ch < SYS_CV_ANALOG_NUM; i_ch++)
+    {
+        if (HAL_TIM_PWM_ConfigChannel(&htim1, &sConfigOC, u32Channels[i_ch]) != HAL_OK)
+        {
+            USER_ASSERT(0);
+        }
+    }
+
+    for (uint32_t i_ch = 0; i_ch < SYS_CV_ANALOG_NUM; i_ch++)
+    {
+        if (HAL_TIM_PWM_Start(&htim1, u32Channels[i_ch]) != HAL_OK)
+        {
+            USER_ASSERT(0);
+        }
+    }
+}
+
+static void BSP_TIM6_Tick_Init(uint32_t tick_hz)
+{
+    htim6.Instance = TIM6;
+    htim6.Init.Prescaler = (SystemCoreClock / CV_TICK_CLK_HZ) - 1U;
+    htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim6.Init.Period = (CV_TICK_CLK_HZ / tick_hz) - 1U;
+    htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    if (HAL_TIM_Base_Init(&htim6) != HAL_OK)
+    {
+        USER_ASSERT(0);
+    }
+
+    if (HAL_TIM_Base_Start_IT(&htim6) != HAL_OK)
+    {
+        USER_ASSERT(0);
+    }
+}
+
+static void BSP_Gate_Init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    __HAL_RCC_GPIOC_CLK_ENABLE();
+
+    HAL_GPIO_WritePin(CV_GATE_PORT, CV_GATE_PINS, GPIO_PIN_RESET);
+
+    GPIO_InitStruct.Pin = CV_GATE_PINS;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(CV_GATE_PORT, &GPIO_InitStruct);
+}
+
+/* Public function definition ----------------------------------------------*/
+
+sys_cv_status_t SYS_CV_Init(uint32_t tick_hz, sys_cv_tick_cb tick_cb)
+{
+    USER_ASSERT((tick_hz != 0U) && (tick_hz <= CV_TICK_CLK_HZ));
+
+    sys_cv_status_t eRetval = SYS_CV_STATUS_ERROR;
+
+    if ((tick_hz != 0U) && (tick_hz <= CV_TICK_CLK_HZ))
+    {
+        BSP_Gate_Init();
+        BSP_TIM1_PWM_Init();
+
+        cv_tick_cb = tick_cb;
+        BSP_TIM6_Tick_Init(tick_hz);
+
+        eRetval = SYS_CV_STATUS_OK;
+    }
+
+    return eRetval;
+}
+
+/* Output latch runs from RAM, it is also used while flash is erased */
+SYS_RAM_FUNC void SYS_CV_WriteAnalog(const uint16_t *codes)
+{
+    USER_ASSERT(codes != NULL);
+
+    /* Hold update event so preloaded values never load half written */
+    TIM1->CR1 |= TIM_CR1_UDIS;
+    TIM1->CCR1 = (uint32_t)codes[0] >> (16U - CV_PWM_BITS);
+    TIM1->CCR2 = (uint32_t)codes[1] >> (16U - CV_PWM_BITS);
+    TIM1->CCR3 = (uint32_t)codes[2] >> (16U - CV_PWM_BITS);
+    TIM1->CCR4 = (uint32_t)codes[3] >> (16U - CV_PWM_BITS);
+    TIM1->CR1 &= ~TIM_CR1_UDIS;
+}
+
+SYS_RAM_FUNC void SYS_CV_WriteGates(uint8_t mask)
+{
+    uint32_t u32Set = (uint32_t)mask & 0x0FU;
+    uint32_t u32Reset = (~u32Set) & 0x0FU;
+
+    /* Gate n is mapped to pin n, set and reset on a single BSRR write */
+    CV_GATE_PORT->BSRR = u32Set | (u32Reset << 16U);
+}
+
+sys_cv_status_t SYS_CV_CompareInit(sys_cv_compare_cb compare_cb)
+{
+    sys_cv_status_t eRetval = SYS_CV_STATUS_ERROR;
+
+    /* Free running counter at 1 MHz, events on channel 1 compare */
+    htim17.Instance = TIM17;
+    htim17.Init.Prescaler = (SystemCoreClock / CV_TICK_CLK_HZ) - 1U;
+    htim17.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim17.Init.Period = 0xFFFFU;
+    htim17.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    htim17.Init.RepetitionCounter = 0;
+    htim17.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+
+    if (HAL_TIM_Base_Init(&htim17) == HAL_OK)
+    {
+        cv_compare_cb = compare_cb;
+        __HAL_TIM_ENABLE(&htim17);
+        eRetval = SYS_CV_STATUS_OK;
+    }
+    else
+    {
+        USER_ASSERT(0);
+    }
+
+    return eRetval;
+}
+
+void SYS_CV_CompareStart(uint32_t delay_us)
+{
+    uint16_t u16Start;
+
+    if (delay_us > 0xFFFFU)
+    {
+        delay_us = 0xFFFFU;
+    }
+
+    /* Flag goes first, a match right after the write is kept */
+    __HAL_TIM_CLEAR_FLAG(&htim17, TIM_FLAG_CC1);
+    u16Start = (uint16_t)TIM17->CNT;
+    TIM17->CCR1 = (u16Start + delay_us) & 0xFFFFU;
+    __HAL_TIM_ENABLE_IT(&htim17, TIM_IT_CC1);
+
+    /* Target already passed while it was written, raise the match by software
+     * instead of waiting for the counter to wrap */
+    if ((uint16_t)((uint16_t)TIM17->CNT - u16Start) >= delay_us)
+    {
+        TIM17->EGR = TIM_EGR_CC1G;
+    }
+}
+
+SYS_RAM_FUNC void SYS_CV_CompareStop(void)
+{
+    __HAL_TIM_DISABLE_IT(&htim17, TIM_IT_CC1);
+    __HAL_TIM_CLEAR_FLAG(&htim17, TIM_FLAG_CC1);
+}
+
+SYS_RAM_FUNC void SYS_CV_CompareIRQHandler(void)
+{
+    if (__HAL_TIM_GET_FLAG(&htim17, TIM_FLAG_CC1) != RESET)
+    {
+        /* One shot event */
+        SYS_CV_CompareStop();
+
+        if (cv_compare_cb != NULL)
+        {
+            cv_compare_cb();
+        }
+    }
+}
+
+SYS_RAM_FUNC bool SYS_CV_TickPoll(void)
+{
+    bool bRetval = ((TIM6->SR & TIM_SR_UIF) != 0U);
+
+    if (bRetval)
+    {
+        TIM6->SR = ~(uint32_t)TIM_SR_UIF;
+    }
+
+    return bRetval;
+}
+
+SYS_RAM_FUNC void SYS_CV_TickIRQHandler(void)
+{
+    if (__HAL_TIM_GET_FLAG(&htim6, TIM_FLAG_UPDATE) != RESET)
+    {
+        __HAL_TIM_CLEAR_FLAG(&htim6, TIM_FLAG_UPDATE);
+
+        if (cv_tick_cb != NULL)
+        {
+            cv_tick_cb();
+        }
+    }
+}
+
+/*EOF*/
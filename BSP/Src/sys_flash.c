@@ -0,0 +1,175 @@
+/**
+ * @file sys_flash.c
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief System support packet to store data on internal flash pages.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Private includes --------------------------------------------------------*/
+#include <string.h>
+#include "sys_flash.h"
+#include "sys_mcu.h"
+#include "stm32g0xx_hal.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private macro -----------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private defines ---------------------------------------------------------*/
+
+/* Error flags of a page erase */
+#define FLASH_ERASE_ERRORS  (FLASH_SR_OPERR | FLASH_SR_PROGERR | FLASH_SR_WRPERR | FLASH_SR_PGAERR | \
+                             FLASH_SR_SIZERR | FLASH_SR_PGSERR | FLASH_SR_MISERR | FLASH_SR_FASTERR)
+
+/* Private variable ---------------------------------------------------------*/
+
+/* Areas reserved on linker script */
+extern uint8_t _scal[];
+extern uint8_t _ecal[];
+extern uint8_t _spreset[];
+extern uint8_t _epreset[];
+
+static uint8_t * const flash_area_start[SYS_FLASH_AREA_NUM] = {
+    _scal,
+    _spreset,
+};
+
+static uint8_t * const flash_area_end[SYS_FLASH_AREA_NUM] = {
+    _ecal,
+    _epreset,
+};
+
+static sys_flash_erase_cb flash_erase_cb = NULL;
+
+/* Private functions prototypes --------------------------------------------*/
+
+/**
+  * @brief  Erase a page, runs from RAM as flash is not readable meanwhile
+  * @param  page page number
+  * @retval Error flags
+  */
+static SYS_RAM_FUNC uint32_t BSP_FLASH_ErasePage(uint32_t page);
+
+/* Private functions definition --------------------------------------------*/
+
+static uint32_t BSP_FLASH_ErasePage(uint32_t page)
+{
+    uint32_t u32Primask = __get_PRIMASK();
+
+    /* An interrupt would fetch its vector from flash and stall the core */
+    __disable_irq();
+
+    FLASH->CR = (FLASH->CR & ~FLASH_CR_PNB) | (page << FLASH_CR_PNB_Pos) | FLASH_CR_PER;
+    FLASH->CR |= FLASH_CR_STRT;
+
+    while ((FLASH->SR & FLASH_SR_BSY1) != 0U)
+    {
+        if (flash_erase_cb != NULL)
+        {
+            flash_erase_cb();
+        }
+    }
+
+    FLASH->CR &= ~FLASH_CR_PER;
+
+    __set_PRIMASK(u32Primask);
+
+    return FLASH->SR & FLASH_ERASE_ERRORS;
+}
+
+/* Public functions definition ---------------------------------------------*/
+
+const void *SYS_FLASH_GetAddr(sys_flash_area_t area)
+{
+    USER_ASSERT(area < SYS_FLASH_AREA_NUM);
+
+    return flash_area_start[area];
+}
+
+uint32_t SYS_FLASH_GetSize(sys_flash_area_t area)
+{
+    USER_ASSERT(area < SYS_FLASH_AREA_NUM);
+
+    return (uint32_t)(flash_area_end[area] - flash_area_start[area]);
+}
+
+void SYS_FLASH_SetEraseCb(sys_flash_erase_cb erase_cb)
+{
+    flash_erase_cb = erase_cb;
+}
+
+sys_flash_status_t SYS_FLASH_Erase(sys_flash_area_t area, uint32_t offset)
+{
+    sys_flash_status_t eRetval = SYS_FLASH_STATUS_ERROR;
+
+    if ((area < SYS_FLASH_AREA_NUM) && (offset < SYS_FLASH_GetSize(area)))
+    {
+        uint32_t u32Addr = (uint32_t)(uintptr_t)flash_area_start[area] + offset;
+
+        HAL_FLASH_Unlock();
+        __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+        if ((FLASH_WaitForLastOperation(FLASH_TIMEOUT_VALUE) == HAL_OK) &&
+            (BSP_FLASH_ErasePage((u32Addr - FLASH_BASE) / FLASH_PAGE_SIZE) == 0U))
+        {
+            eRetval = SYS_FLASH_STATUS_OK;
+        }
+
+        /* Drop instructions cached from the erased page */
+        if ((FLASH->ACR & FLASH_ACR_ICEN) != 0U)
+        {
+            __HAL_FLASH_INSTRUCTION_CACHE_DISABLE();
+            __HAL_FLASH_INSTRUCTION_CACHE_RESET();
+            __HAL_FLASH_INSTRUCTION_CACHE_ENABLE();
+        }
+        HAL_FLASH_Lock();
+    }
+
+    return eRetval;
+}
+
+sys_flash_status_t SYS_FLASH_Write(sys_flash_area_t area, uint32_t offset, const void *data, uint32_t len)
+{
+    USER_ASSERT(data != NULL);
+
+    sys_flash_status_t eRetval = SYS_FLASH_STATUS_ERROR;
+
+    if ((area < SYS_FLASH_AREA_NUM) &&
+        ((offset % SYS_FLASH_WRITE_SIZE) == 0U) &&
+        ((len % SYS_FLASH_WRITE_SIZE) == 0U) &&
+        ((offset + len) <= SYS_FLASH_GetSize(area)))
+    {
+        const uint8_t *pu8Data = (const uint8_t *)data;
+        uint32_t u32Addr = (uint32_t)(uintptr_t)flash_area_start[area] + offset;
+
+        eRetval = SYS_FLASH_STATUS_OK;
+
+        HAL_FLASH_Unlock();
+        __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+        for (uint32_t i = 0; (i < len) && (eRetval == SYS_FLASH_STATUS_OK); i += SYS_FLASH_WRITE_SIZE)
+        {
+            uint64_t u64Word;
+
+            /* Source may be unaligned */
+            memcpy(&u64Word, &pu8Data[i], sizeof(u64Word));
+            if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, u32Addr + i, u64Word) != HAL_OK)
+            {
+                eRetval = SYS_FLASH_STATUS_ERROR;
+            }
+        }
+        HAL_FLASH_Lock();
+    }
+
+    return eRetval;
+}
+
+/*EOF*/
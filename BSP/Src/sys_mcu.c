@@ -18,6 +18,10 @@
 #endif
 
 /* Private variables --------------------------------------------------------*/
+
+/** Main stack limits, defined in linker script */
+extern uint32_t _sstack;
+extern uint32_t _estack;
 /* Private macro -----------------------------------------------------------*/
 #ifdef USE_USER_ASSERT
 #define USER_ASSERT(A)      ERR_ASSERT(A)
@@ -25,6 +29,11 @@
 #define USER_ASSERT(A)      (void)(A)
 #endif
 
+/* Private defines ----------------------------------------------------------*/
+
+/* Pattern written on the main stack by the startup code */
+#define MCU_STACK_PAINT     (0xA5A5A5A5UL)
+
 /* Private declarations -----------------------------------------------------*/
 
 #ifdef USE_USER_ASSERT
@@ -116,6 +125,39 @@ void SYS_SystemClockConfig(void)
   }
 }
 
+uint32_t SYS_MCU_GetTickUs(void)
+{
+  uint32_t u32Ms;
+  uint32_t u32Count;
+
+  /* Tick may increase between both reads, retry until consistent */
+  do
+  {
+    u32Ms = HAL_GetTick();
+    u32Count = SysTick->LOAD - SysTick->VAL;
+  } while (u32Ms != HAL_GetTick());
+
+  return (u32Ms * 1000U) + (u32Count / (SystemCoreClock / 1000000U));
+}
+
+uint32_t SYS_MCU_GetStackFree(void)
+{
+  const uint32_t *pu32Word = &_sstack;
+
+  /* Stack grows down, first word changed is the deepest one used */
+  while ((pu32Word < &_estack) && (*pu32Word == MCU_STACK_PAINT))
+  {
+    pu32Word++;
+  }
+
+  return (uint32_t)((uintptr_t)pu32Word - (uintptr_t)&_sstack);
+}
+
+uint32_t SYS_MCU_GetStackSize(void)
+{
+  return (uint32_t)((uintptr_t)&_estack - (uintptr_t)&_sstack);
+}
+
 void SYS_Reset(void)
 {
   (void)HAL_NVIC_SystemReset();
@@ -10,7 +10,9 @@
  */
 
 /* Includes -----------------------------------------------------------------*/
+#include <stdbool.h>
 #include "sys_rtos.h"
+#include "sys_mcu.h"
 #include "stm32g0xx_hal.h"
 #ifdef USE_USER_ASSERT
 #include "user_error.h"
@@ -21,6 +23,15 @@
 /** Control timer var to handle RTOS clock */
 TIM_HandleTypeDef htim3;
 
+/** Upper 16 bits of microsecond time base */
+static volatile uint32_t u32TimeHigh = 0U;
+
+/** Kernel task memory, no heap is used */
+static StaticTask_t xIdleTcb;
+static StackType_t xIdleStack[configMINIMAL_STACK_SIZE];
+static StaticTask_t xTimerTcb;
+static StackType_t xTimerStack[configTIMER_TASK_STACK_DEPTH];
+
 /* Private macro -----------------------------------------------------------*/
 #ifdef USE_USER_ASSERT
 #define USER_ASSERT(A)      ERR_ASSERT(A)
@@ -28,6 +39,11 @@ TIM_HandleTypeDef htim3;
 #define USER_ASSERT(A)      (void)(A)
 #endif
 
+/* Private defines ----------------------------------------------------------*/
+
+/* Time base counter clock */
+#define RTOS_TIME_CLK_HZ    (1000000UL)
+
 /* Private declarations -----------------------------------------------------*/
 /* Private definitions ------------------------------------------------------*/
 
@@ -36,11 +52,37 @@ void vApplicationTickHook(void)
   HAL_IncTick();
 }
 
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+  if (htim->Instance == TIM3)
+  {
+    u32TimeHigh++;
+  }
+}
+
 void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
 {
   ERR_ASSERT(0U);
 }
 
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+  *ppxIdleTaskTCBBuffer = &xIdleTcb;
+  *ppxIdleTaskStackBuffer = xIdleStack;
+  *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+  *ppxTimerTaskTCBBuffer = &xTimerTcb;
+  *ppxTimerTaskStackBuffer = xTimerStack;
+  *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
 /* Public functions ---------------------------------------------------------*/
 
 void SYS_RTOS_ClockConfig(void)
@@ -49,7 +91,7 @@ void SYS_RTOS_ClockConfig(void)
   TIM_MasterConfigTypeDef sMasterConfig = {0};
 
   htim3.Instance = TIM3;
-  htim3.Init.Prescaler = 0;
+  htim3.Init.Prescaler = (SystemCoreClock / RTOS_TIME_CLK_HZ) - 1U;
   htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
   htim3.Init.Period = 65535;
   htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
@@ -69,6 +111,33 @@ void SYS_RTOS_ClockConfig(void)
   {
     USER_ASSERT(0);
   }
+  if (HAL_TIM_Base_Start_IT(&htim3) != HAL_OK)
+  {
+    USER_ASSERT(0);
+  }
+}
+
+SYS_RAM_FUNC uint32_t SYS_RTOS_GetTimeUs(void)
+{
+  uint32_t u32High;
+  uint32_t u32Low;
+  bool bPending;
+
+  do
+  {
+    u32High = u32TimeHigh;
+    u32Low = TIM3->CNT;
+
+    /* Overflow not served yet, caller may be masking the timer irq */
+    bPending = ((TIM3->SR & TIM_SR_UIF) != 0U) && (u32Low < 0x8000U);
+  } while (u32High != u32TimeHigh);
+
+  if (bPending)
+  {
+    u32High++;
+  }
+
+  return (u32High << 16) | u32Low;
 }
 
 /*EOF*/
\ No newline at end of file
@@ -12,6 +12,8 @@
 /* Private includes --------------------------------------------------------*/
 #include "sys_serial.h"
 #include "circular_buffer.h"
+#include "sys_rtos.h"
+#include "sys_mcu.h"
 #include "stm32g0xx_hal.h"
 #ifdef USE_USER_ASSERT
 #include "user_error.h"
@@ -31,6 +33,22 @@
 /* Serial 0 peripheral buffer size */
 #define SERIAL_0_RX_SIZE    (16U)
 
+/* Serial 1 (MIDI) circular buffer size */
+#define SERIAL_1_CBUF_SIZE  (128U)
+
+/* Serial 1 (MIDI) peripheral buffer size */
+#define SERIAL_1_RX_SIZE    (16U)
+
+/* Serial 0 baudrate */
+#define SERIAL_0_BAUDRATE   (115200U)
+
+/* Serial 1 (MIDI) baudrate */
+#define SERIAL_1_BAUDRATE   (31250U)
+
+/* Time of a character on the line, start, 8 data and stop bits */
+#define SERIAL_0_CHAR_US    ((10UL * 1000000UL) / SERIAL_0_BAUDRATE)
+#define SERIAL_1_CHAR_US    ((10UL * 1000000UL) / SERIAL_1_BAUDRATE)
+
 /* Private variable ---------------------------------------------------------*/
 
 /* Serial 0 resources */
@@ -43,6 +61,18 @@ static uint8_t rx_buf_uart2[SERIAL_0_RX_SIZE] = {0};
 static uint8_t rx_cbuf_uart2[SERIAL_0_CBUF_SIZE] = {0};
 
 static sys_serial_event_cb uart2_event_cb = NULL;
+static volatile uint32_t uart2_rx_time = 0U;
+
+/* Serial 1 resources */
+UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_rx;
+
+static circular_buf_t cbuff_uart1;
+static uint8_t rx_buf_uart1[SERIAL_1_RX_SIZE] = {0};
+static uint8_t rx_cbuf_uart1[SERIAL_1_CBUF_SIZE] = {0};
+
+static sys_serial_event_cb uart1_event_cb = NULL;
+static volatile uint32_t uart1_rx_time = 0U;
 
 /* Private macro -----------------------------------------------------------*/
 /* Private functions prototypes --------------------------------------------*/
@@ -61,12 +91,51 @@ static void BSP_USART2_UART_Init(void);
   */
 static void BSP_USART2_UART_Deinit(void);
 
+/**
+  * @brief USART1 Initialization Function, MIDI input
+  * @param None
+  * @retval None
+  */
+static void BSP_USART1_UART_Init(void);
+
+/**
+  * @brief USART1 DeInitialization Function
+  * @param None
+  * @retval None
+  */
+static void BSP_USART1_UART_Deinit(void);
+
+/**
+  * @brief Move received bytes from DMA buffer to circular buffer
+  * @param cbuf destination circular buffer
+  * @param pdata received data
+  * @param len number of received bytes
+  * @param event_cb callback to notify a buffer full event
+  * @retval None
+  */
+static SYS_RAM_FUNC void BSP_StoreRxData(circular_buf_t *cbuf, uint8_t *pdata, uint32_t len, sys_serial_event_cb event_cb);
+
+/**
+  * @brief Mask interrupts storing received data of a port, UART and the DMA
+  *        channel whose callbacks fill the circular buffer
+  * @param dev serial port
+  * @retval None
+  */
+static void BSP_RxLock(sys_serial_port_t dev);
+
+/**
+  * @brief Unmask interrupts masked by BSP_RxLock
+  * @param dev serial port
+  * @retval None
+  */
+static void BSP_RxUnlock(sys_serial_port_t dev);
+
 /* Private functions definition --------------------------------------------*/
 
 static void BSP_USART2_UART_Init(void)
 {
     huart2.Instance = USART2;
-    huart2.Init.BaudRate = 115200;
+    huart2.Init.BaudRate = SERIAL_0_BAUDRATE;
     huart2.Init.WordLength = UART_WORDLENGTH_8B;
     huart2.Init.StopBits = UART_STOPBITS_1;
     huart2.Init.Parity = UART_PARITY_NONE;
@@ -119,9 +188,100 @@ static void BSP_USART2_UART_Deinit(void)
     __HAL_UART_DISABLE_IT(&huart2, UART_IT_IDLE);
 }
 
+static void BSP_USART1_UART_Init(void)
+{
+    huart1.Instance = USART1;
+    huart1.Init.BaudRate = SERIAL_1_BAUDRATE;
+    huart1.Init.WordLength = UART_WORDLENGTH_8B;
+    huart1.Init.StopBits = UART_STOPBITS_1;
+    huart1.Init.Parity = UART_PARITY_NONE;
+    huart1.Init.Mode = UART_MODE_RX;
+    huart1.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+    huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+    huart1.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
+    huart1.Init.ClockPrescaler = UART_PRESCALER_DIV1;
+    huart1.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_NO_INIT;
+
+    if (HAL_UART_Init(&huart1) != HAL_OK)
+    {
+        USER_ASSERT(0);
+    }
+    if (HAL_UARTEx_DisableFifoMode(&huart1) != HAL_OK)
+    {
+        USER_ASSERT(0);
+    }
+
+    /* Init additional resurces */
+    circular_buf_init(&cbuff_uart1, rx_cbuf_uart1, SERIAL_1_CBUF_SIZE);
+
+    /* Enable idle irq */
+    __HAL_UART_ENABLE_IT(&huart1, UART_IT_IDLE);
+}
+
+static void BSP_USART1_UART_Deinit(void)
+{
+    /* Disable associated IRQ */
+    HAL_NVIC_DisableIRQ(USART1_IRQn);
+
+    /* Deinit peripheral */
+    if (HAL_UART_DeInit(&huart1) != HAL_OK)
+    {
+        USER_ASSERT(0);
+    }
+
+    /* Init additional resurces */
+    circular_buf_free(&cbuff_uart1);
+
+    /* Disable idle irq */
+    __HAL_UART_DISABLE_IT(&huart1, UART_IT_IDLE);
+}
+
+static void BSP_StoreRxData(circular_buf_t *cbuf, uint8_t *pdata, uint32_t len, sys_serial_event_cb event_cb)
+{
+    while (len-- != 0)
+    {
+        if (circular_buf_put2(cbuf, *pdata++) != 0)
+        {
+            if (event_cb != NULL)
+            {
+                event_cb(SYS_SERIAL_EVENT_RX_BUF_FULL);
+            }
+            break;
+        }
+    }
+}
+
+static void BSP_RxLock(sys_serial_port_t dev)
+{
+    if (dev == SYS_SERIAL_0)
+    {
+        HAL_NVIC_DisableIRQ(USART2_IRQn);
+        HAL_NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+    }
+    else
+    {
+        HAL_NVIC_DisableIRQ(USART1_IRQn);
+        HAL_NVIC_DisableIRQ(DMA1_Channel2_3_IRQn);
+    }
+}
+
+static void BSP_RxUnlock(sys_serial_port_t dev)
+{
+    if (dev == SYS_SERIAL_0)
+    {
+        HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+        HAL_NVIC_EnableIRQ(USART2_IRQn);
+    }
+    else
+    {
+        HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+        HAL_NVIC_EnableIRQ(USART1_IRQn);
+    }
+}
+
 /* HAL Callback -------------------------------------------------------------*/
 
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+SYS_RAM_FUNC void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
     if (huart->Instance == USART2)
     {
@@ -132,12 +292,16 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
     }
 }
 
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+SYS_RAM_FUNC void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
     if (huart->Instance == USART2)
     {
         uint8_t * pdata = rx_buf_uart2;
         uint32_t rx_size = SERIAL_0_RX_SIZE;
+
+        /* Buffer full, last byte has just been received */
+        uart2_rx_time = SYS_RTOS_GetTimeUs();
+
         while (rx_size-- != 0)
         {
             if (circular_buf_put2(&cbuff_uart2, *pdata++) != 0)
@@ -150,6 +314,23 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
             }
         }
         HAL_UART_Receive_DMA(&huart2, rx_buf_uart2, SERIAL_0_RX_SIZE);
+
+        /* Long input has no idle line, reader drains it a block at a time */
+        if (uart2_event_cb != NULL)
+        {
+            uart2_event_cb(SYS_SERIAL_EVENT_RX_IDLE);
+        }
+    }
+    else if (huart->Instance == USART1)
+    {
+        uart1_rx_time = SYS_RTOS_GetTimeUs();
+        BSP_StoreRxData(&cbuff_uart1, rx_buf_uart1, SERIAL_1_RX_SIZE, uart1_event_cb);
+        HAL_UART_Receive_DMA(&huart1, rx_buf_uart1, SERIAL_1_RX_SIZE);
+
+        if (uart1_event_cb != NULL)
+        {
+            uart1_event_cb(SYS_SERIAL_EVENT_RX_IDLE);
+        }
     }
 }
 
@@ -163,14 +344,26 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
         }
         HAL_UART_Receive_DMA(&huart2, rx_buf_uart2, SERIAL_0_RX_SIZE);
     }
+    else if (huart->Instance == USART1)
+    {
+        if (uart1_event_cb != NULL)
+        {
+            uart1_event_cb(SYS_SERIAL_EVENT_ERROR);
+        }
+        HAL_UART_Receive_DMA(&huart1, rx_buf_uart1, SERIAL_1_RX_SIZE);
+    }
 }
 
-void HAL_UART_AbortReceiveCpltCallback(UART_HandleTypeDef *huart)
+SYS_RAM_FUNC void HAL_UART_AbortReceiveCpltCallback(UART_HandleTypeDef *huart)
 {
     if (huart->Instance == USART2)
     {
         uint8_t * pdata = rx_buf_uart2;
         uint32_t rx_size = SERIAL_0_RX_SIZE - huart->hdmarx->Instance->CNDTR;
+
+        /* Idle line is detected one character after the last byte */
+        uart2_rx_time = SYS_RTOS_GetTimeUs() - SERIAL_0_CHAR_US;
+
         while (rx_size != 0)
         {
             if (circular_buf_put2(&cbuff_uart2, *pdata++) != 0)
@@ -190,13 +383,27 @@ void HAL_UART_AbortReceiveCpltCallback(UART_HandleTypeDef *huart)
             uart2_event_cb(SYS_SERIAL_EVENT_RX_IDLE);
         }
     }
+    else if (huart->Instance == USART1)
+    {
+        uint32_t rx_size = SERIAL_1_RX_SIZE - huart->hdmarx->Instance->CNDTR;
+
+        /* Idle line is detected one character after the last byte */
+        uart1_rx_time = SYS_RTOS_GetTimeUs() - SERIAL_1_CHAR_US;
+        BSP_StoreRxData(&cbuff_uart1, rx_buf_uart1, rx_size, uart1_event_cb);
+        HAL_UART_Receive_DMA(&huart1, rx_buf_uart1, SERIAL_1_RX_SIZE);
+
+        if (uart1_event_cb != NULL)
+        {
+            uart1_event_cb(SYS_SERIAL_EVENT_RX_IDLE);
+        }
+    }
 }
 
 /* Public function definition ----------------------------------------------*/
 
 sys_serial_status_t SYS_SERIAL_Init(sys_serial_port_t dev, sys_serial_event_cb event_cb)
 {
-    USER_ASSERT(dev == SYS_SERIAL_0);
+    USER_ASSERT((dev == SYS_SERIAL_0) || (dev == SYS_SERIAL_1));
 
     sys_serial_status_t eRetval = SYS_SERIAL_STATUS_ERROR;
 
@@ -216,6 +423,22 @@ sys_serial_status_t SYS_SERIAL_Init(sys_serial_port_t dev, sys_serial_event_cb e
             eRetval = SYS_SERIAL_STATUS_OK;
         }
     }
+    else if (dev == SYS_SERIAL_1)
+    {
+        /* Init hardware */
+        BSP_USART1_UART_Init();
+
+        if (event_cb != NULL)
+        {
+            uart1_event_cb = event_cb;
+        }
+
+        /* Enable reading */
+        if (HAL_UART_Receive_DMA(&huart1, rx_buf_uart1, SERIAL_1_RX_SIZE) == HAL_OK)
+        {
+            eRetval = SYS_SERIAL_STATUS_OK;
+        }
+    }
     else
     {
         /* No action */
@@ -226,7 +449,7 @@ sys_serial_status_t SYS_SERIAL_Init(sys_serial_port_t dev, sys_serial_event_cb e
 
 sys_serial_status_t SERIAL_DeInit(sys_serial_port_t dev)
 {
-    USER_ASSERT(dev == SYS_SERIAL_0);
+    USER_ASSERT((dev == SYS_SERIAL_0) || (dev == SYS_SERIAL_1));
 
     sys_serial_status_t eRetval = SYS_SERIAL_STATUS_ERROR;
 
@@ -241,6 +464,17 @@ sys_serial_status_t SERIAL_DeInit(sys_serial_port_t dev)
 
         eRetval = SYS_SERIAL_STATUS_OK;
     }
+    else if (dev == SYS_SERIAL_1)
+    {
+        BSP_USART1_UART_Deinit();
+
+        if (uart1_event_cb != NULL)
+        {
+            uart1_event_cb = NULL;
+        }
+
+        eRetval = SYS_SERIAL_STATUS_OK;
+    }
     else
     {
         /* No action */
@@ -291,7 +525,7 @@ sys_serial_status_t SYS_SERIAL_Send(sys_serial_port_t dev, uint8_t *pdata, uint1
 
 uint16_t SYS_SERIAL_Read(sys_serial_port_t dev, uint8_t *pdata, uint16_t max_len)
 {
-    USER_ASSERT(dev == SYS_SERIAL_0);
+    USER_ASSERT((dev == SYS_SERIAL_0) || (dev == SYS_SERIAL_1));
     USER_ASSERT(pdata != NULL);
 
     uint16_t u16ReadCount = 0;
@@ -299,7 +533,7 @@ uint16_t SYS_SERIAL_Read(sys_serial_port_t dev, uint8_t *pdata, uint16_t max_len
     /* Get serial handler */
     if (dev == SYS_SERIAL_0)
     {
-        HAL_NVIC_DisableIRQ(USART2_IRQn);
+        BSP_RxLock(dev);
         for (uint32_t i_data = 0; i_data < max_len; i_data++)
         {
             if (circular_buf_get(&cbuff_uart2, &pdata[i_data]) == 0)
@@ -311,7 +545,23 @@ uint16_t SYS_SERIAL_Read(sys_serial_port_t dev, uint8_t *pdata, uint16_t max_len
                 break;
             }
         }
-        HAL_NVIC_EnableIRQ(USART2_IRQn);
+        BSP_RxUnlock(dev);
+    }
+    else if (dev == SYS_SERIAL_1)
+    {
+        BSP_RxLock(dev);
+        for (uint32_t i_data = 0; i_data < max_len; i_data++)
+        {
+            if (circular_buf_get(&cbuff_uart1, &pdata[i_data]) == 0)
+            {
+                u16ReadCount++;
+            }
+            else
+            {
+                break;
+            }
+        }
+        BSP_RxUnlock(dev);
     }
     else
     {
@@ -323,16 +573,22 @@ uint16_t SYS_SERIAL_Read(sys_serial_port_t dev, uint8_t *pdata, uint16_t max_len
 
 uint16_t SYS_SERIAL_GetReadCount(sys_serial_port_t dev)
 {
-    USER_ASSERT(dev == SYS_SERIAL_0);
+    USER_ASSERT((dev == SYS_SERIAL_0) || (dev == SYS_SERIAL_1));
 
     uint16_t u16ReadCount = 0;
 
     /* Get serial handler */
     if (dev == SYS_SERIAL_0)
     {
-        HAL_NVIC_DisableIRQ(USART2_IRQn);
+        BSP_RxLock(dev);
         u16ReadCount = circular_buf_size(&cbuff_uart2);
-        HAL_NVIC_EnableIRQ(USART2_IRQn);
+        BSP_RxUnlock(dev);
+    }
+    else if (dev == SYS_SERIAL_1)
+    {
+        BSP_RxLock(dev);
+        u16ReadCount = circular_buf_size(&cbuff_uart1);
+        BSP_RxUnlock(dev);
     }
     else
     {
@@ -342,4 +598,26 @@ uint16_t SYS_SERIAL_GetReadCount(sys_serial_port_t dev)
     return u16ReadCount;
 }
 
-/*EOF*/
\ No newline at end of file
+uint32_t SYS_SERIAL_GetRxTime(sys_serial_port_t dev)
+{
+    USER_ASSERT((dev == SYS_SERIAL_0) || (dev == SYS_SERIAL_1));
+
+    uint32_t u32RxTime = 0U;
+
+    if (dev == SYS_SERIAL_0)
+    {
+        u32RxTime = uart2_rx_time;
+    }
+    else if (dev == SYS_SERIAL_1)
+    {
+        u32RxTime = uart1_rx_time;
+    }
+    else
+    {
+        /* Nothing to do */
+    }
+
+    return u32RxTime;
+}
+
+/*EOF*/
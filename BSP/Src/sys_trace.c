@@ -0,0 +1,198 @@
+/**
+ * @file sys_trace.c
+ * @author Sebastián Del Moral (sebmorgal@gmail.com)
+ * @brief Scheduler and interrupt event trace on a circular RAM buffer.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+/* Private includes --------------------------------------------------------*/
+#include <stddef.h>
+#include "sys_trace.h"
+#include "sys_mcu.h"
+#include "sys_rtos.h"
+#include "stm32g0xx_hal.h"
+#ifdef USE_USER_ASSERT
+#include "user_error.h"
+#endif
+
+/* Private macro -----------------------------------------------------------*/
+#ifdef USE_USER_ASSERT
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+#else
+#define USER_ASSERT(A)      (void)(A)
+#endif
+
+/* Private defines ---------------------------------------------------------*/
+
+/* Index mask of the event buffer */
+#define TRACE_EVENT_MASK    (SYS_TRACE_EVENT_NUM - 1U)
+
+/* Exception number of the first peripheral interrupt */
+#define TRACE_IRQ_BASE      (16U)
+
+/* Private variable ---------------------------------------------------------*/
+
+/* Event buffer, written on a circle */
+static sys_trace_event_t xTraceEvents[SYS_TRACE_EVENT_NUM];
+
+/* Events recorded since last start, next write position */
+static volatile uint32_t u32TraceHead = 0U;
+
+/* Recording state, off until started as every event masks interrupts */
+static volatile bool bTraceOn = false;
+
+/* SysTick value at entry of each interrupt, an interrupt never preempts itself */
+static uint32_t u32IsrStart[SYS_TRACE_IRQ_NUM];
+
+/* Interrupt duration statistics */
+static sys_trace_isr_t xIsrStats[SYS_TRACE_IRQ_NUM];
+
+/* Private functions prototypes --------------------------------------------*/
+/* Private functions definition --------------------------------------------*/
+/* Public functions definition ---------------------------------------------*/
+
+SYS_RAM_FUNC void SYS_TRACE_Record(uint8_t type, uint8_t id, uint16_t arg)
+{
+    if (bTraceOn)
+    {
+        uint32_t u32Primask = __get_PRIMASK();
+
+        /* Kernel hooks run from tasks too, keep slot and timestamp in order */
+        __disable_irq();
+
+        sys_trace_event_t *pxEvent = &xTraceEvents[u32TraceHead & TRACE_EVENT_MASK];
+
+        pxEvent->time_us = SYS_RTOS_GetTimeUs();
+        pxEvent->type = type;
+        pxEvent->id = id;
+        pxEvent->arg = arg;
+        u32TraceHead++;
+
+        __set_PRIMASK(u32Primask);
+    }
+}
+
+SYS_RAM_FUNC void SYS_TRACE_IsrEnter(void)
+{
+    uint32_t u32Exception = __get_IPSR();
+    uint32_t u32Irq = u32Exception - TRACE_IRQ_BASE;
+
+    /* SysTick counts down at core clock, read before any other work */
+    if (u32Irq < SYS_TRACE_IRQ_NUM)
+    {
+        u32IsrStart[u32Irq] = SysTick->VAL;
+    }
+
+    SYS_TRACE_Record(SYS_TRACE_ISR, 0U, (uint16_t)u32Exception);
+}
+
+SYS_RAM_FUNC void SYS_TRACE_IsrExit(void)
+{
+    uint32_t u32Now = SysTick->VAL;
+    uint32_t u32Irq = __get_IPSR() - TRACE_IRQ_BASE;
+
+    if (u32Irq < SYS_TRACE_IRQ_NUM)
+    {
+        sys_trace_isr_t *pxStats = &xIsrStats[u32Irq];
+        uint32_t u32Start = u32IsrStart[u32Irq];
+        uint32_t u32Cycles;
+
+        /* Handlers are shorter than a SysTick period, at most one reload */
+        if (u32Now <= u32Start)
+        {
+            u32Cycles = u32Start - u32Now;
+        }
+        else
+        {
+            u32Cycles = u32Start + (SysTick->LOAD + 1U) - u32Now;
+        }
+
+        pxStats->min_cycles = ((pxStats->count == 0U) || (u32Cycles < pxStats->min_cycles)) ? u32Cycles : pxStats->min_cycles;
+        pxStats->max_cycles = (u32Cycles > pxStats->max_cycles) ? u32Cycles : pxStats->max_cycles;
+        pxStats->sum_cycles += u32Cycles;
+        pxStats->count++;
+    }
+}
+
+bool SYS_TRACE_GetIsr(uint8_t irq, sys_trace_isr_t *stats)
+{
+    bool bRetval = false;
+
+    USER_ASSERT(stats != NULL);
+
+    if (irq < SYS_TRACE_IRQ_NUM)
+    {
+        uint32_t u32Primask = __get_PRIMASK();
+
+        /* Handler may update it meanwhile */
+        __disable_irq();
+        *stats = xIsrStats[irq];
+        __set_PRIMASK(u32Primask);
+
+        bRetval = (stats->count != 0U);
+    }
+
+    return bRetval;
+}
+
+void SYS_TRACE_ResetIsr(void)
+{
+    uint32_t u32Primask = __get_PRIMASK();
+
+    __disable_irq();
+    for (uint32_t i = 0; i < SYS_TRACE_IRQ_NUM; i++)
+    {
+        xIsrStats[i].count = 0U;
+        xIsrStats[i].min_cycles = 0U;
+        xIsrStats[i].max_cycles = 0U;
+        xIsrStats[i].sum_cycles = 0U;
+    }
+    __set_PRIMASK(u32Primask);
+}
+
+void SYS_TRACE_Start(void)
+{
+    bTraceOn = false;
+    u32TraceHead = 0U;
+    bTraceOn = true;
+}
+
+void SYS_TRACE_Stop(void)
+{
+    bTraceOn = false;
+}
+
+uint32_t SYS_TRACE_GetCount(void)
+{
+    uint32_t u32Head = u32TraceHead;
+
+    return (u32Head < SYS_TRACE_EVENT_NUM) ? u32Head : SYS_TRACE_EVENT_NUM;
+}
+
+uint32_t SYS_TRACE_GetDropped(void)
+{
+    return u32TraceHead - SYS_TRACE_GetCount();
+}
+
+uint32_t SYS_TRACE_Read(uint32_t index, sys_trace_event_t *events, uint32_t num)
+{
+    uint32_t u32Count = SYS_TRACE_GetCount();
+    uint32_t u32Oldest = u32TraceHead - u32Count;
+    uint32_t u32Copied = 0U;
+
+    USER_ASSERT(events != NULL);
+
+    while ((index < u32Count) && (u32Copied < num))
+    {
+        events[u32Copied++] = xTraceEvents[(u32Oldest + index) & TRACE_EVENT_MASK];
+        index++;
+    }
+
+    return u32Copied;
+}
+
+/*EOF*/
@@ -60,8 +60,8 @@ void vErrorInit(err_print_data vPrintError)
 
 void vErrorAssert(const void *pc, const void *lr)
 {
-    xGlobalAssert.pc = (uint32_t)pc;
-    xGlobalAssert.lr = (uint32_t)lr;
+    xGlobalAssert.pc = (uint32_t)(uintptr_t)pc;
+    xGlobalAssert.lr = (uint32_t)(uintptr_t)lr;
 
     for (uint32_t i = 0; i < sizeof(uint32_t); i++)
     {
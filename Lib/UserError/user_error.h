@@ -37,7 +37,11 @@ typedef void (* err_print_data)(char *msg, uint32_t len);
 #define ERR_GET_LR()        __builtin_return_address(0)
 
 /** Macro to capture PC reg value */
+#if defined(__arm__)
 #define ERR_GET_PC(_a)      __asm volatile ("mov %0, pc" : "=r" (_a))
+#else
+#define ERR_GET_PC(_a)      ((_a) = (void *)0)
+#endif
 
 /** Capture assert data */
 #define ERR_ASSERT_RECORD()         \
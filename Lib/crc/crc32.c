@@ -0,0 +1,52 @@
+/**
+ * @file    crc32.c
+ * @author  Sebastian Del Moral Gallardo.
+ * @brief   CRC-32 (IEEE 802.3) used to validate records stored in flash.
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "crc32.h"
+
+/* Private defines ----------------------------------------------------------*/
+/* Private macro  -----------------------------------------------------------*/
+/* Private constants  -------------------------------------------------------*/
+
+/** Reflected polynomial 0x04C11DB7, one entry per nibble keeps table small */
+static const uint32_t u32CrcNibble[16] = {
+    0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL,
+    0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+    0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+    0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL,
+};
+
+/* Private variables --------------------------------------------------------*/
+/* Private functions declaration --------------------------------------------*/
+/* Private functions definition ---------------------------------------------*/
+/* Public functions ---------------------------------------------------------*/
+
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *pu8Data = (const uint8_t *)data;
+
+    while (len-- != 0U)
+    {
+        crc ^= *pu8Data++;
+        crc = (crc >> 4) ^ u32CrcNibble[crc & 0x0FU];
+        crc = (crc >> 4) ^ u32CrcNibble[crc & 0x0FU];
+    }
+
+    return crc;
+}
+
+uint32_t crc32_final(uint32_t crc)
+{
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+uint32_t crc32_calc(const void *data, size_t len)
+{
+    return crc32_final(crc32_update(CRC32_INIT, data, len));
+}
+
+/* EOF */
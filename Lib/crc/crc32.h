@@ -0,0 +1,59 @@
+/**
+ * @file    crc32.h
+ * @author  Sebastian Del Moral Gallardo.
+ * @brief   CRC-32 (IEEE 802.3) used to validate records stored in flash.
+ *
+ */
+
+#ifndef __CRC32_H
+#define __CRC32_H
+
+#ifdef  __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* Initial value of a CRC computation */
+#define CRC32_INIT                  0xFFFFFFFFUL
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief  Add data to a running CRC.
+ * @param  crc running CRC, CRC32_INIT on first call.
+ * @param  data data to add.
+ * @param  len data length in bytes.
+ * @retval updated running CRC.
+ */
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+/**
+ * @brief  Get final CRC value from a running CRC.
+ * @param  crc running CRC.
+ * @retval CRC value.
+ */
+uint32_t crc32_final(uint32_t crc);
+
+/**
+ * @brief  Compute CRC of a data block.
+ * @param  data data block.
+ * @param  len data length in bytes.
+ * @retval CRC value.
+ */
+uint32_t crc32_calc(const void *data, size_t len);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __CRC32_H */
+
+/* EOF */
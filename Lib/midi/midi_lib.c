@@ -0,0 +1,147 @@
+/**
+ * @file    midi_lib.c
+ * @author  Sebastian Del Moral Gallardo.
+ * @brief   Byte stream MIDI parser producing packed MIDI messages.
+ *
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stddef.h>
+#include "midi_lib.h"
+
+/* Private defines ----------------------------------------------------------*/
+/* Private macro  -----------------------------------------------------------*/
+/* Private constants  -------------------------------------------------------*/
+
+/** Data bytes expected for each channel message type, indexed by status >> 4 */
+static const uint8_t u8ChannelDataLen[8] = {
+    2U, /* Note off */
+    2U, /* Note on */
+    2U, /* Poly pressure */
+    2U, /* Control change */
+    1U, /* Program change */
+    1U, /* Channel pressure */
+    2U, /* Pitch bend */
+    0U, /* System, handled apart */
+};
+
+/* Private variables --------------------------------------------------------*/
+/* Private functions declaration --------------------------------------------*/
+
+/**
+  * @brief Get number of data bytes for a system common status.
+  * @param status status byte.
+  * @retval number of data bytes.
+  */
+static uint8_t u8SystemDataLen(uint8_t status);
+
+/* Private functions definitions --------------------------------------------*/
+
+static uint8_t u8SystemDataLen(uint8_t status)
+{
+    uint8_t u8Len = 0U;
+
+    if ((status == MIDI_TIME_CODE) || (status == MIDI_SONG_SELECT))
+    {
+        u8Len = 1U;
+    }
+    else if (status == MIDI_SONG_POSITION)
+    {
+        u8Len = 2U;
+    }
+    else
+    {
+        /* Tune request, sysex and undefined have no payload */
+    }
+
+    return u8Len;
+}
+
+/* Public functions declaration ---------------------------------------------*/
+
+void midi_parser_init(midi_parser_t *parser)
+{
+    if (parser != NULL)
+    {
+        parser->status = 0U;
+        parser->data[0] = 0U;
+        parser->data[1] = 0U;
+        parser->count = 0U;
+        parser->expected = 0U;
+    }
+}
+
+bool midi_parser_put(midi_parser_t *parser, uint8_t byte, midi_msg_t *msg)
+{
+    bool bRetval = false;
+
+    if (MIDI_IS_REALTIME(byte))
+    {
+        /* Realtime bytes never affect running status */
+        *msg = MIDI_MSG_PACK(byte, 0U, 0U);
+        bRetval = true;
+    }
+    else if ((byte & 0x80U) != 0U)
+    {
+        parser->count = 0U;
+
+        if (byte < MIDI_SYSEX_START)
+        {
+            parser->status = byte;
+            parser->expected = u8ChannelDataLen[(byte >> 4) & 0x07U];
+        }
+        else
+        {
+            /* System common messages cancel running status */
+            parser->expected = u8SystemDataLen(byte);
+            parser->status = (byte == MIDI_SYSEX_START) ? byte : 0U;
+
+            if ((parser->expected == 0U) && (byte != MIDI_SYSEX_START) && (byte != MIDI_SYSEX_END))
+            {
+                *msg = MIDI_MSG_PACK(byte, 0U, 0U);
+                bRetval = true;
+            }
+            else if (parser->expected != 0U)
+            {
+                parser->status = byte;
+            }
+            else
+            {
+                /* Sysex frame start/end, payload is dropped */
+            }
+        }
+    }
+    else if ((parser->status != 0U) && (parser->status != MIDI_SYSEX_START))
+    {
+        parser->data[parser->count++] = byte;
+
+        if (parser->count >= parser->expected)
+        {
+            uint8_t u8Status = parser->status;
+
+            /* Note on with velocity 0 is a note off */
+            if (((u8Status & 0xF0U) == MIDI_NOTE_ON) && (parser->data[1] == 0U))
+            {
+                u8Status = MIDI_NOTE_OFF | (u8Status & 0x0FU);
+            }
+
+            *msg = MIDI_MSG_PACK(u8Status, parser->data[0], (parser->expected > 1U) ? parser->data[1] : 0U);
+            bRetval = true;
+            parser->count = 0U;
+
+            /* Only channel messages keep running status */
+            if (parser->status >= MIDI_SYSEX_START)
+            {
+                parser->status = 0U;
+            }
+        }
+    }
+    else
+    {
+        /* Data byte without status or inside sysex, discard */
+    }
+
+    return bRetval;
+}
+
+/* EOF */
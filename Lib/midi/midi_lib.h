@@ -0,0 +1,134 @@
+/**
+ * @file    midi_lib.h
+ * @author  Sebastian Del Moral Gallardo.
+ * @brief   Byte stream MIDI parser producing packed MIDI messages.
+ *
+ */
+
+#ifndef __MIDI_LIB_H
+#define __MIDI_LIB_H
+
+#ifdef  __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported defines ----------------------------------------------------------*/
+
+/* Channel voice messages */
+#define MIDI_NOTE_OFF               0x80U
+#define MIDI_NOTE_ON                0x90U
+#define MIDI_POLY_PRESSURE          0xA0U
+#define MIDI_CONTROL_CHANGE         0xB0U
+#define MIDI_PROGRAM_CHANGE         0xC0U
+#define MIDI_CHANNEL_PRESSURE       0xD0U
+#define MIDI_PITCH_BEND             0xE0U
+
+/* System messages */
+#define MIDI_SYSEX_START            0xF0U
+#define MIDI_TIME_CODE              0xF1U
+#define MIDI_SONG_POSITION          0xF2U
+#define MIDI_SONG_SELECT            0xF3U
+#define MIDI_TUNE_REQUEST           0xF6U
+#define MIDI_SYSEX_END              0xF7U
+
+/* System realtime messages */
+#define MIDI_TIMING_CLOCK           0xF8U
+#define MIDI_START                  0xFAU
+#define MIDI_CONTINUE               0xFBU
+#define MIDI_STOP                   0xFCU
+#define MIDI_ACTIVE_SENSING         0xFEU
+#define MIDI_RESET                  0xFFU
+
+/** Number of MIDI channels */
+#define MIDI_CHANNEL_NUM            16U
+
+/** Number of MIDI notes */
+#define MIDI_NOTE_NUM               128U
+
+/** Max value of a data byte */
+#define MIDI_DATA_MAX               0x7FU
+
+/** Max value of a 14 bit value, pitch bend or MSB/LSB controller pair */
+#define MIDI_DATA14_MAX             0x3FFFU
+
+/** Pitch bend value with no bend */
+#define MIDI_PITCH_BEND_CENTER      0x2000U
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+ * Packed MIDI message.
+ * Bits 23..16 hold the status byte, 15..8 the first data byte and
+ * 7..0 the second data byte. Missing data bytes are set to zero.
+ */
+typedef uint32_t midi_msg_t;
+
+/** Parser state */
+typedef struct midi_parser
+{
+    uint8_t status;     /**< Running status, 0 if none */
+    uint8_t data[2];    /**< Data bytes received for current message */
+    uint8_t count;      /**< Number of data bytes received */
+    uint8_t expected;   /**< Number of data bytes expected for status */
+} midi_parser_t;
+
+/* Exported macro ------------------------------------------------------------*/
+
+/** Build packed message */
+#define MIDI_MSG_PACK(st, d1, d2)   ((midi_msg_t)(((uint32_t)(st) << 16) | ((uint32_t)(d1) << 8) | (uint32_t)(d2)))
+
+/** Get status byte */
+#define MIDI_MSG_STATUS(m)          ((uint8_t)((m) >> 16))
+
+/** Get message type, channel removed for channel messages */
+#define MIDI_MSG_TYPE(m)            ((uint8_t)(((m) >> 16) & 0xF0U))
+
+/** Get channel of a channel message */
+#define MIDI_MSG_CHANNEL(m)         ((uint8_t)(((m) >> 16) & 0x0FU))
+
+/** Get first data byte */
+#define MIDI_MSG_DATA1(m)           ((uint8_t)((m) >> 8))
+
+/** Get second data byte */
+#define MIDI_MSG_DATA2(m)           ((uint8_t)(m))
+
+/** 14 bit value from data bytes, LSB first as sent on pitch bend */
+#define MIDI_MSG_DATA14(m)          ((uint16_t)((((m) & 0x7FU) << 7) | (((m) >> 8) & 0x7FU)))
+
+/** Check if status byte is a realtime one */
+#define MIDI_IS_REALTIME(b)         ((b) >= MIDI_TIMING_CLOCK)
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief Reset parser state.
+  * @param parser parser to init.
+  * @retval None.
+  */
+void midi_parser_init(midi_parser_t *parser);
+
+/**
+  * @brief Feed one byte to the parser.
+  * @note Running status is supported and realtime bytes are reported as soon
+  *       as they arrive, even in the middle of another message. Note on
+  *       messages with zero velocity are reported as note off.
+  * @param parser parser to use.
+  * @param byte received byte.
+  * @param msg where to store the message when complete.
+  * @retval true if a complete message has been stored in msg.
+  */
+bool midi_parser_put(midi_parser_t *parser, uint8_t byte, midi_msg_t *msg);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __MIDI_LIB_H */
+
+/* EOF */
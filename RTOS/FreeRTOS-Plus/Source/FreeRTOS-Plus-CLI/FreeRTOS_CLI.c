@@ -59,9 +59,24 @@ typedef struct xCOMMAND_INPUT_LIST
 static BaseType_t prvHelpCommand( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString );
 
 /*
- * Return the number of parameters that follow the command name.
+ * Hash a command name xCommandLength characters long, FNV-1a.
  */
-static int8_t prvGetNumberOfParameters( const char *pcCommandString );
+static uint32_t prvHashCommand( const char *pcCommand, size_t xCommandLength );
+
+/*
+ * Check the command name at the start of pcCommandInput, xCommandLength
+ * characters long, matches a registered command name.
+ */
+static BaseType_t prvMatchCommand( const char *pcCommandInput, size_t xCommandLength, const char *pcCommand );
+
+/*
+ * Find the definition of the command at the start of pcCommandInput, first on
+ * the command table and then on the list of registered commands.  The input is
+ * scanned once, the number of parameters that follow the command name is
+ * counted on the same pass and stored in pcNumberOfParameters.  Returns NULL
+ * if the command is not registered.
+ */
+static const CLI_Command_Definition_t *prvFindCommand( const char *pcCommandInput, int8_t *pcNumberOfParameters );
 
 /* The definition of the "help" command.  This command is always at the front
 of the list of registered commands. */
@@ -99,6 +114,32 @@ buffer needs to be placed at a fixed address (rather than by the linker). */
 	extern char cOutputBuffer[ configCOMMAND_INT_MAX_OUTPUT_SIZE ];
 #endif
 
+/* When dynamic allocation is not available the list items are taken from a
+static pool.  Set configCOMMAND_INT_MAX_COMMANDS in FreeRTOSConfig.h to the
+number of commands registered by the application, help is not counted. */
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#ifndef configCOMMAND_INT_MAX_COMMANDS
+		#error configCOMMAND_INT_MAX_COMMANDS must be defined when configSUPPORT_DYNAMIC_ALLOCATION is 0
+	#endif
+	static CLI_Definition_List_Item_t xCommandListItems[ configCOMMAND_INT_MAX_COMMANDS ];
+	static UBaseType_t uxCommandListItemsUsed = 0;
+#endif
+
+/* Size of the hash index of the command table, a power of two larger than the
+number of commands on the table.  Set configCOMMAND_INT_HASH_SIZE in
+FreeRTOSConfig.h to change it. */
+#ifndef configCOMMAND_INT_HASH_SIZE
+	#define configCOMMAND_INT_HASH_SIZE 64
+#endif
+
+/* Command table registered with FreeRTOS_CLIRegisterCommandTable().  The table
+is const, so it stays in flash.  A command is found through an open addressed
+hash index built at registration, one compare per lookup unless names collide.
+Each index slot holds the table position plus one, 0 marks a free slot. */
+static const CLI_Command_Definition_t *pxCommandTable = NULL;
+static UBaseType_t uxCommandTableLength = 0;
+static uint8_t ucCommandHash[ configCOMMAND_INT_HASH_SIZE ];
+
 
 /*-----------------------------------------------------------*/
 
@@ -112,7 +153,25 @@ BaseType_t xReturn = pdFAIL;
 	configASSERT( pxCommandToRegister );
 
 	/* Create a new list item that will reference the command being registered. */
-	pxNewListItem = ( CLI_Definition_List_Item_t * ) pvPortMalloc( sizeof( CLI_Definition_List_Item_t ) );
+	#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	{
+		pxNewListItem = ( CLI_Definition_List_Item_t * ) pvPortMalloc( sizeof( CLI_Definition_List_Item_t ) );
+	}
+	#else
+	{
+		pxNewListItem = NULL;
+
+		taskENTER_CRITICAL();
+		{
+			if( uxCommandListItemsUsed < ( UBaseType_t ) configCOMMAND_INT_MAX_COMMANDS )
+			{
+				pxNewListItem = &( xCommandListItems[ uxCommandListItemsUsed ] );
+				uxCommandListItemsUsed++;
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+	#endif
 	configASSERT( pxNewListItem );
 
 	if( pxNewListItem != NULL )
@@ -143,46 +202,74 @@ BaseType_t xReturn = pdFAIL;
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t FreeRTOS_CLIRegisterCommandTable( const CLI_Command_Definition_t * const pxTable, UBaseType_t uxNumberOfCommands )
+{
+BaseType_t xReturn = pdFAIL;
+UBaseType_t ux;
+
+	/* Check the parameter is not NULL, that only one table is registered and
+	that the hash index always has a free slot to end a probe. */
+	configASSERT( pxTable );
+	configASSERT( pxCommandTable == NULL );
+	configASSERT( ( configCOMMAND_INT_HASH_SIZE & ( configCOMMAND_INT_HASH_SIZE - 1 ) ) == 0 );
+	configASSERT( uxNumberOfCommands < ( UBaseType_t ) configCOMMAND_INT_HASH_SIZE );
+	configASSERT( uxNumberOfCommands <= ( UBaseType_t ) UINT8_MAX );
+
+	if( ( pxCommandTable == NULL ) && ( uxNumberOfCommands < ( UBaseType_t ) configCOMMAND_INT_HASH_SIZE ) )
+	{
+		taskENTER_CRITICAL();
+		{
+			memset( ucCommandHash, 0x00, sizeof( ucCommandHash ) );
+
+			/* Colliding names take the next free slot. */
+			for( ux = 0; ux < uxNumberOfCommands; ux++ )
+			{
+			size_t xLength = strlen( pxTable[ ux ].pcCommand );
+			uint32_t ulSlot = prvHashCommand( pxTable[ ux ].pcCommand, xLength ) & ( configCOMMAND_INT_HASH_SIZE - 1UL );
+
+				while( ucCommandHash[ ulSlot ] != 0U )
+				{
+					/* Names must not be duplicated. */
+					configASSERT( strcmp( pxTable[ ucCommandHash[ ulSlot ] - 1U ].pcCommand, pxTable[ ux ].pcCommand ) != 0 );
+					ulSlot = ( ulSlot + 1UL ) & ( configCOMMAND_INT_HASH_SIZE - 1UL );
+				}
+
+				ucCommandHash[ ulSlot ] = ( uint8_t ) ( ux + 1U );
+			}
+
+			pxCommandTable = pxTable;
+			uxCommandTableLength = uxNumberOfCommands;
+		}
+		taskEXIT_CRITICAL();
+
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t FreeRTOS_CLIProcessCommand( const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen  )
 {
-static const CLI_Definition_List_Item_t *pxCommand = NULL;
+static const CLI_Command_Definition_t *pxCommand = NULL;
 BaseType_t xReturn = pdTRUE;
-const char *pcRegisteredCommandString;
-size_t xCommandStringLength;
+int8_t cParameters = 0;
 
 	/* Note:  This function is not re-entrant.  It must not be called from more
 	thank one task. */
 
 	if( pxCommand == NULL )
 	{
-		/* Search for the command string in the list of registered commands. */
-		for( pxCommand = &xRegisteredCommands; pxCommand != NULL; pxCommand = pxCommand->pxNext )
+		pxCommand = prvFindCommand( pcCommandInput, &cParameters );
+
+		/* Check the command found has the expected number of parameters.  If
+		cExpectedNumberOfParameters is -1, then there could be a variable number
+		of parameters and no check is made. */
+		if( ( pxCommand != NULL ) && ( pxCommand->cExpectedNumberOfParameters >= 0 ) )
 		{
-			pcRegisteredCommandString = pxCommand->pxCommandLineDefinition->pcCommand;
-			xCommandStringLength = strlen( pcRegisteredCommandString );
-
-			/* To ensure the string lengths match exactly, so as not to pick up
-			a sub-string of a longer command, check the byte after the expected
-			end of the string is either the end of the string or a space before
-			a parameter. */
-			if( ( pcCommandInput[ xCommandStringLength ] == ' ' ) || ( pcCommandInput[ xCommandStringLength ] == 0x00 ) )
+			if( cParameters != pxCommand->cExpectedNumberOfParameters )
 			{
-				if( strncmp( pcCommandInput, pcRegisteredCommandString, xCommandStringLength ) == 0 )
-				{
-					/* The command has been found.  Check it has the expected
-					number of parameters.  If cExpectedNumberOfParameters is -1,
-					then there could be a variable number of parameters and no
-					check is made. */
-					if( pxCommand->pxCommandLineDefinition->cExpectedNumberOfParameters >= 0 )
-					{
-						if( prvGetNumberOfParameters( pcCommandInput ) != pxCommand->pxCommandLineDefinition->cExpectedNumberOfParameters )
-						{
-							xReturn = pdFALSE;
-						}
-					}
-
-					break;
-				}
+				xReturn = pdFALSE;
 			}
 		}
 	}
@@ -197,7 +284,7 @@ size_t xCommandStringLength;
 	else if( pxCommand != NULL )
 	{
 		/* Call the callback function that is registered to this command. */
-		xReturn = pxCommand->pxCommandLineDefinition->pxCommandInterpreter( pcWriteBuffer, xWriteBufferLen, pcCommandInput );
+		xReturn = pxCommand->pxCommandInterpreter( pcWriteBuffer, xWriteBufferLen, pcCommandInput );
 
 		/* If xReturn is pdFALSE, then no further strings will be returned
 		after this one, and	pxCommand can be reset to NULL ready to search
@@ -283,25 +370,38 @@ const char *pcReturn = NULL;
 static BaseType_t prvHelpCommand( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString )
 {
 static const CLI_Definition_List_Item_t * pxCommand = NULL;
+static BaseType_t xListDone = pdFALSE;
+static UBaseType_t uxTableIndex = 0;
 BaseType_t xReturn;
 
 	( void ) pcCommandString;
 
-	if( pxCommand == NULL )
+	if( ( pxCommand == NULL ) && ( xListDone == pdFALSE ) )
 	{
 		/* Reset the pxCommand pointer back to the start of the list. */
 		pxCommand = &xRegisteredCommands;
 	}
 
-	/* Return the next command help string, before moving the pointer on to
-	the next command in the list. */
-	strncpy( pcWriteBuffer, pxCommand->pxCommandLineDefinition->pcHelpString, xWriteBufferLen );
-	pxCommand = pxCommand->pxNext;
+	/* Return the next command help string, before moving on to the next
+	command.  The list goes first, then the command table. */
+	if( pxCommand != NULL )
+	{
+		strncpy( pcWriteBuffer, pxCommand->pxCommandLineDefinition->pcHelpString, xWriteBufferLen );
+		pxCommand = pxCommand->pxNext;
+		xListDone = ( pxCommand == NULL ) ? pdTRUE : pdFALSE;
+	}
+	else
+	{
+		strncpy( pcWriteBuffer, pxCommandTable[ uxTableIndex ].pcHelpString, xWriteBufferLen );
+		uxTableIndex++;
+	}
 
-	if( pxCommand == NULL )
+	if( ( pxCommand == NULL ) && ( uxTableIndex >= uxCommandTableLength ) )
 	{
-		/* There are no more commands in the list, so there will be no more
-		strings to return after this one and pdFALSE should be returned. */
+		/* There are no more commands, so there will be no more strings to
+		return after this one and pdFALSE should be returned. */
+		xListDone = pdFALSE;
+		uxTableIndex = 0;
 		xReturn = pdFALSE;
 	}
 	else
@@ -313,39 +413,87 @@ BaseType_t xReturn;
 }
 /*-----------------------------------------------------------*/
 
-static int8_t prvGetNumberOfParameters( const char *pcCommandString )
+static uint32_t prvHashCommand( const char *pcCommand, size_t xCommandLength )
 {
+uint32_t ulHash = 2166136261UL;
+size_t x;
+
+	for( x = 0; x < xCommandLength; x++ )
+	{
+		ulHash = ( ulHash ^ ( uint8_t ) pcCommand[ x ] ) * 16777619UL;
+	}
+
+	return ulHash;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvMatchCommand( const char *pcCommandInput, size_t xCommandLength, const char *pcCommand )
+{
+	/* The input must not be a sub-string of a longer command. */
+	return ( ( strncmp( pcCommandInput, pcCommand, xCommandLength ) == 0 ) && ( pcCommand[ xCommandLength ] == 0x00 ) ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static const CLI_Command_Definition_t *prvFindCommand( const char *pcCommandInput, int8_t *pcNumberOfParameters )
+{
+const CLI_Command_Definition_t *pxReturn = NULL;
+const CLI_Definition_List_Item_t *pxItem;
+const char *pcCharacter;
+size_t xCommandLength = 0;
+uint32_t ulHash = 2166136261UL;
+uint32_t ulSlot;
 int8_t cParameters = 0;
 BaseType_t xLastCharacterWasSpace = pdFALSE;
 
-	/* Count the number of space delimited words in pcCommandString. */
-	while( *pcCommandString != 0x00 )
+	/* The command name ends at the first space before a parameter, it is
+	hashed while it is scanned. */
+	while( ( pcCommandInput[ xCommandLength ] != 0x00 ) && ( pcCommandInput[ xCommandLength ] != ' ' ) )
+	{
+		ulHash = ( ulHash ^ ( uint8_t ) pcCommandInput[ xCommandLength ] ) * 16777619UL;
+		xCommandLength++;
+	}
+
+	/* The rest of the line is only scanned to count space delimited words. */
+	for( pcCharacter = &pcCommandInput[ xCommandLength ]; *pcCharacter != 0x00; pcCharacter++ )
 	{
-		if( ( *pcCommandString ) == ' ' )
+		if( *pcCharacter == ' ' )
 		{
-			if( xLastCharacterWasSpace != pdTRUE )
-			{
-				cParameters++;
-				xLastCharacterWasSpace = pdTRUE;
-			}
+			xLastCharacterWasSpace = pdTRUE;
 		}
 		else
 		{
+			if( xLastCharacterWasSpace == pdTRUE )
+			{
+				cParameters++;
+			}
 			xLastCharacterWasSpace = pdFALSE;
 		}
+	}
+	*pcNumberOfParameters = cParameters;
+
+	/* Probe the hash index until the command or a free slot is found. */
+	if( pxCommandTable != NULL )
+	{
+		for( ulSlot = ulHash & ( configCOMMAND_INT_HASH_SIZE - 1UL ); ( ucCommandHash[ ulSlot ] != 0U ) && ( pxReturn == NULL ); ulSlot = ( ulSlot + 1UL ) & ( configCOMMAND_INT_HASH_SIZE - 1UL ) )
+		{
+			const CLI_Command_Definition_t *pxEntry = &( pxCommandTable[ ucCommandHash[ ulSlot ] - 1U ] );
 
-		pcCommandString++;
+			if( prvMatchCommand( pcCommandInput, xCommandLength, pxEntry->pcCommand ) == pdTRUE )
+			{
+				pxReturn = pxEntry;
+			}
+		}
 	}
 
-	/* If the command string ended with spaces, then there will have been too
-	many parameters counted. */
-	if( xLastCharacterWasSpace == pdTRUE )
+	/* Then the commands registered one by one, help included. */
+	for( pxItem = &xRegisteredCommands; ( pxItem != NULL ) && ( pxReturn == NULL ); pxItem = pxItem->pxNext )
 	{
-		cParameters--;
+		if( prvMatchCommand( pcCommandInput, xCommandLength, pxItem->pxCommandLineDefinition->pcCommand ) == pdTRUE )
+		{
+			pxReturn = pxItem->pxCommandLineDefinition;
+		}
 	}
 
-	/* The value returned is one less than the number of space delimited words,
-	as the first word should be the command itself. */
-	return cParameters;
+	return pxReturn;
 }
-
+/*-----------------------------------------------------------*/
@@ -56,6 +56,16 @@ typedef struct xCOMMAND_LINE_INPUT
  */
 BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const pxCommandToRegister );
 
+/*
+ * Register a const table of commands in one go.  Names must not be duplicated
+ * and the table must hold fewer commands than configCOMMAND_INT_HASH_SIZE.
+ * Commands are found through a hash index built here, and the table is
+ * referenced in place so no list items are used.  Only one table can be
+ * registered.  Commands registered with FreeRTOS_CLIRegisterCommand() are
+ * still searched, after the table.
+ */
+BaseType_t FreeRTOS_CLIRegisterCommandTable( const CLI_Command_Definition_t * const pxTable, UBaseType_t uxNumberOfCommands );
+
 /*
  * Runs the command interpreter for the command string "pcCommandInput".  Any
  * output generated by running the command will be placed into pcWriteBuffer.
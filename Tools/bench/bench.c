@@ -0,0 +1,490 @@
+/**
+ * @file    bench.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Host micro-benchmarks of the firmware hot paths.
+ *
+ * Every benchmark runs the real library or application code compiled for
+ * the host. Iterations are scaled until a run takes BENCH_RUN_NS, and the best
+ * of BENCH_REPEAT runs is kept to filter scheduler noise. Results are CSV on
+ * stdout, one line per benchmark:
+ *     name,ns_per_op,ops_per_sec[,baseline_ns_per_op,change_pct]
+ *
+ * A previous result given as baseline adds the last two columns, changes
+ * over the threshold are reported on stderr and make the run fail. Host
+ * figures only compare against the same machine and build. Usage:
+ *     bench [-b baseline.csv] [-t threshold_pct] [filter]
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_CLI.h"
+#include "circular_buffer.h"
+#include "printf.h"   /* Takes printf, results go through fprintf */
+#include "midi_lib.h"
+#include "cv_engine.h"
+#include "cv_cal.h"
+#include "cv_param.h"
+#include "user_error.h"
+
+/* Private typedef -----------------------------------------------------------*/
+
+/** Benchmark, runs the operation a number of times */
+typedef struct bench
+{
+    const char *name;                   /**< Name on results */
+    void (*run)(uint32_t iterations);   /**< Run iterations of the operation */
+} bench_t;
+
+/** Baseline result */
+typedef struct bench_base
+{
+    char name[32];                      /**< Benchmark name */
+    double ns_per_op;                   /**< Time per operation */
+} bench_base_t;
+
+/* Private define ------------------------------------------------------------*/
+
+/* Target time of a measured run */
+#define BENCH_RUN_NS        (50000000ULL)
+
+/* Measured runs, best is kept */
+#define BENCH_REPEAT        5U
+
+/* Default regression threshold */
+#define BENCH_THRESHOLD     10.0
+
+/* Max baseline entries */
+#define BENCH_BASE_NUM      32U
+
+/* Size of the ring buffer under test, as the MIDI reception one */
+#define BENCH_CBUF_SIZE     128U
+
+/* Size of the print buffer, as CLI_OUTPUT_BUFFER_SIZE */
+#define BENCH_PRINT_SIZE    128U
+
+/* Private macro -------------------------------------------------------------*/
+
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+
+/* Private variables ---------------------------------------------------------*/
+
+/** Results fed back here so the compiler keeps the work */
+static volatile uint32_t u32Sink = 0U;
+
+static uint8_t u8CbufData[BENCH_CBUF_SIZE];
+static circular_buf_t xCbuf;
+
+static char cPrintBuf[BENCH_PRINT_SIZE];
+static char cCliOutput[configCOMMAND_INT_MAX_OUTPUT_SIZE];
+
+/** Performance stream: notes with running status, controllers and clock */
+static const uint8_t u8MidiStream[] = {
+    0x90, 0x3C, 0x64, 0x40, 0x64, 0xF8, 0x43, 0x64,
+    0xB0, 0x01, 0x40, 0x07, 0x7F, 0xF8,
+    0xE0, 0x00, 0x48, 0xD0, 0x30,
+    0x80, 0x3C, 0x00, 0x90, 0x40, 0x00, 0x43, 0x00, 0xF8,
+};
+
+static bench_base_t xBase[BENCH_BASE_NUM];
+static uint32_t u32BaseNum = 0U;
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+  * @brief Show assert info and stop
+  * @param msg error message
+  * @param len size of error message
+  * @retval None
+  */
+static void _error_print(char *msg, uint32_t len);
+
+/**
+  * @brief Command handler of the registered commands, does nothing
+  * @retval pdFALSE
+  */
+static BaseType_t _cli_nop(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+/**
+  * @brief Print through vsnprintf_ as vCliPrintf does
+  * @retval printed length
+  */
+static int _print(const char *pcFormat, ...);
+
+/**
+  * @brief Get monotonic time
+  * @retval time in nanoseconds
+  */
+static uint64_t _now_ns(void);
+
+/**
+  * @brief Measure a benchmark
+  * @param pxBench benchmark
+  * @retval best time per operation in nanoseconds
+  */
+static void _bench_param_publish(uint32_t iterations)
+{
+    cv_param_values_t xValues;
+    uint32_t u32Seq = CV_PARAM_SEQ_NONE;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        (void)cv_param_set(CV_PARAM_GLIDE, (int32_t)(i & 0x3FFU));
+        (void)cv_param_read(&xValues, &u32Seq);
+        u32Sink += xValues.glide_ms;
+    }
+}
+
+static double _measure(const bench_t *pxBench);
+
+/**
+  * @brief Load baseline results
+  * @param pcPath CSV file written by a previous run
+  * @retval true on success
+  */
+static bool _base_load(const char *pcPath);
+
+/**
+  * @brief Find baseline of a benchmark
+  * @param pcName benchmark name
+  * @retval baseline, NULL if none
+  */
+static const bench_base_t *_base_find(const char *pcName);
+
+/* Benchmarks */
+static void _bench_cbuf(uint32_t iterations);
+static void _bench_printf(uint32_t iterations);
+static void _bench_cli_first(uint32_t iterations);
+static void _bench_cli_last(uint32_t iterations);
+static void _bench_cli_miss(uint32_t iterations);
+static void _bench_midi_parse(uint32_t iterations);
+static void _bench_note_cv(uint32_t iterations);
+static void _bench_engine_tick(uint32_t iterations);
+static void _bench_param_publish(uint32_t iterations);
+
+/** Commands with the names and order of the cli_cmd table */
+static const CLI_Command_Definition_t xCliCmds[] = {
+    {"assert", "", _cli_nop, 0}, {"boot", "", _cli_nop, 0}, {"bpm", "", _cli_nop, 0},
+    {"cal", "", _cli_nop, -1}, {"cc", "", _cli_nop, 5}, {"clk", "", _cli_nop, 5},
+    {"env", "", _cli_nop, 8}, {"fault", "", _cli_nop, 0}, {"get", "", _cli_nop, -1},
+    {"gmap", "", _cli_nop, 2}, {"gout", "", _cli_nop, 4}, {"isr", "", _cli_nop, -1},
+    {"lat", "", _cli_nop, -1}, {"lfo", "", _cli_nop, 5}, {"mem", "", _cli_nop, -1},
+    {"mode", "", _cli_nop, 1}, {"preset", "", _cli_nop, 2}, {"reset", "", _cli_nop, 0},
+    {"set", "", _cli_nop, 2}, {"time", "", _cli_nop, 0}, {"top", "", _cli_nop, -1},
+    {"trace", "", _cli_nop, 1}, {"ucurve", "", _cli_nop, 4},
+};
+
+/** Benchmark list, one operation each as described */
+static const bench_t xBenches[] = {
+    {"cbuf_put_get", _bench_cbuf},              /* One byte in and out */
+    {"vsnprintf", _bench_printf},               /* One CLI log line */
+    {"cli_lookup_first", _bench_cli_first},     /* First command registered one by one before */
+    {"cli_lookup_last", _bench_cli_last},       /* Last command registered one by one before */
+    {"cli_lookup_miss", _bench_cli_miss},       /* Unknown command */
+    {"midi_parse_byte", _bench_midi_parse},     /* One byte of a mixed stream */
+    {"note_to_cv", _bench_note_cv},             /* One calibrated pitch */
+    {"engine_tick", _bench_engine_tick},        /* One output tick and frame */
+    {"param_publish", _bench_param_publish},    /* One parameter set and read back by a reader */
+};
+
+/* Private application code --------------------------------------------------*/
+
+static void _error_print(char *msg, uint32_t len)
+{
+    fwrite(msg, 1U, len, stderr);
+    abort();
+}
+
+static BaseType_t _cli_nop(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    u32Sink += (uint32_t)pcCommandString[0];
+
+    return pdFALSE;
+}
+
+static int _print(const char *pcFormat, ...)
+{
+    va_list Args;
+    int len_data;
+
+    va_start(Args, pcFormat);
+    len_data = vsnprintf_(cPrintBuf, sizeof(cPrintBuf), pcFormat, Args);
+    va_end(Args);
+
+    return len_data;
+}
+
+static uint64_t _now_ns(void)
+{
+    struct timespec xNow;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &xNow);
+
+    return ((uint64_t)xNow.tv_sec * 1000000000ULL) + (uint64_t)xNow.tv_nsec;
+}
+
+static void _bench_cbuf(uint32_t iterations)
+{
+    uint8_t u8Data = 0U;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        (void)circular_buf_put2(&xCbuf, (uint8_t)i);
+        (void)circular_buf_get(&xCbuf, &u8Data);
+        u32Sink += u8Data;
+    }
+}
+
+static void _bench_printf(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        u32Sink += (uint32_t)_print("%08x, %s, note: n %u min %u max %u", i, "CLI", i & 0xFFU, 120U, 1313U);
+    }
+}
+
+static void _bench_cli_first(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        u32Sink += (uint32_t)FreeRTOS_CLIProcessCommand("reset", cCliOutput, sizeof(cCliOutput));
+    }
+}
+
+static void _bench_cli_last(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        u32Sink += (uint32_t)FreeRTOS_CLIProcessCommand("preset load 1", cCliOutput, sizeof(cCliOutput));
+    }
+}
+
+static void _bench_cli_miss(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        u32Sink += (uint32_t)FreeRTOS_CLIProcessCommand("presets", cCliOutput, sizeof(cCliOutput));
+    }
+}
+
+static void _bench_midi_parse(uint32_t iterations)
+{
+    midi_parser_t xParser;
+    midi_msg_t xMsg = 0U;
+    uint32_t u32Pos = 0U;
+
+    midi_parser_init(&xParser);
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        if (midi_parser_put(&xParser, u8MidiStream[u32Pos], &xMsg))
+        {
+            u32Sink += xMsg;
+        }
+        u32Pos = (u32Pos + 1U < sizeof(u8MidiStream)) ? (u32Pos + 1U) : 0U;
+    }
+}
+
+static void _bench_note_cv(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        u32Sink += cv_cal_pitch((uint8_t)(i & 0x03U), (uint8_t)(i & 0x7FU), (int32_t)(i & 0xFFU) - 128);
+    }
+}
+
+static void _bench_engine_tick(uint32_t iterations)
+{
+    cv_frame_t xFrame;
+
+    /* Held chord with bend, as a busy performance */
+    (void)cv_param_set(CV_PARAM_MODE, CV_MODE_QUAD);
+    (void)cv_engine_midi(MIDI_MSG_PACK(MIDI_NOTE_ON, 60U, 100U));
+    (void)cv_engine_midi(MIDI_MSG_PACK(MIDI_NOTE_ON, 64U, 100U));
+    (void)cv_engine_midi(MIDI_MSG_PACK(MIDI_NOTE_ON, 67U, 100U));
+    (void)cv_engine_midi(MIDI_MSG_PACK(MIDI_PITCH_BEND, 0x00U, 0x50U));
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        cv_engine_tick();
+        cv_engine_get_frame(&xFrame);
+        u32Sink += xFrame.analog[0];
+    }
+}
+
+static double _measure(const bench_t *pxBench)
+{
+    uint32_t u32Iter = 1000U;
+    uint64_t u64Elapsed = 0U;
+    double dBest = 0.0;
+
+    /* Scale iterations to the target run time, also warms caches up */
+    while ((u64Elapsed < (BENCH_RUN_NS / 4U)) && (u32Iter < (UINT32_MAX / 8U)))
+    {
+        uint64_t u64Start = _now_ns();
+
+        pxBench->run(u32Iter);
+        u64Elapsed = _now_ns() - u64Start;
+        if (u64Elapsed < (BENCH_RUN_NS / 4U))
+        {
+            u32Iter *= 4U;
+        }
+    }
+    u32Iter = (uint32_t)(((double)u32Iter * (double)BENCH_RUN_NS) / (double)(u64Elapsed + 1U)) + 1U;
+
+    for (uint32_t i = 0; i < BENCH_REPEAT; i++)
+    {
+        uint64_t u64Start = _now_ns();
+        double dNsOp;
+
+        pxBench->run(u32Iter);
+        dNsOp = (double)(_now_ns() - u64Start) / (double)u32Iter;
+        dBest = ((i == 0U) || (dNsOp < dBest)) ? dNsOp : dBest;
+    }
+
+    return dBest;
+}
+
+static bool _base_load(const char *pcPath)
+{
+    FILE *pxFile = fopen(pcPath, "r");
+    char cLine[128];
+
+    while ((pxFile != NULL) && (u32BaseNum < BENCH_BASE_NUM) && (fgets(cLine, sizeof(cLine), pxFile) != NULL))
+    {
+        bench_base_t *pxBase = &xBase[u32BaseNum];
+
+        /* Header and comments do not parse */
+        if (sscanf(cLine, "%31[^,],%lf", pxBase->name, &pxBase->ns_per_op) == 2)
+        {
+            u32BaseNum++;
+        }
+    }
+
+    if (pxFile != NULL)
+    {
+        fclose(pxFile);
+    }
+
+    return (pxFile != NULL);
+}
+
+static const bench_base_t *_base_find(const char *pcName)
+{
+    const bench_base_t *pxRetval = NULL;
+
+    for (uint32_t i = 0; (pxRetval == NULL) && (i < u32BaseNum); i++)
+    {
+        if (strcmp(xBase[i].name, pcName) == 0)
+        {
+            pxRetval = &xBase[i];
+        }
+    }
+
+    return pxRetval;
+}
+
+/* Public application code ---------------------------------------------------*/
+
+/* Kernel hooks, the scheduler never starts here so none of them runs */
+void vApplicationTickHook(void)
+{
+}
+
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
+{
+    USER_ASSERT(0U);
+}
+
+void SYS_TRACE_Record(uint8_t type, uint8_t id, uint16_t arg)
+{
+}
+
+uint32_t SYS_RTOS_GetTimeUs(void)
+{
+    return (uint32_t)(_now_ns() / 1000U);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *pcFilter = NULL;
+    double dThreshold = BENCH_THRESHOLD;
+    bool bBase = false;
+    int iRetval = EXIT_SUCCESS;
+
+    vErrorInit(_error_print);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "-b") == 0) && ((i + 1) < argc))
+        {
+            bBase = _base_load(argv[++i]);
+            if (!bBase)
+            {
+                fprintf(stderr, "%s: no baseline, skipping comparison\n", argv[i]);
+            }
+        }
+        else if ((strcmp(argv[i], "-t") == 0) && ((i + 1) < argc))
+        {
+            dThreshold = atof(argv[++i]);
+        }
+        else
+        {
+            pcFilter = argv[i];
+        }
+    }
+
+    /* Code under test, as set up at boot */
+    circular_buf_init(&xCbuf, u8CbufData, sizeof(u8CbufData));
+    (void)FreeRTOS_CLIRegisterCommandTable(xCliCmds, sizeof(xCliCmds) / sizeof(xCliCmds[0]));
+    (void)cv_cal_init();
+    cv_engine_init();
+
+    fprintf(stdout, "name,ns_per_op,ops_per_sec%s\n", bBase ? ",baseline_ns_per_op,change_pct" : "");
+
+    for (uint32_t i = 0; i < (sizeof(xBenches) / sizeof(xBenches[0])); i++)
+    {
+        const bench_t *pxBench = &xBenches[i];
+
+        if ((pcFilter == NULL) || (strstr(pxBench->name, pcFilter) != NULL))
+        {
+            double dNsOp = _measure(pxBench);
+            const bench_base_t *pxBase = bBase ? _base_find(pxBench->name) : NULL;
+
+            fprintf(stdout, "%s,%.2f,%.0f", pxBench->name, dNsOp, 1e9 / dNsOp);
+
+            if (pxBase != NULL)
+            {
+                double dChange = ((dNsOp - pxBase->ns_per_op) * 100.0) / pxBase->ns_per_op;
+
+                fprintf(stdout, ",%.2f,%+.1f", pxBase->ns_per_op, dChange);
+                if (dChange > dThreshold)
+                {
+                    fprintf(stderr, "%s: %.1f%% slower than baseline\n", pxBench->name, dChange);
+                    iRetval = EXIT_FAILURE;
+                }
+            }
+            else if (bBase)
+            {
+                fprintf(stdout, ",,");
+            }
+            else
+            {
+                /* No comparison */
+            }
+
+            fprintf(stdout, "\n");
+            fflush(stdout);
+        }
+    }
+
+    return iRetval;
+}
+
+/* EOF */
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Generate lookup tables used by App/Src/cv_curve.c, App/Src/cv_lfo.c and
+App/Src/cv_env.c.
+
+Each curve maps 256 input steps to a 16 bit output code. The sine table
+holds the first quarter of a sine wave with 15 bit amplitude. The envelope
+table holds an exponential segment, 257 entries with 15 bit amplitude so
+the last step can be interpolated. Output is printed as C initializers to
+paste on the tables.
+
+Usage: curve_gen.py [curves|sine|env]
+"""
+
+import math
+import sys
+
+CURVE_SIZE = 256
+CODE_MAX = 0xFFFF
+
+# Quarter wave sine entries and amplitude
+SINE_SIZE = 256
+SINE_MAX = 0x7FFF
+
+# Envelope segment entries, amplitude and steepness
+ENV_SIZE = 256
+ENV_MAX = 0x7FFF
+ENV_K = 5.0
+
+# Exponential curve steepness
+EXP_K = 4.0
+
+
+def curve_linear(x):
+    return x
+
+
+def curve_exp(x):
+    return (math.exp(EXP_K * x) - 1.0) / (math.exp(EXP_K) - 1.0)
+
+
+def curve_log(x):
+    return 1.0 - curve_exp(1.0 - x)
+
+
+def print_table(name, fn):
+    values = [int(round(fn(i / (CURVE_SIZE - 1)) * CODE_MAX)) for i in range(CURVE_SIZE)]
+    print("    /* {} */".format(name))
+    print("    {")
+    for i in range(0, CURVE_SIZE, 8):
+        print("        " + ", ".join("0x{:04X}".format(v) for v in values[i:i + 8]) + ",")
+    print("    },")
+
+
+def print_sine():
+    # Sample on half steps so the quarter mirrors without repeating entries
+    values = [int(round(math.sin((i + 0.5) * math.pi / (2 * SINE_SIZE)) * SINE_MAX)) for i in range(SINE_SIZE)]
+    for i in range(0, SINE_SIZE, 8):
+        print("    " + ", ".join("0x{:04X}".format(v) for v in values[i:i + 8]) + ",")
+
+
+def print_env():
+    # RC charge shape, normalized to reach full amplitude on last entry
+    def env(x):
+        return (1.0 - math.exp(-ENV_K * x)) / (1.0 - math.exp(-ENV_K))
+    values = [int(round(env(i / ENV_SIZE) * ENV_MAX)) for i in range(ENV_SIZE + 1)]
+    for i in range(0, ENV_SIZE + 1, 8):
+        print("    " + ", ".join("0x{:04X}".format(v) for v in values[i:i + 8]) + ",")
+
+
+def main():
+    table = sys.argv[1] if len(sys.argv) > 1 else "curves"
+    if table == "sine":
+        print_sine()
+    elif table == "env":
+        print_env()
+    else:
+        print_table("Linear", curve_linear)
+        print_table("Exponential", curve_exp)
+        print_table("Logarithmic", curve_log)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
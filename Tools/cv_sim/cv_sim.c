@@ -0,0 +1,1084 @@
+/**
+ * @file    cv_sim.c
+ * @author  Sebastián Del Moral Gallardo.
+ * @brief   Deterministic simulator of the CV output path on a virtual clock.
+ *
+ * Runs the CV task body of cv_loop on the host, with the serial, compare
+ * and output BSP calls emulated on a virtual clock: MIDI bytes arrive on the
+ * wire at 31250 baud and are processed on the idle line event, output ticks
+ * latch the last published frame and compare events raise interpolated
+ * clock pulses. The task takes no time, so every run of a script gives the
+ * same output writes.
+ *
+ * Script, one event per line, times in microseconds, '#' starts a comment:
+ *     <time> <hex bytes>       MIDI bytes, start of the first one on the wire
+ *     <time> mode <name>       mono, dual, quad or gate, as set mode
+ *     <time> set <name> <value> set a parameter, as the CLI command
+ *     <time> cc|lfo|env|gout|gmap|clk <values>
+ *                              change the active preset, as the CLI command
+ *                              of the same name, names given by their number
+ *     <time> save <preset>     store the active configuration on a preset
+ *     <time> end               stop the run, default is 1 s after last event
+ *
+ * Preset changes wait for the engine to take the previous one, as the CLI.
+ *
+ * Every analog and gate write is recorded on a compact trace, see the
+ * format on the trace defines. Usage:
+ *     cv_sim [-o out.trc] [-c golden.trc] <script>
+ *     cv_sim -d <trace.trc>
+ *
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cv_engine.h"
+#include "cv_clock.h"
+#include "cv_ctrl.h"
+#include "cv_curve.h"
+#include "cv_env.h"
+#include "cv_lfo.h"
+#include "cv_loop.h"
+#include "cv_param.h"
+#include "cv_preset.h"
+#include "midi_lib.h"
+#include "sys_cv.h"
+#include "sys_serial.h"
+#include "user_error.h"
+
+/* Private typedef -----------------------------------------------------------*/
+
+/** MIDI byte on the wire */
+typedef struct sim_byte
+{
+    uint64_t done_us;       /**< Time the stop bit ends */
+    uint8_t data;           /**< Byte value */
+} sim_byte_t;
+
+/** Idle line event, makes received bytes visible to the task */
+typedef struct sim_idle
+{
+    uint64_t time_us;       /**< Event time */
+    uint32_t end;           /**< Index after the last byte received */
+} sim_idle_t;
+
+/** Script commands other than MIDI bytes */
+typedef enum
+{
+    SIM_CMD_SET = 0U,       /**< Parameter, id and value */
+    SIM_CMD_CC,             /**< Controller mapping */
+    SIM_CMD_LFO,            /**< LFO */
+    SIM_CMD_ENV,            /**< Envelope */
+    SIM_CMD_GOUT,           /**< Gate output */
+    SIM_CMD_GMAP,           /**< Note to gates map entry */
+    SIM_CMD_CLK,            /**< Clock outputs */
+    SIM_CMD_SAVE,           /**< Preset save */
+    SIM_CMD_NUM,
+} sim_cmd_kind_t;
+
+/** Change requested by script */
+typedef struct sim_cmd
+{
+    uint64_t time_us;       /**< Change time */
+    uint8_t kind;           /**< Command, sim_cmd_kind_t */
+    int32_t arg[8];         /**< Values, in CLI command order */
+} sim_cmd_t;
+
+/** Growing byte buffer */
+typedef struct sim_buf
+{
+    uint8_t *data;          /**< Content */
+    size_t len;             /**< Used bytes */
+    size_t size;            /**< Allocated bytes */
+} sim_buf_t;
+
+/** Decoded trace entry */
+typedef struct sim_entry
+{
+    uint64_t time_us;       /**< Write time */
+    uint8_t out;            /**< Analog output, SIM_OUT_GATES or a write count */
+    uint32_t value;         /**< Code, gate mask or number of writes */
+} sim_entry_t;
+
+/* Private define ------------------------------------------------------------*/
+
+/* Trace header: magic, u8 version, u8 analog outputs, u16 tick frequency.
+ * Records: varint time delta in us, u8 tag, then a u16 code for each analog
+ * output set on the tag bits 0..3 and a u8 mask if bit 4 is set. Only writes
+ * that change an output are stored. Tag SIM_TAG_END closes the trace with
+ * u32 analog and u32 gate write counts, all values little endian. */
+#define SIM_TRACE_MAGIC     "MCVT"
+#define SIM_TRACE_VERSION   1U
+#define SIM_TRACE_HEADER    8U
+#define SIM_TAG_GATES       (1U << 4)
+#define SIM_TAG_END         0x80U
+
+/* Decoded entry outputs */
+#define SIM_OUT_GATES       CV_ANALOG_NUM
+#define SIM_OUT_END         0xFEU
+#define SIM_OUT_END_GATES   0xFFU
+
+/* Time of a MIDI byte on the wire, 10 bits at 31250 baud */
+#define SIM_MIDI_BYTE_US    320U
+
+/* Output tick period */
+#define SIM_TICK_US         (1000000UL / CV_ENGINE_TICK_HZ)
+
+/* Run time after the last event if script has no end */
+#define SIM_TAIL_US         1000000ULL
+
+/* Longest script line */
+#define SIM_LINE_SIZE       256U
+
+/* Longest compare delay of the output timer */
+#define SIM_COMPARE_MAX_US  0xFFFFU
+
+/* Private macro -------------------------------------------------------------*/
+
+/** Append an item to a growing array */
+#define SIM_PUSH(arr, num, item)                                        \
+    do {                                                                \
+        (arr) = realloc((arr), ((num) + 1U) * sizeof(*(arr)));          \
+        USER_ASSERT((arr) != NULL);                                     \
+        (arr)[(num)++] = (item);                                        \
+    } while (0)
+
+#define USER_ASSERT(A)      ERR_ASSERT(A)
+
+/* Private variables ---------------------------------------------------------*/
+
+/** Script */
+static sim_byte_t *pxBytes = NULL;
+static uint32_t u32ByteNum = 0U;
+static sim_idle_t *pxIdles = NULL;
+static uint32_t u32IdleNum = 0U;
+static sim_cmd_t *pxCmds = NULL;
+static uint32_t u32CmdNum = 0U;
+static uint64_t u64EndUs = 0U;
+
+/** Script command names, sim_cmd_kind_t order, and values of each */
+static const char * const pcCmdNames[SIM_CMD_NUM] = {
+    "set", "cc", "lfo", "env", "gout", "gmap", "clk", "save"
+};
+static const uint8_t u8CmdArgs[SIM_CMD_NUM] = {
+    2U, 5U, 5U, 8U, 4U, 2U, 5U, 1U
+};
+
+/** Virtual time */
+static uint64_t u64NowUs = 0U;
+
+/** Serial reception, bytes up to the last idle line event are readable */
+static uint32_t u32RxPos = 0U;
+static uint32_t u32RxEnd = 0U;
+static uint32_t u32RxTime = 0U;
+
+/** Clock compare */
+static bool bCompareOn = false;
+static uint64_t u64CompareUs = 0U;
+
+/** Output trace */
+static sim_buf_t xTrace;
+static uint64_t u64TraceUs = 0U;
+static uint16_t u16LastCodes[CV_ANALOG_NUM];
+static uint8_t u8LastGates = 0U;
+static bool bTraceFirst = true;
+static uint32_t u32AnalogWrites = 0U;
+static uint32_t u32GateWrites = 0U;
+
+/* Private function prototypes -----------------------------------------------*/
+
+/**
+  * @brief Show assert info and stop
+  * @param msg error message
+  * @param len size of error message
+  * @retval None
+  */
+static void _error_print(char *msg, uint32_t len);
+
+/**
+  * @brief Append bytes to a buffer
+  * @param pxBuf buffer
+  * @param pvData data to append
+  * @param len number of bytes
+  * @retval None
+  */
+static void _buf_put(sim_buf_t *pxBuf, const void *pvData, size_t len);
+
+/**
+  * @brief Append a trace record header, time delta and tag
+  * @param u8Tag record tag
+  * @retval None
+  */
+static void _trace_record(uint8_t u8Tag);
+
+/**
+  * @brief Close trace with the write counts
+  * @retval None
+  */
+static void _trace_end(void);
+
+/**
+  * @brief Decode a trace
+  * @param pu8Data trace content
+  * @param len trace size
+  * @param ppxEntries where to store the allocated entry list
+  * @retval number of entries, -1 if trace is not valid
+  */
+static long _trace_decode(const uint8_t *pu8Data, size_t len, sim_entry_t **ppxEntries);
+
+/**
+  * @brief Print a decoded entry
+  * @param pxFile output stream
+  * @param pxEntry entry
+  * @retval None
+  */
+static void _trace_print(FILE *pxFile, const sim_entry_t *pxEntry);
+
+/**
+  * @brief Read a whole file
+  * @param pcPath file path
+  * @param pxBuf where to store the content
+  * @retval true on success
+  */
+static bool _file_read(const char *pcPath, sim_buf_t *pxBuf);
+
+/**
+  * @brief Load a script, MIDI bytes are placed on the wire and idle events
+  *        are derived from the gaps between them
+  * @param pcPath script path
+  * @retval true on success
+  */
+static bool _script_load(const char *pcPath);
+
+/**
+  * @brief Parse and check the values of a script command
+  * @param pxCmd command, kind set
+  * @param pcSave strtok_r state of the script line
+  * @retval true if values are valid, as the CLI command checks them
+  */
+static bool _script_cmd(sim_cmd_t *pxCmd, char **pcSave);
+
+/**
+  * @brief Get virtual time, cv_loop time source
+  * @retval time in microseconds
+  */
+static uint32_t _sim_time(void);
+
+/**
+  * @brief Apply a script command, as the CLI command does
+  * @param pxCmd command
+  * @retval None
+  */
+static void _sim_apply(const sim_cmd_t *pxCmd);
+
+/**
+  * @brief Run script until its end time
+  * @retval None
+  */
+static void _sim_run(void);
+
+/**
+  * @brief Compare a trace with a golden one, show the first difference
+  * @param pxTrace trace of this run
+  * @param pcGolden golden trace path
+  * @retval true if both match
+  */
+static bool _sim_check(const sim_buf_t *pxTrace, const char *pcGolden);
+
+/**
+  * @brief Print a trace file as text
+  * @param pcPath trace path
+  * @retval process exit code
+  */
+static int _sim_dump(const char *pcPath);
+
+/* Private application code --------------------------------------------------*/
+
+static void _error_print(char *msg, uint32_t len)
+{
+    fwrite(msg, 1U, len, stderr);
+    abort();
+}
+
+static void _buf_put(sim_buf_t *pxBuf, const void *pvData, size_t len)
+{
+    if ((pxBuf->len + len) > pxBuf->size)
+    {
+        pxBuf->size = (pxBuf->size + len) * 2U;
+        pxBuf->data = realloc(pxBuf->data, pxBuf->size);
+        USER_ASSERT(pxBuf->data != NULL);
+    }
+
+    memcpy(&pxBuf->data[pxBuf->len], pvData, len);
+    pxBuf->len += len;
+}
+
+static void _trace_record(uint8_t u8Tag)
+{
+    uint64_t u64Delta = u64NowUs - u64TraceUs;
+
+    /* LEB128, 7 bits per byte, low bits first */
+    do
+    {
+        uint8_t u8Byte = (uint8_t)(u64Delta & 0x7FU);
+
+        u64Delta >>= 7;
+        if (u64Delta != 0U)
+        {
+            u8Byte |= 0x80U;
+        }
+        _buf_put(&xTrace, &u8Byte, 1U);
+    } while (u64Delta != 0U);
+
+    _buf_put(&xTrace, &u8Tag, 1U);
+    u64TraceUs = u64NowUs;
+}
+
+static void _trace_end(void)
+{
+    uint8_t u8Counts[8];
+
+    u8Counts[0] = (uint8_t)u32AnalogWrites;
+    u8Counts[1] = (uint8_t)(u32AnalogWrites >> 8);
+    u8Counts[2] = (uint8_t)(u32AnalogWrites >> 16);
+    u8Counts[3] = (uint8_t)(u32AnalogWrites >> 24);
+    u8Counts[4] = (uint8_t)u32GateWrites;
+    u8Counts[5] = (uint8_t)(u32GateWrites >> 8);
+    u8Counts[6] = (uint8_t)(u32GateWrites >> 16);
+    u8Counts[7] = (uint8_t)(u32GateWrites >> 24);
+
+    _trace_record(SIM_TAG_END);
+    _buf_put(&xTrace, u8Counts, sizeof(u8Counts));
+}
+
+static long _trace_decode(const uint8_t *pu8Data, size_t len, sim_entry_t **ppxEntries)
+{
+    sim_entry_t *pxEntries = NULL;
+    uint32_t u32Num = 0U;
+    uint64_t u64Time = 0U;
+    size_t pos = SIM_TRACE_HEADER;
+    bool bEnd = false;
+    bool bValid = (len >= SIM_TRACE_HEADER) &&
+                  (memcmp(pu8Data, SIM_TRACE_MAGIC, 4U) == 0) &&
+                  (pu8Data[4] == SIM_TRACE_VERSION) &&
+                  (pu8Data[5] == CV_ANALOG_NUM);
+
+    while (bValid && !bEnd && (pos < len))
+    {
+        uint64_t u64Delta = 0U;
+        uint32_t u32Shift = 0U;
+        uint8_t u8Tag;
+
+        do
+        {
+            u64Delta |= (uint64_t)(pu8Data[pos] & 0x7FU) << u32Shift;
+            u32Shift += 7U;
+        } while ((pu8Data[pos++] & 0x80U) && (pos < len));
+
+        bValid = (pos < len);
+        u8Tag = bValid ? pu8Data[pos++] : 0U;
+        u64Time += u64Delta;
+
+        if (bValid && (u8Tag == SIM_TAG_END))
+        {
+            bValid = ((pos + 8U) == len);
+            for (uint8_t i = 0; bValid && (i < 2U); i++)
+            {
+                const uint8_t *pu8Count = &pu8Data[pos + (4U * i)];
+                sim_entry_t xEntry = {u64Time, (uint8_t)(SIM_OUT_END + i),
+                                      (uint32_t)pu8Count[0] | ((uint32_t)pu8Count[1] << 8) |
+                                      ((uint32_t)pu8Count[2] << 16) | ((uint32_t)pu8Count[3] << 24)};
+
+                SIM_PUSH(pxEntries, u32Num, xEntry);
+            }
+            bEnd = true;
+        }
+
+        for (uint8_t i = 0; bValid && !bEnd && (i < CV_ANALOG_NUM); i++)
+        {
+            if ((u8Tag & (1U << i)) != 0U)
+            {
+                bValid = ((pos + 2U) <= len);
+                if (bValid)
+                {
+                    sim_entry_t xEntry = {u64Time, i, (uint32_t)pu8Data[pos] | ((uint32_t)pu8Data[pos + 1U] << 8)};
+
+                    SIM_PUSH(pxEntries, u32Num, xEntry);
+                    pos += 2U;
+                }
+            }
+        }
+
+        if (bValid && !bEnd && ((u8Tag & SIM_TAG_GATES) != 0U))
+        {
+            bValid = (pos < len);
+            if (bValid)
+            {
+                sim_entry_t xEntry = {u64Time, SIM_OUT_GATES, pu8Data[pos++]};
+
+                SIM_PUSH(pxEntries, u32Num, xEntry);
+            }
+        }
+    }
+
+    *ppxEntries = pxEntries;
+
+    return (bValid && bEnd) ? (long)u32Num : -1;
+}
+
+static void _trace_print(FILE *pxFile, const sim_entry_t *pxEntry)
+{
+    if (pxEntry->out == SIM_OUT_GATES)
+    {
+        fprintf(pxFile, "%10llu gates 0x%02x\n", (unsigned long long)pxEntry->time_us, (unsigned)pxEntry->value);
+    }
+    else if (pxEntry->out >= SIM_OUT_END)
+    {
+        fprintf(pxFile, "%10llu %s writes %u\n", (unsigned long long)pxEntry->time_us,
+                (pxEntry->out == SIM_OUT_END) ? "cv" : "gate", (unsigned)pxEntry->value);
+    }
+    else
+    {
+        fprintf(pxFile, "%10llu cv%u %5u\n", (unsigned long long)pxEntry->time_us, (unsigned)pxEntry->out,
+                (unsigned)pxEntry->value);
+    }
+}
+
+static bool _file_read(const char *pcPath, sim_buf_t *pxBuf)
+{
+    FILE *pxFile = fopen(pcPath, "rb");
+    bool bRetval = (pxFile != NULL);
+
+    if (bRetval)
+    {
+        uint8_t u8Chunk[4096];
+        size_t len;
+
+        while ((len = fread(u8Chunk, 1U, sizeof(u8Chunk), pxFile)) != 0U)
+        {
+            _buf_put(pxBuf, u8Chunk, len);
+        }
+        fclose(pxFile);
+    }
+
+    return bRetval;
+}
+
+static bool _script_load(const char *pcPath)
+{
+    FILE *pxFile = fopen(pcPath, "r");
+    char cLine[SIM_LINE_SIZE];
+    uint32_t u32LineNum = 0U;
+    uint64_t u64WireFree = 0U;
+    uint64_t u64Last = 0U;
+    bool bEnd = false;
+    bool bRetval = (pxFile != NULL);
+
+    while (bRetval && (fgets(cLine, sizeof(cLine), pxFile) != NULL))
+    {
+        char *pcSave = NULL;
+        char *pcTime;
+        char *pcToken;
+        uint8_t u8Kind = SIM_CMD_NUM;
+
+        u32LineNum++;
+        cLine[strcspn(cLine, "#\r\n")] = '\0';
+        pcTime = strtok_r(cLine, " \t", &pcSave);
+        if (pcTime != NULL)
+        {
+            char *pcEnd = NULL;
+            uint64_t u64Time = strtoull(pcTime, &pcEnd, 10);
+
+            bRetval = (*pcEnd == '\0') && (u64Time >= u64Last);
+            pcToken = bRetval ? strtok_r(NULL, " \t", &pcSave) : NULL;
+            u64Last = u64Time;
+
+            for (uint8_t i = SIM_CMD_CC; (pcToken != NULL) && (i < SIM_CMD_NUM); i++)
+            {
+                if (strcmp(pcToken, pcCmdNames[i]) == 0)
+                {
+                    u8Kind = i;
+                }
+            }
+
+            if (pcToken == NULL)
+            {
+                bRetval = false;
+            }
+            else if (strcmp(pcToken, "end") == 0)
+            {
+                u64EndUs = u64Time;
+                bEnd = true;
+            }
+            else if ((strcmp(pcToken, "mode") == 0) || (strcmp(pcToken, "set") == 0))
+            {
+                sim_cmd_t xCmd = {u64Time, SIM_CMD_SET, {0}};
+                const cv_param_desc_t *pxDesc;
+                uint8_t u8Id = CV_PARAM_MODE;
+                /* Mode is a parameter like any other */
+                const char *pcName = (pcToken[0] == 's') ? strtok_r(NULL, " \t", &pcSave) : "mode";
+
+                bRetval = (pcName != NULL) && cv_param_find(pcName, strlen(pcName), &u8Id);
+                pcToken = bRetval ? strtok_r(NULL, " \t", &pcSave) : NULL;
+                bRetval = (pcToken != NULL) && cv_param_parse(u8Id, pcToken, strlen(pcToken), &xCmd.arg[1]);
+                pxDesc = cv_param_get_desc(u8Id);
+                bRetval = bRetval && (xCmd.arg[1] >= pxDesc->min) && (xCmd.arg[1] <= pxDesc->max);
+                xCmd.arg[0] = u8Id;
+                if (bRetval)
+                {
+                    SIM_PUSH(pxCmds, u32CmdNum, xCmd);
+                }
+            }
+            else if (u8Kind != SIM_CMD_NUM)
+            {
+                sim_cmd_t xCmd = {u64Time, u8Kind, {0}};
+
+                bRetval = _script_cmd(&xCmd, &pcSave);
+                if (bRetval)
+                {
+                    SIM_PUSH(pxCmds, u32CmdNum, xCmd);
+                }
+            }
+            else
+            {
+                /* Bytes of a line go back to back, after any still on the wire */
+                uint64_t u64Start = (u64Time > u64WireFree) ? u64Time : u64WireFree;
+
+                /* A gap of a whole character raises idle line on the last byte */
+                if ((u32ByteNum != 0U) && (u64Start >= (u64WireFree + SIM_MIDI_BYTE_US)))
+                {
+                    sim_idle_t xIdle = {u64WireFree + SIM_MIDI_BYTE_US, u32ByteNum};
+
+                    SIM_PUSH(pxIdles, u32IdleNum, xIdle);
+                }
+
+                while (bRetval && (pcToken != NULL))
+                {
+                    unsigned long ulByte = strtoul(pcToken, &pcEnd, 16);
+
+                    bRetval = (*pcEnd == '\0') && (ulByte <= 0xFFU);
+                    if (bRetval)
+                    {
+                        sim_byte_t xByte = {u64Start + SIM_MIDI_BYTE_US, (uint8_t)ulByte};
+
+                        SIM_PUSH(pxBytes, u32ByteNum, xByte);
+                        u64Start = xByte.done_us;
+                    }
+                    pcToken = strtok_r(NULL, " \t", &pcSave);
+                }
+                u64WireFree = u64Start;
+            }
+        }
+
+        if (!bRetval)
+        {
+            fprintf(stderr, "%s:%u: invalid line\n", pcPath, (unsigned)u32LineNum);
+        }
+    }
+
+    if (bRetval && (u32ByteNum != 0U))
+    {
+        sim_idle_t xIdle = {u64WireFree + SIM_MIDI_BYTE_US, u32ByteNum};
+
+        SIM_PUSH(pxIdles, u32IdleNum, xIdle);
+        u64Last = (xIdle.time_us > u64Last) ? xIdle.time_us : u64Last;
+    }
+
+    if (!bEnd)
+    {
+        u64EndUs = u64Last + SIM_TAIL_US;
+    }
+
+    if (pxFile != NULL)
+    {
+        fclose(pxFile);
+    }
+
+    return bRetval;
+}
+
+static bool _script_cmd(sim_cmd_t *pxCmd, char **pcSave)
+{
+    const int32_t *pi32Arg = pxCmd->arg;
+    bool bRetval = true;
+
+    for (uint8_t i = 0; bRetval && (i < u8CmdArgs[pxCmd->kind]); i++)
+    {
+        const char *pcToken = strtok_r(NULL, " \t", pcSave);
+        char *pcEnd = NULL;
+
+        bRetval = (pcToken != NULL);
+        if (bRetval)
+        {
+            long lValue = strtol(pcToken, &pcEnd, 10);
+
+            bRetval = (*pcEnd == '\0') && (lValue >= 0) && (lValue <= (long)UINT16_MAX);
+            pxCmd->arg[i] = (int32_t)lValue;
+        }
+    }
+
+    if (bRetval)
+    {
+        switch (pxCmd->kind)
+        {
+        case SIM_CMD_CC:
+        {
+            cv_ctrl_out_cfg_t xCfg = {(uint8_t)pi32Arg[1], (uint8_t)pi32Arg[3], (uint8_t)pi32Arg[4], (uint16_t)pi32Arg[2]};
+
+            bRetval = (pi32Arg[0] < (int32_t)CV_ANALOG_NUM) && (pi32Arg[1] < (int32_t)CV_CTRL_SRC_NUM) &&
+                      (pi32Arg[3] <= UINT8_MAX) && (pi32Arg[4] < (int32_t)CV_CURVE_NUM) &&
+                      cv_ctrl_check_output(&xCfg);
+            break;
+        }
+        case SIM_CMD_LFO:
+            bRetval = (pi32Arg[0] < (int32_t)CV_LFO_NUM) && (pi32Arg[1] < (int32_t)CV_LFO_WAVE_NUM) &&
+                      (pi32Arg[3] != 0) && (pi32Arg[3] <= (int32_t)CV_LFO_CLOCKS_MAX) &&
+                      (pi32Arg[4] <= (int32_t)((pi32Arg[2] == (int32_t)CV_ANALOG_NUM) ? CV_LFO_VIBRATO_MAX : CV_CODE_MAX));
+            break;
+        case SIM_CMD_ENV:
+            bRetval = (pi32Arg[0] < (int32_t)CV_ENV_NUM) && (pi32Arg[2] < (int32_t)CV_GATE_NUM) &&
+                      (pi32Arg[3] <= (int32_t)CV_ENV_TIME_MAX_MS) && (pi32Arg[4] <= (int32_t)CV_ENV_TIME_MAX_MS) &&
+                      (pi32Arg[6] <= (int32_t)CV_ENV_TIME_MAX_MS) && (pi32Arg[7] <= 1);
+            break;
+        case SIM_CMD_GOUT:
+            bRetval = (pi32Arg[0] < (int32_t)CV_GATE_NUM) && (pi32Arg[1] < (int32_t)CV_GATE_TYPE_NUM) &&
+                      (pi32Arg[2] <= (int32_t)CV_GATE_LEN_MAX_MS) && (pi32Arg[3] <= UINT8_MAX);
+            break;
+        case SIM_CMD_GMAP:
+            bRetval = (pi32Arg[0] < (int32_t)MIDI_NOTE_NUM) && (pi32Arg[1] < (int32_t)(1UL << CV_GATE_NUM));
+            break;
+        case SIM_CMD_CLK:
+            bRetval = (pi32Arg[3] != 0) && (pi32Arg[3] <= (int32_t)CV_CLOCK_DIV_MAX) &&
+                      (pi32Arg[4] != 0) && (pi32Arg[4] <= (int32_t)CV_CLOCK_MUL_MAX);
+            break;
+        case SIM_CMD_SAVE:
+            bRetval = (pi32Arg[0] < (int32_t)CV_PRESET_NUM);
+            break;
+        default:
+            break;
+        }
+    }
+
+    return bRetval;
+}
+
+static uint32_t _sim_time(void)
+{
+    return (uint32_t)u64NowUs;
+}
+
+static void _sim_apply(const sim_cmd_t *pxCmd)
+{
+    const int32_t *pi32Arg = pxCmd->arg;
+    cv_preset_t *pxPreset = NULL;
+
+    if (pxCmd->kind == SIM_CMD_SET)
+    {
+        (void)cv_param_set((uint8_t)pi32Arg[0], pi32Arg[1]);
+    }
+    else if (pxCmd->kind == SIM_CMD_SAVE)
+    {
+        USER_ASSERT(cv_preset_save((uint8_t)pi32Arg[0]));
+    }
+    else
+    {
+        pxPreset = cv_preset_edit();
+        USER_ASSERT(pxPreset != NULL);
+    }
+
+    if (pxCmd->kind == SIM_CMD_CC)
+    {
+        cv_ctrl_out_cfg_t *pxCfg = &pxPreset->ctrl[pi32Arg[0]];
+        pxCfg->src = (uint8_t)pi32Arg[1];
+        pxCfg->number = (uint16_t)pi32Arg[2];
+        pxCfg->smooth = (uint8_t)pi32Arg[3];
+        pxCfg->curve = (uint8_t)pi32Arg[4];
+    }
+    else if (pxCmd->kind == SIM_CMD_LFO)
+    {
+        cv_lfo_cfg_t *pxLfo = &pxPreset->lfo[pi32Arg[0]];
+        pxLfo->wave = (uint8_t)pi32Arg[1];
+        pxLfo->clocks = (uint16_t)pi32Arg[3];
+        pxLfo->depth = (uint16_t)pi32Arg[4];
+        if (pi32Arg[2] < (int32_t)CV_ANALOG_NUM)
+        {
+            pxLfo->out = (uint8_t)pi32Arg[2];
+        }
+        else
+        {
+            pxLfo->out = (pi32Arg[2] == (int32_t)CV_ANALOG_NUM) ? CV_LFO_OUT_PITCH : CV_LFO_OUT_NONE;
+        }
+    }
+    else if (pxCmd->kind == SIM_CMD_ENV)
+    {
+        cv_env_cfg_t *pxEnv = &pxPreset->env[pi32Arg[0]];
+        pxEnv->out = (pi32Arg[1] < (int32_t)CV_ANALOG_NUM) ? (uint8_t)pi32Arg[1] : CV_ENV_OUT_NONE;
+        pxEnv->gate = (uint8_t)pi32Arg[2];
+        pxEnv->attack_ms = (uint16_t)pi32Arg[3];
+        pxEnv->decay_ms = (uint16_t)pi32Arg[4];
+        pxEnv->sustain = (uint16_t)pi32Arg[5];
+        pxEnv->release_ms = (uint16_t)pi32Arg[6];
+        pxEnv->velocity = (pi32Arg[7] != 0);
+    }
+    else if (pxCmd->kind == SIM_CMD_GOUT)
+    {
+        cv_gate_cfg_t *pxGate = &pxPreset->engine.gate[pi32Arg[0]];
+        pxGate->type = (uint8_t)pi32Arg[1];
+        pxGate->len_ticks = (uint16_t)CV_MS_TO_TICKS(pi32Arg[2]);
+        pxGate->accent_vel = (uint8_t)pi32Arg[3];
+    }
+    else if (pxCmd->kind == SIM_CMD_GMAP)
+    {
+        pxPreset->engine.gate_map[pi32Arg[0]] = (uint8_t)pi32Arg[1];
+    }
+    else if (pxCmd->kind == SIM_CMD_CLK)
+    {
+        cv_clock_cfg_t *pxClock = &pxPreset->clock;
+        pxClock->clock_out = (pi32Arg[0] < (int32_t)CV_GATE_NUM) ? (uint8_t)pi32Arg[0] : CV_CLOCK_OUT_NONE;
+        pxClock->run_out = (pi32Arg[1] < (int32_t)CV_GATE_NUM) ? (uint8_t)pi32Arg[1] : CV_CLOCK_OUT_NONE;
+        pxClock->reset_out = (pi32Arg[2] < (int32_t)CV_GATE_NUM) ? (uint8_t)pi32Arg[2] : CV_CLOCK_OUT_NONE;
+        pxClock->div = (uint8_t)pi32Arg[3];
+        pxClock->mul = (uint8_t)pi32Arg[4];
+    }
+    else
+    {
+        /* Parameter or save, nothing to publish */
+    }
+
+    if (pxPreset != NULL)
+    {
+        cv_preset_publish();
+    }
+}
+
+static void _sim_run(void)
+{
+    uint64_t u64NextTick = SIM_TICK_US;
+    uint32_t u32IdlePos = 0U;
+    uint32_t u32CmdPos = 0U;
+
+    /* Boot, as bCvTaskInit */
+    cv_loop_init(_sim_time);
+    cv_loop_start();
+
+    for (;;)
+    {
+        uint64_t u64Next = u64NextTick;
+        uint32_t u32Events = 0U;
+        bool bTick = false;
+
+        /* A preset change waits for a tick to take the one before */
+        if ((u32CmdPos < u32CmdNum) && (pxCmds[u32CmdPos].time_us < u64Next) &&
+            ((pxCmds[u32CmdPos].kind == SIM_CMD_SET) || !cv_preset_is_busy()))
+        {
+            u64Next = pxCmds[u32CmdPos].time_us;
+        }
+        if ((u32IdlePos < u32IdleNum) && (pxIdles[u32IdlePos].time_us < u64Next))
+        {
+            u64Next = pxIdles[u32IdlePos].time_us;
+        }
+        if (bCompareOn && (u64CompareUs < u64Next))
+        {
+            u64Next = u64CompareUs;
+        }
+        if (u64Next > u64EndUs)
+        {
+            break;
+        }
+
+        /* Delayed commands keep their place, time never goes back */
+        u64NowUs = (u64Next > u64NowUs) ? u64Next : u64NowUs;
+
+        /* CLI runs at lower priority, the engine picks the change on next call */
+        while ((u32CmdPos < u32CmdNum) && (pxCmds[u32CmdPos].time_us <= u64NowUs) &&
+               ((pxCmds[u32CmdPos].kind == SIM_CMD_SET) || !cv_preset_is_busy()))
+        {
+            _sim_apply(&pxCmds[u32CmdPos]);
+            u32CmdPos++;
+        }
+
+        /* Interrupts due at the same time notify the task once */
+        if (bCompareOn && (u64CompareUs == u64NowUs))
+        {
+            bCompareOn = false;
+            cv_loop_clock_edge();
+            u32Events |= CV_LOOP_EVENT_CLOCK;
+        }
+        if ((u32IdlePos < u32IdleNum) && (pxIdles[u32IdlePos].time_us == u64NowUs))
+        {
+            u32RxEnd = pxIdles[u32IdlePos++].end;
+            u32RxTime = (uint32_t)(u64NowUs - SIM_MIDI_BYTE_US);
+            u32Events |= CV_LOOP_EVENT_RX;
+        }
+        if (u64NextTick == u64NowUs)
+        {
+            cv_loop_latch();
+            u64NextTick += SIM_TICK_US;
+            bTick = true;
+        }
+
+        if ((u32Events != 0U) || bTick)
+        {
+            cv_loop_run(u32Events);
+        }
+    }
+
+    u64NowUs = u64EndUs;
+    _trace_end();
+}
+
+static bool _sim_check(const sim_buf_t *pxTrace, const char *pcGolden)
+{
+    sim_buf_t xGolden = {0};
+    bool bRetval = _file_read(pcGolden, &xGolden);
+
+    if (!bRetval)
+    {
+        fprintf(stderr, "%s: cannot read\n", pcGolden);
+    }
+    else if ((xGolden.len != pxTrace->len) || (memcmp(xGolden.data, pxTrace->data, xGolden.len) != 0))
+    {
+        sim_entry_t *pxGot = NULL;
+        sim_entry_t *pxExp = NULL;
+        long lGot = _trace_decode(pxTrace->data, pxTrace->len, &pxGot);
+        long lExp = _trace_decode(xGolden.data, xGolden.len, &pxExp);
+        long i = 0;
+
+        bRetval = false;
+        fprintf(stderr, "%s: mismatch\n", pcGolden);
+
+        while ((i < lGot) && (i < lExp) && (pxGot[i].time_us == pxExp[i].time_us) &&
+               (pxGot[i].out == pxExp[i].out) && (pxGot[i].value == pxExp[i].value))
+        {
+            i++;
+        }
+
+        fprintf(stderr, "expected: ");
+        if (i < lExp)
+        {
+            _trace_print(stderr, &pxExp[i]);
+        }
+        else
+        {
+            fprintf(stderr, "%s\n", (lExp < 0) ? "invalid trace" : "nothing");
+        }
+        fprintf(stderr, "got:      ");
+        if (i < lGot)
+        {
+            _trace_print(stderr, &pxGot[i]);
+        }
+        else
+        {
+            fprintf(stderr, "nothing\n");
+        }
+
+        free(pxGot);
+        free(pxExp);
+    }
+    else
+    {
+        /* Bit exact */
+    }
+
+    free(xGolden.data);
+
+    return bRetval;
+}
+
+static int _sim_dump(const char *pcPath)
+{
+    sim_buf_t xFile = {0};
+    sim_entry_t *pxEntries = NULL;
+    long lNum = -1;
+
+    if (_file_read(pcPath, &xFile))
+    {
+        lNum = _trace_decode(xFile.data, xFile.len, &pxEntries);
+    }
+
+    for (long i = 0; i < lNum; i++)
+    {
+        _trace_print(stdout, &pxEntries[i]);
+    }
+
+    if (lNum < 0)
+    {
+        fprintf(stderr, "%s: invalid trace\n", pcPath);
+    }
+
+    free(pxEntries);
+    free(xFile.data);
+
+    return (lNum < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* Public application code ---------------------------------------------------*/
+
+uint16_t SYS_SERIAL_Read(sys_serial_port_t dev, uint8_t *pdata, uint16_t max_len)
+{
+    uint16_t u16Len = 0U;
+
+    USER_ASSERT(dev == CV_LOOP_SERIAL);
+
+    while ((u16Len < max_len) && (u32RxPos != u32RxEnd))
+    {
+        pdata[u16Len++] = pxBytes[u32RxPos++].data;
+    }
+
+    return u16Len;
+}
+
+uint16_t SYS_SERIAL_GetReadCount(sys_serial_port_t dev)
+{
+    USER_ASSERT(dev == CV_LOOP_SERIAL);
+
+    return (uint16_t)(u32RxEnd - u32RxPos);
+}
+
+uint32_t SYS_SERIAL_GetRxTime(sys_serial_port_t dev)
+{
+    USER_ASSERT(dev == CV_LOOP_SERIAL);
+
+    return u32RxTime;
+}
+
+void SYS_CV_CompareStart(uint32_t delay_us)
+{
+    u64CompareUs = u64NowUs + ((delay_us < SIM_COMPARE_MAX_US) ? delay_us : SIM_COMPARE_MAX_US);
+    bCompareOn = true;
+}
+
+void SYS_CV_CompareStop(void)
+{
+    bCompareOn = false;
+}
+
+void SYS_CV_WriteAnalog(const uint16_t *codes)
+{
+    uint8_t u8Tag = 0U;
+
+    for (uint8_t i = 0; i < CV_ANALOG_NUM; i++)
+    {
+        if (bTraceFirst || (codes[i] != u16LastCodes[i]))
+        {
+            u8Tag |= (uint8_t)(1U << i);
+        }
+    }
+
+    if (u8Tag != 0U)
+    {
+        _trace_record(u8Tag);
+        for (uint8_t i = 0; i < CV_ANALOG_NUM; i++)
+        {
+            if ((u8Tag & (1U << i)) != 0U)
+            {
+                uint8_t u8Code[2] = {(uint8_t)codes[i], (uint8_t)(codes[i] >> 8)};
+
+                _buf_put(&xTrace, u8Code, sizeof(u8Code));
+                u16LastCodes[i] = codes[i];
+            }
+        }
+    }
+
+    u32AnalogWrites++;
+}
+
+void SYS_CV_WriteGates(uint8_t mask)
+{
+    if (bTraceFirst || (mask != u8LastGates))
+    {
+        _trace_record(SIM_TAG_GATES);
+        _buf_put(&xTrace, &mask, 1U);
+        u8LastGates = mask;
+    }
+
+    /* Gates are written right after the analog outputs on every latch */
+    bTraceFirst = false;
+    u32GateWrites++;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *pcOut = NULL;
+    const char *pcGolden = NULL;
+    const char *pcScript = NULL;
+    int iRetval = EXIT_SUCCESS;
+
+    vErrorInit(_error_print);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "-d") == 0) && ((i + 1) < argc))
+        {
+            return _sim_dump(argv[i + 1]);
+        }
+        else if ((strcmp(argv[i], "-o") == 0) && ((i + 1) < argc))
+        {
+            pcOut = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-c") == 0) && ((i + 1) < argc))
+        {
+            pcGolden = argv[++i];
+        }
+        else
+        {
+            pcScript = argv[i];
+        }
+    }
+
+    if (pcScript == NULL)
+    {
+        fprintf(stderr, "usage: cv_sim [-o out.trc] [-c golden.trc] <script>\n"
+                        "       cv_sim -d <trace.trc>\n");
+        iRetval = EXIT_FAILURE;
+    }
+    else if (!_script_load(pcScript))
+    {
+        iRetval = EXIT_FAILURE;
+    }
+    else
+    {
+        uint8_t u8Header[SIM_TRACE_HEADER] = {'M', 'C', 'V', 'T', SIM_TRACE_VERSION, CV_ANALOG_NUM,
+                                              (uint8_t)CV_ENGINE_TICK_HZ, (uint8_t)(CV_ENGINE_TICK_HZ >> 8)};
+        struct timespec xStart;
+        struct timespec xStop;
+        double dWallUs;
+
+        _buf_put(&xTrace, u8Header, sizeof(u8Header));
+
+        clock_gettime(CLOCK_MONOTONIC, &xStart);
+        _sim_run();
+        clock_gettime(CLOCK_MONOTONIC, &xStop);
+        dWallUs = ((double)(xStop.tv_sec - xStart.tv_sec) * 1e6) + ((double)(xStop.tv_nsec - xStart.tv_nsec) / 1e3);
+
+        fprintf(stderr, "%s: %.3f s virtual in %.3f ms, %.0fx real time, %zu trace bytes\n", pcScript,
+                (double)u64EndUs / 1e6, dWallUs / 1e3, (double)u64EndUs / ((dWallUs > 0.0) ? dWallUs : 1.0),
+                xTrace.len);
+
+        if (pcOut != NULL)
+        {
+            FILE *pxFile = fopen(pcOut, "wb");
+
+            if ((pxFile == NULL) || (fwrite(xTrace.data, 1U, xTrace.len, pxFile) != xTrace.len))
+            {
+                fprintf(stderr, "%s: cannot write\n", pcOut);
+                iRetval = EXIT_FAILURE;
+            }
+            if (pxFile != NULL)
+            {
+                fclose(pxFile);
+            }
+        }
+
+        if ((pcGolden != NULL) && !_sim_check(&xTrace, pcGolden))
+        {
+            iRetval = EXIT_FAILURE;
+        }
+    }
+
+    return iRetval;
+}
+
+/* EOF */
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""Convert a RAM trace dump to a Chrome trace JSON timeline.
+
+The dump is sent by the "trace dump" CLI command, see _trace_dump() on
+App/Src/cli_cmd.c and BSP/Inc/sys_trace.h. Input may be a raw capture of
+the whole serial session, the dump is found by its magic. Output loads on
+chrome://tracing or ui.perfetto.dev: one track per task with its running
+slices, one track for interrupt entries, and instant events for queue and
+notification operations on the track of the task running them. Wake up
+latency of tasks notified from interrupts, from notification to switch in,
+is summarized on stderr.
+
+Capture on Linux with the port in raw mode, for example:
+    stty -F /dev/ttyACM0 115200 raw -echo
+    cat /dev/ttyACM0 > trace.bin &
+    printf 'trace dump\\r' > /dev/ttyACM0
+
+Usage: trace_conv.py <dump> [out.json]
+"""
+
+import json
+import struct
+import sys
+
+MAGIC = b"MTRC"
+VERSION = 1
+HEADER = struct.Struct("<4sBBHIII")
+TASK = struct.Struct("<B7s")
+
+# Event types, sys_trace_type_t order
+TASK_IN = 1
+TASK_OUT = 2
+ISR = 3
+QUEUE_SEND = 4
+QUEUE_RECEIVE = 5
+NOTIFY_ISR = 6
+NOTIFY_WAIT = 7
+MARK = 8
+
+# Track of interrupt entries, task numbers start at 1
+ISR_TID = 0
+
+# Exception numbers of the handlers on BSP/Src/stm32g0xx_it.c
+IRQ_NAMES = {
+    11: "SVC",
+    14: "PendSV",
+    15: "SysTick",
+    16 + 9: "DMA1_Ch1",
+    16 + 10: "DMA1_Ch2_3",
+    16 + 16: "TIM3",
+    16 + 17: "TIM6",
+    16 + 22: "TIM17",
+    16 + 27: "USART1",
+    16 + 28: "USART2",
+}
+
+
+def parse(data):
+    start = data.find(MAGIC)
+    if start < 0:
+        raise ValueError("no trace dump found")
+
+    magic, version, task_num, event_size, count, dropped, now = HEADER.unpack_from(data, start)
+    if version != VERSION:
+        raise ValueError("unsupported dump version {}".format(version))
+
+    pos = start + HEADER.size
+    tasks = {}
+    for _ in range(task_num):
+        number, name = TASK.unpack_from(data, pos)
+        tasks[number] = name.split(b"\0", 1)[0].decode("ascii", "replace")
+        pos += TASK.size
+
+    events = []
+    for _ in range(count):
+        if pos + event_size > len(data):
+            raise ValueError("dump truncated, {} of {} events".format(len(events), count))
+        events.append(struct.unpack_from("<IBBH", data, pos))
+        pos += event_size
+
+    return tasks, events, dropped, now
+
+
+def unwrap(events):
+    """Make timestamps monotonic across 32 bit wraps, relative to first event."""
+    times = []
+    base = 0
+    last = None
+    for time_us, _, _, _ in events:
+        if (last is not None) and (time_us < last):
+            base += 1 << 32
+        last = time_us
+        times.append(base + time_us)
+    first = times[0] if times else 0
+    return [t - first for t in times]
+
+
+def wake_latency(tasks, events):
+    """Time from each notification from interrupt to the task switching in."""
+    notified = {}
+    latency = {}
+    for ts, (_, kind, ident, _) in zip(unwrap(events), events):
+        if kind == NOTIFY_ISR:
+            notified.setdefault(ident, ts)
+        elif (kind == TASK_IN) and (ident in notified):
+            latency.setdefault(ident, []).append(ts - notified.pop(ident))
+    return {tasks.get(k, "task {}".format(k)): v for k, v in latency.items()}
+
+
+def convert(tasks, events, dropped):
+    out = []
+    out.append({"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "firmware"}})
+    out.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": ISR_TID, "args": {"name": "ISR"}})
+    for number, name in sorted(tasks.items()):
+        out.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": number, "args": {"name": name}})
+
+    running = None
+    slice_start = None
+    for ts, (_, kind, ident, arg) in zip(unwrap(events), events):
+        if kind == TASK_IN:
+            running = ident
+            slice_start = ts
+        elif kind == TASK_OUT:
+            if (running == ident) and (slice_start is not None):
+                name = tasks.get(ident, "task {}".format(ident))
+                out.append({"name": name, "ph": "X", "pid": 1, "tid": ident, "ts": slice_start, "dur": ts - slice_start})
+            running = None
+            slice_start = None
+        elif kind == ISR:
+            name = IRQ_NAMES.get(arg, "IRQ {}".format(arg - 16))
+            out.append({"name": name, "ph": "i", "s": "t", "pid": 1, "tid": ISR_TID, "ts": ts})
+        elif kind in (QUEUE_SEND, QUEUE_RECEIVE):
+            name = "send" if kind == QUEUE_SEND else "receive"
+            tid = running if running is not None else ISR_TID
+            out.append({"name": name, "ph": "i", "s": "t", "pid": 1, "tid": tid, "ts": ts,
+                        "args": {"queue": "0x{:04x}".format(arg)}})
+        elif kind == NOTIFY_ISR:
+            out.append({"name": "notify " + tasks.get(ident, str(ident)), "ph": "i", "s": "t", "pid": 1,
+                        "tid": ISR_TID, "ts": ts})
+        elif kind == NOTIFY_WAIT:
+            out.append({"name": "wait", "ph": "i", "s": "t", "pid": 1, "tid": ident, "ts": ts})
+        elif kind == MARK:
+            tid = running if running is not None else ISR_TID
+            out.append({"name": "mark {}".format(ident), "ph": "i", "s": "t", "pid": 1, "tid": tid, "ts": ts,
+                        "args": {"arg": arg}})
+
+    # Close slice of the task running at dump time
+    if (running is not None) and (slice_start is not None) and events:
+        ts = unwrap(events)[-1]
+        out.append({"name": tasks.get(running, "task {}".format(running)), "ph": "X", "pid": 1, "tid": running,
+                    "ts": slice_start, "dur": ts - slice_start})
+
+    return {"traceEvents": out, "displayTimeUnit": "ms", "otherData": {"dropped": dropped}}
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+
+    with open(sys.argv[1], "rb") as f:
+        tasks, events, dropped, _ = parse(f.read())
+
+    trace = convert(tasks, events, dropped)
+    text = json.dumps(trace, indent=1)
+
+    if len(sys.argv) > 2:
+        with open(sys.argv[2], "w") as f:
+            f.write(text)
+    else:
+        print(text)
+
+    sys.stderr.write("{} events, {} dropped, {} tasks\n".format(len(events), dropped, len(tasks)))
+    for name, values in sorted(wake_latency(tasks, events).items()):
+        sys.stderr.write("{} wake us: n {} min {} max {} avg {}\n".format(
+            name, len(values), min(values), max(values), sum(values) // len(values)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -39,10 +39,19 @@ defined in linker script */
 .word _sdata
 /* end address for the .data section. defined in linker script */
 .word _edata
+/* start address for the initialization values of the .ramfunc section.
+defined in linker script */
+.word _siramfunc
+/* start address for the .ramfunc section. defined in linker script */
+.word _sramfunc
+/* end address for the .ramfunc section. defined in linker script */
+.word _eramfunc
 /* start address for the .bss section. defined in linker script */
 .word _sbss
 /* end address for the .bss section. defined in linker script */
 .word _ebss
+/* start address of the main stack. defined in linker script */
+.word _sstack
 
   .section .text.Reset_Handler
   .weak Reset_Handler
@@ -67,6 +76,23 @@ LoopCopyDataInit:
   adds r2, r0, r1
   cmp r2, r3
   bcc CopyDataInit
+
+/* Copy the code executed from RAM */
+  movs r1, #0
+  b LoopCopyRamFunc
+
+CopyRamFunc:
+  ldr r3, =_siramfunc
+  ldr r3, [r3, r1]
+  str r3, [r0, r1]
+  adds r1, r1, #4
+
+LoopCopyRamFunc:
+  ldr r0, =_sramfunc
+  ldr r3, =_eramfunc
+  adds r2, r0, r1
+  cmp r2, r3
+  bcc CopyRamFunc
   ldr r2, =_sbss
   b LoopFillZerobss
 /* Zero fill the bss segment. */
@@ -81,6 +107,19 @@ LoopFillZerobss:
   cmp r2, r3
   bcc FillZerobss
 
+/* Paint the main stack, unused words keep the pattern */
+  ldr r2, =_sstack
+  ldr r3, =0xA5A5A5A5
+  mov r1, sp
+  b LoopPaintStack
+PaintStack:
+  str  r3, [r2]
+  adds r2, r2, #4
+
+LoopPaintStack:
+  cmp r2, r1
+  bcc PaintStack
+
 /* Call the clock system intitialization function.*/
   bl  SystemInit
 /* Call static constructors */